@@ -23,10 +23,25 @@ typedef struct cdc_device_cfg{
 
 // #define MAX_CDC_COUNT   (((USB_SOC_DCD_MAX_ENDPOINT_COUNT) / 2) - 1)
 #define MAX_CDC_COUNT   (4)
+/*!< can_num values a vcom can be bound to with the "r_canN" request, N is one decimal digit */
+#define CDC_CAN_NUM_MAX (10)
 
 
 #define USB_BUS_ID 0
 
+/*!< CAN -> host aggregation: ASCII frames are packed into batches of one HS bulk packet */
+#ifndef CDC_TX_BATCH_SIZE
+#define CDC_TX_BATCH_SIZE       (512U)
+#endif
+/*!< number of batches per channel, one is being filled while the others are queued or in flight */
+#ifndef CDC_TX_BATCH_COUNT
+#define CDC_TX_BATCH_COUNT      (4U)
+#endif
+/*!< a partially filled batch is flushed once its oldest byte is this old */
+#ifndef CDC_TX_FLUSH_TIMEOUT_US
+#define CDC_TX_FLUSH_TIMEOUT_US (200U)
+#endif
+
 /*!< endpoint address */
 #define CDC_IN_EP   0x81
 #define CDC_OUT_EP  0x01
@@ -70,5 +85,14 @@ void cdc_acm_init(uint8_t busid, uint32_t reg_base);
 void usbd_init_line_coding(uint8_t can_num, struct cdc_line_coding *line_coding);
 bool get_usb_out_char(uint8_t can_num, uint8_t *data);
 bool get_usb_out_is_empty(uint8_t can_num);
+uint8_t *usbd_out_linear_read_setup(uint8_t can_num, uint32_t *size);
+void usbd_out_linear_read_done(uint8_t can_num, uint32_t size);
 uint32_t write_usb_data(uint8_t can_num, uint8_t *data, uint32_t len);
+uint8_t *usbd_tx_batch_reserve(uint8_t can_num, uint32_t len);
+void usbd_tx_batch_stamp(uint8_t can_num, uint32_t rx_time_us);
+void usbd_tx_batch_commit(uint8_t can_num, uint32_t len);
+void usbd_tx_batch_poll(uint8_t can_num);
+bool usbd_tx_batch_pending(uint8_t can_num);
+uint32_t usbd_get_tx_drop_frames(uint8_t can_num);
+uint32_t usbd_get_tx_drop_bytes(uint8_t can_num);
 #endif
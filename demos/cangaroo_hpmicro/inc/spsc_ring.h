@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _SPSC_RING_H
+#define _SPSC_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/*
+ * Single-producer/single-consumer lock-free ring of fixed size elements.
+ * The producer only writes head, the consumer only writes tail, so an ISR can
+ * feed the main loop (or the other way round) without masking interrupts.
+ * Elements are accessed in place through the write/read setup and done pairs, in the
+ * same spirit as chry_ringbuffer_linear_write_setup()/_done().
+ * Depends on nothing but the compiler atomics so it also builds on a host.
+ */
+
+#ifndef SPSC_RING_CACHELINE_SIZE
+#define SPSC_RING_CACHELINE_SIZE (64U)
+#endif
+
+typedef struct spsc_ring {
+    uint8_t *pool;
+    uint32_t elem_size;
+    uint32_t mask;
+    /* producer index, padded so it never shares a cache line with tail */
+    uint32_t head __attribute__((aligned(SPSC_RING_CACHELINE_SIZE)));
+    /* consumer index */
+    uint32_t tail __attribute__((aligned(SPSC_RING_CACHELINE_SIZE)));
+} spsc_ring_t;
+
+/**
+ * @brief       initialize one ring
+ * @param[in]   ring      : ring instance
+ * @param[in]   pool      : storage for depth * elem_size bytes
+ * @param[in]   elem_size : size of one element in bytes
+ * @param[in]   depth     : number of elements, must be a power of two
+ * @return      0 on success, -1 if depth is not a power of two
+ */
+static inline int spsc_ring_init(spsc_ring_t *ring, void *pool, uint32_t elem_size, uint32_t depth)
+{
+    if ((depth == 0) || ((depth & (depth - 1)) != 0)) {
+        return -1;
+    }
+    ring->pool = (uint8_t *)pool;
+    ring->elem_size = elem_size;
+    ring->mask = depth - 1;
+    __atomic_store_n(&ring->head, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->tail, 0, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static inline uint32_t spsc_ring_get_size(spsc_ring_t *ring)
+{
+    return ring->mask + 1;
+}
+
+static inline uint32_t spsc_ring_get_used(spsc_ring_t *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+static inline bool spsc_ring_check_empty(spsc_ring_t *ring)
+{
+    return spsc_ring_get_used(ring) == 0;
+}
+
+/**
+ * @brief       producer side, get the next free element
+ * @return      element to fill in place, NULL if the ring is full
+ */
+static inline void *spsc_ring_write_setup(spsc_ring_t *ring)
+{
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    if ((head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) > ring->mask) {
+        return NULL;
+    }
+    return ring->pool + (head & ring->mask) * ring->elem_size;
+}
+
+/**
+ * @brief       producer side, publish the element returned by spsc_ring_write_setup()
+ */
+static inline void spsc_ring_write_done(spsc_ring_t *ring)
+{
+    __atomic_store_n(&ring->head, __atomic_load_n(&ring->head, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief       consumer side, get the oldest element
+ * @return      element to read in place, NULL if the ring is empty
+ */
+static inline void *spsc_ring_read_setup(spsc_ring_t *ring)
+{
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    return ring->pool + (tail & ring->mask) * ring->elem_size;
+}
+
+/**
+ * @brief       consumer side, release the element returned by spsc_ring_read_setup()
+ */
+static inline void spsc_ring_read_done(spsc_ring_t *ring)
+{
+    __atomic_store_n(&ring->tail, __atomic_load_n(&ring->tail, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE);
+}
+
+static inline bool spsc_ring_write(spsc_ring_t *ring, const void *elem)
+{
+    void *slot = spsc_ring_write_setup(ring);
+    if (slot == NULL) {
+        return false;
+    }
+    memcpy(slot, elem, ring->elem_size);
+    spsc_ring_write_done(ring);
+    return true;
+}
+
+static inline bool spsc_ring_read(spsc_ring_t *ring, void *elem)
+{
+    void *slot = spsc_ring_read_setup(ring);
+    if (slot == NULL) {
+        return false;
+    }
+    memcpy(elem, slot, ring->elem_size);
+    spsc_ring_read_done(ring);
+    return true;
+}
+
+#endif /* _SPSC_RING_H */
@@ -7,40 +7,107 @@
 
 #include "mcan.h"
 #include "pinmux.h"
+#include "slcan_event.h"
+#include "slcan_stats.h"
+#include "hpm_interrupt.h"
+#include "hpm_csr_drv.h"
+#include "hpm_clock_drv.h"
 
-mcan_rx_message_t    g_mcan_rx_frame[CANFD_NUM][MCAN_RXBUF_SIZE_CAN_DEFAULT];
+mcan_rx_queue_t      g_mcan_rx_queue[CANFD_NUM];
+mcan_tx_queue_t      g_mcan_tx_queue[CANFD_NUM];
 mcan_tx_frame_t      g_mcan_tx_frame[CANFD_NUM];
-volatile uint8_t     g_mcan_rx_fifo_complete_flag[CANFD_NUM][MCAN_RXBUF_SIZE_CAN_DEFAULT];
 struct slcan_t slcan0, slcan1, slcan2, slcan3;
 
+static mcan_rx_frame_t g_mcan_rx_pool[CANFD_NUM][MCAN_RX_RING_DEPTH];
+static mcan_tx_frame_t g_mcan_tx_pool[CANFD_NUM][MCAN_TX_RING_DEPTH];
+static struct slcan_t *const g_mcan_slcan[CANFD_NUM] = { &slcan0, &slcan1, &slcan2, &slcan3 };
+
+/*
+ * move every pending frame of one RX FIFO into the channel ring. A frame the full ring drops
+ * is still read and counted towards the bus load.
+ */
+static void mcan_rx_drain_fifo(MCAN_Type *base, uint8_t channel, mcan_rx_queue_t *queue, uint32_t fifo_index,
+                               uint64_t rx_cycle)
+{
+    mcan_rx_message_t discard;
+    mcan_rx_frame_t *slot;
+    mcan_rx_message_t *msg;
+
+    while (1) {
+        slot = (mcan_rx_frame_t *)spsc_ring_write_setup(&queue->ring);
+        msg = (slot != NULL) ? &slot->msg : &discard;
+        if (mcan_read_rxfifo(base, fifo_index, msg) != status_success) {
+            break;
+        }
+        slcan_stats_isr_rx(channel, msg);
+        if (slot != NULL) {
+            slot->rx_cycle = rx_cycle;
+            spsc_ring_write_done(&queue->ring);
+        } else {
+            queue->overflow++;
+        }
+    }
+}
+
+/* move queued frames into the hardware TX FIFO until it is full, caller owns the ring consumer side */
+static void mcan_tx_fill_fifo(MCAN_Type *base, mcan_tx_queue_t *queue)
+{
+    mcan_tx_frame_t *frame;
+    uint32_t fifo_index;
+
+    while ((frame = (mcan_tx_frame_t *)spsc_ring_read_setup(&queue->ring)) != NULL) {
+        if (mcan_transmit_via_txfifo_nonblocking(base, frame, &fifo_index) != status_success) {
+            break;
+        }
+        spsc_ring_read_done(&queue->ring);
+    }
+}
+
 void mcan_isr(struct slcan_t *slcan_port)
 {
+    /*
+     * Sampled first, the stamp of every frame this call drains: it trails the arrival of
+     * frames that waited in the FIFO by the interrupt latency, see the Z2 notes in slcan.h
+     */
+    uint64_t rx_cycle = hpm_csr_get_core_cycle();
     MCAN_Type *base = slcan_port->ptr;
+    mcan_rx_queue_t *queue = &g_mcan_rx_queue[slcan_port->candev_sn];
+    mcan_rx_message_t discard;
+    mcan_rx_frame_t *slot;
     uint32_t flags = mcan_get_interrupt_flags(base);
 
     /* New message is available in RXFIFO0 */
     if ((flags & MCAN_INT_RXFIFO0_NEW_MSG) != 0) {
-        mcan_read_rxfifo(base, 0, (mcan_rx_message_t *)&g_mcan_rx_frame[slcan_port->candev_sn][0]);
-        g_mcan_rx_fifo_complete_flag[slcan_port->candev_sn][0] = true;
+        mcan_rx_drain_fifo(base, slcan_port->candev_sn, queue, 0, rx_cycle);
     }
     /* New message is available in RXFIFO1 */
     if ((flags & MCAN_INT_RXFIFO1_NEW_MSG) != 0U) {
-        mcan_read_rxfifo(base, 1, (mcan_rx_message_t *) &g_mcan_rx_frame[slcan_port->candev_sn][1]);
-        g_mcan_rx_fifo_complete_flag[slcan_port->candev_sn][1] = true;
+        mcan_rx_drain_fifo(base, slcan_port->candev_sn, queue, 1, rx_cycle);
     }
     /* New message is available in RXBUF */
     if ((flags & MCAN_INT_MSG_STORE_TO_RXBUF) != 0U) {
-        /* NOTE: Below code is for demonstration purpose, the performance is not optimized
-         *       Users should optimize the performance according to real use case.
-         */
         for (uint32_t buf_index = 0; buf_index < MCAN_RXBUF_SIZE_CAN_DEFAULT; buf_index++) {
             if (mcan_is_rxbuf_data_available(base, buf_index)) {
-                g_mcan_rx_fifo_complete_flag[slcan_port->candev_sn][buf_index] = true;
-                mcan_read_rxbuf(base, buf_index, (mcan_rx_message_t *)&g_mcan_rx_frame[slcan_port->candev_sn][buf_index]);
+                slot = (mcan_rx_frame_t *)spsc_ring_write_setup(&queue->ring);
+                mcan_read_rxbuf(base, buf_index, (slot != NULL) ? &slot->msg : &discard);
+                slcan_stats_isr_rx(slcan_port->candev_sn, (slot != NULL) ? &slot->msg : &discard);
+                if (slot != NULL) {
+                    slot->rx_cycle = rx_cycle;
+                    spsc_ring_write_done(&queue->ring);
+                } else {
+                    queue->overflow++;
+                }
                 mcan_clear_rxbuf_data_available_flag(base, buf_index);
             }
         }
     }
+    if ((flags & MCAN_EVENT_RECEIVE) != 0U) {
+        slcan_event_set(slcan_port->candev_sn);
+    }
+    /* a TX FIFO slot was freed, top it up from the software queue */
+    if ((flags & (MCAN_INT_TX_COMPLETED | MCAN_INT_TXFIFO_EMPTY)) != 0U) {
+        mcan_tx_fill_fifo(base, &g_mcan_tx_queue[slcan_port->candev_sn]);
+    }
     mcan_clear_interrupt_flags(base, flags);
 }
 
@@ -69,8 +136,100 @@ void mcan3_isr(void)
 SDK_DECLARE_EXT_ISR_M(IRQn_MCAN3, mcan3_isr);
 void mcan_channel_init(uint8_t can_num)
 {
-    g_mcan_rx_fifo_complete_flag[can_num][0] = false;
-    g_mcan_rx_fifo_complete_flag[can_num][1] = false;
+    spsc_ring_init(&g_mcan_rx_queue[can_num].ring, g_mcan_rx_pool[can_num], sizeof(mcan_rx_frame_t), MCAN_RX_RING_DEPTH);
+    g_mcan_rx_queue[can_num].overflow = 0;
+    spsc_ring_init(&g_mcan_tx_queue[can_num].ring, g_mcan_tx_pool[can_num], sizeof(mcan_tx_frame_t), MCAN_TX_RING_DEPTH);
+    g_mcan_tx_queue[can_num].high_water = 0;
+    g_mcan_tx_queue[can_num].full = 0;
+}
+
+uint32_t mcan_get_rx_overflow(uint8_t can_num)
+{
+    return g_mcan_rx_queue[can_num].overflow;
+}
+
+/**
+ * @brief       convert a core cycle stamp to the free running microsecond timestamp
+ * @return      microseconds since reset, wraps at 2^32
+ */
+uint32_t mcan_cycle_to_us(uint64_t cycle)
+{
+    uint32_t ticks_per_us = (hpm_core_clock + 1000000 - 1U) / 1000000;
+    return (uint32_t)(cycle / ticks_per_us);
+}
+
+/**
+ * @brief       queue one frame for transmission without waiting for the bus
+ * @return      false if the queue is full, the host should be told to back off
+ */
+bool mcan_tx_enqueue(uint8_t can_num, const mcan_tx_frame_t *frame)
+{
+    mcan_tx_queue_t *queue = &g_mcan_tx_queue[can_num];
+    uint32_t used;
+
+    if (spsc_ring_write(&queue->ring, frame) == false) {
+        queue->full++;
+        return false;
+    }
+    used = spsc_ring_get_used(&queue->ring);
+    if (used > queue->high_water) {
+        queue->high_water = used;
+    }
+    return true;
+}
+
+/**
+ * @brief       push queued frames into the TX FIFO from thread context
+ * @details     the ISR refills the FIFO on TX completion, this only starts an idle channel
+ */
+void mcan_tx_kick(uint8_t can_num)
+{
+    uint32_t level = disable_global_irq(CSR_MSTATUS_MIE_MASK);
+    mcan_tx_fill_fifo(g_mcan_slcan[can_num]->ptr, &g_mcan_tx_queue[can_num]);
+    restore_global_irq(level);
+}
+
+/**
+ * @brief       drop every frame still waiting in the software queue
+ */
+void mcan_tx_flush(uint8_t can_num)
+{
+    uint32_t level = disable_global_irq(CSR_MSTATUS_MIE_MASK);
+    while (spsc_ring_read_setup(&g_mcan_tx_queue[can_num].ring) != NULL) {
+        spsc_ring_read_done(&g_mcan_tx_queue[can_num].ring);
+    }
+    restore_global_irq(level);
+}
+
+/**
+ * @brief       write one frame straight into the TX FIFO, bypassing the software queue
+ * @return      false if the FIFO is full
+ * @details     for interrupt context (replay), frames already queued may be sent after it.
+ *              Masked, the caller may preempt mcan_tx_fill_fifo() in mcan_isr.
+ */
+bool mcan_tx_send_now(uint8_t can_num, const mcan_tx_frame_t *frame)
+{
+    uint32_t fifo_index;
+    uint32_t level = disable_global_irq(CSR_MSTATUS_MIE_MASK);
+    bool sent = mcan_transmit_via_txfifo_nonblocking(g_mcan_slcan[can_num]->ptr, frame, &fifo_index) == status_success;
+    restore_global_irq(level);
+    return sent;
+}
+
+bool mcan_tx_is_full(uint8_t can_num)
+{
+    spsc_ring_t *ring = &g_mcan_tx_queue[can_num].ring;
+    return spsc_ring_get_used(ring) >= spsc_ring_get_size(ring);
+}
+
+uint32_t mcan_tx_get_high_water(uint8_t can_num)
+{
+    return g_mcan_tx_queue[can_num].high_water;
+}
+
+uint32_t mcan_tx_get_full_count(uint8_t can_num)
+{
+    return g_mcan_tx_queue[can_num].full;
 }
 
 void mcan_pinmux_init(uint8_t can_num)
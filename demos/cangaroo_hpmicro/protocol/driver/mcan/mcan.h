@@ -9,13 +9,52 @@
 #define __MCAN_H__
 #include "hpm_mcan_drv.h"
 #include "slcan.h"
+#include "spsc_ring.h"
 #define CANFD_NUM           (4U)
 
-extern mcan_rx_message_t    g_mcan_rx_frame[CANFD_NUM][MCAN_RXBUF_SIZE_CAN_DEFAULT];
+/* received frames queued per channel between mcan_isr() and slcan_process_can(), power of two */
+#ifndef MCAN_RX_RING_DEPTH
+#define MCAN_RX_RING_DEPTH  (64U)
+#endif
+
+/* one queued received frame */
+typedef struct {
+    mcan_rx_message_t msg;
+    uint64_t rx_cycle;          /* core cycle counter on entry to mcan_isr(), shared by every frame it drains */
+} mcan_rx_frame_t;
+
+typedef struct {
+    spsc_ring_t ring;           /* producer: mcan_isr(), consumer: main loop */
+    volatile uint32_t overflow; /* frames dropped because the ring was full */
+} mcan_rx_queue_t;
+
+/* frames queued per channel between slcan_can_write() and the MCAN TX FIFO, power of two */
+#ifndef MCAN_TX_RING_DEPTH
+#define MCAN_TX_RING_DEPTH  (32U)
+#endif
+
+typedef struct {
+    spsc_ring_t ring;             /* producer: main loop, consumer: mcan_tx_kick()/mcan_isr() */
+    volatile uint32_t high_water; /* deepest the ring has been since init */
+    volatile uint32_t full;       /* frames refused because the ring was full */
+} mcan_tx_queue_t;
+
+extern mcan_rx_queue_t      g_mcan_rx_queue[CANFD_NUM];
+extern mcan_tx_queue_t      g_mcan_tx_queue[CANFD_NUM];
 extern mcan_tx_frame_t      g_mcan_tx_frame[CANFD_NUM];
-extern volatile uint8_t     g_mcan_rx_fifo_complete_flag[CANFD_NUM][MCAN_RXBUF_SIZE_CAN_DEFAULT];
 extern struct slcan_t slcan0, slcan1, slcan2, slcan3;
 
+/* interrupt body shared by the four MCAN vectors, also the entry point for injecting traffic off target */
+void mcan_isr(struct slcan_t *slcan_port);
 void mcan_channel_init(uint8_t can_num);
 void mcan_pinmux_init(uint8_t can_num);
+uint32_t mcan_get_rx_overflow(uint8_t can_num);
+uint32_t mcan_cycle_to_us(uint64_t cycle);
+bool mcan_tx_enqueue(uint8_t can_num, const mcan_tx_frame_t *frame);
+void mcan_tx_kick(uint8_t can_num);
+void mcan_tx_flush(uint8_t can_num);
+bool mcan_tx_send_now(uint8_t can_num, const mcan_tx_frame_t *frame);
+bool mcan_tx_is_full(uint8_t can_num);
+uint32_t mcan_tx_get_high_water(uint8_t can_num);
+uint32_t mcan_tx_get_full_count(uint8_t can_num);
 #endif
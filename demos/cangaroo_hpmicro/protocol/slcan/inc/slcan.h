@@ -2,10 +2,13 @@
 #define _SLCAN_H
 
 #include "stdint.h"
+#include "stdbool.h"
 #include "stdio.h"
 #include "string.h"
 
 #include "hpm_mcan_drv.h"
+#include "slcan_filter.h"
+#include "slcan_bittiming.h"
 
 /*---------------------------------------------------------------------------------------------------------*/
 /* Define
@@ -22,15 +25,26 @@
 /* maximum rx buffer len: extended CAN frame with timestamp */
 // #define SLCAN_MTU (sizeof("T1111222281122334455667788EA5F\r")+1)  //CAN2.0
 #define SLCAN_MTU (sizeof("B12345678FEA5F\r") + 1 + 64 * 2) // CANFD
+/* longest command: replay append "GA" + channel + 8 digit delay + extended CANFD frame + '\r' */
+#define SLCAN_RX_MTU (2 + 1 + 8 + sizeof("B12345678F") - 1 + 64 * 2 + 1)
 
 /*
-If the Time Stamp is ON,
+Z1: If the Time Stamp is ON,
 the incomming frames looks like this.t100211334D67[CR](a standard frame with
 1D=0x100 & 2 bytes)Note the last 4 bytes 0x4D67, which is a Time Stamp for
 thisspecific message in milliseconds (and of course in hex). The timerin the
 CAN232 starts at zero 0x0000 and goes up to 0xEA5F beforeit loop arround and
 get's back to 0x0000. This corresponds to exact60,000mS (i.e.1 minute which will
 be more than enough in mostsystems).
+Z2: extended resolution, the last 8 bytes are a free running microsecond
+timestamp in hex that wraps at 0xFFFFFFFF.
+Both are taken from the core cycle counter on entry to the receive interrupt
+(mcan_isr()), not from the MCAN timestamp of the frame. Every frame one
+interrupt drains from the RX FIFOs gets the same stamp: frames that queued up
+while the interrupt was held off (masked interrupts, a higher priority handler)
+are stamped late by that delay, frames stored while the FIFO is drained early.
+The error is the interrupt latency plus the drain time, not the bridge load of
+the main loop, which mcan_isr() preempts.
 */
 
 /* RUN FLAG */
@@ -43,6 +57,11 @@ be more than enough in mostsystems).
 #define SLCAN_SFLAG_BUADRATE 0x0002
 #define SLCAN_SFLAG_TIMESTAMP 0x0004
 #define SLCAN_SFLAG_LOG 0x0008
+#define SLCAN_SFLAG_TIMESTAMP_US 0x0010
+
+/* BIT TIMING, phases set with K instead of the S/Y rate tables */
+#define SLCAN_BT_CUSTOM_NOMINAL 0x01
+#define SLCAN_BT_CUSTOM_DATA 0x02
 
 /* UART Config Parameters */
 typedef struct {
@@ -59,6 +78,10 @@ struct slcan_t {
     uint8_t candev_sn;        // CAN operating channel
     mcan_config_t candev_cfg; // CAN configuration information
     int candev_oflag;       // candev open flag
+    slcan_filter_t filter;    // acceptance rules written to MCAN on open
+    uint8_t bt_custom;        // SLCAN_BT_CUSTOM_xxx
+    slcan_bt_timing_t nominal_bt; // nominal phase timing, solved by K or on open
+    slcan_bt_timing_t data_bt;    // data phase timing, solved by K or on open
 
     uint8_t uartdev_sn;     // uart operating channel
     UART_CFG_T uartdev_cfg; // uart configuration information
@@ -69,15 +92,17 @@ struct slcan_t {
     uint16_t set_flag;
     uint8_t timestamp_isopen;
     uint8_t candev_isopen;
+    uint8_t frame_mode;       // enum slcan_frame_mode, format of frames sent to the host
 
     mcan_tx_frame_t   can_tx_msg; // can TX message
     mcan_rx_message_t can_rx_msg; // can RX message
+    uint32_t can_rx_time_us;      // receive interrupt time of can_rx_msg, microseconds
 
     uint8_t uart_rx_len;
+    uint8_t uart_rx_discard;           // overlong line, drop bytes up to the next '\r' and reply BELL
     uint8_t uart_tx_len;
-    uint8_t uart_rx_buffer[SLCAN_MTU]; // uart RX message
+    uint8_t uart_rx_buffer[SLCAN_RX_MTU]; // uart RX message
     uint8_t uart_tx_buffer[SLCAN_MTU]; // uart TX message
-    uint32_t timestamp;
 };
 
 enum slcan_uart_status {
@@ -88,6 +113,11 @@ enum slcan_uart_status {
     SLCAN_UART_SEND,
 };
 
+enum slcan_frame_mode {
+    SLCAN_FRAME_ASCII = 0, // classic slcan lines, default
+    SLCAN_FRAME_BINARY,    // slcan_bin.h records
+};
+
 enum slcan_baud {
     SLCAN_BAUD_10K = 0,
     SLCAN_BAUD_20K,
@@ -123,17 +153,18 @@ void slcan_can_set_nbaud(struct slcan_t *slcan_port,
                          uint8_t baud_index); // set normal baud rate
 void slcan_can_set_dbaud(struct slcan_t *slcan_port,
                          uint8_t data_mbps); // set data baud rate
+// set any nominal or data rate and sample point through the bit timing solver
+bool slcan_can_set_timing(struct slcan_t *slcan_port, bool data_phase, uint32_t bitrate, uint16_t sample_point);
 
-// read one message in sclan from canfd buffer
-uint32_t slcan_can_read(struct slcan_t *slcan_port, uint8_t fifo_num);
+// read one message in sclan from the canfd rx queue
+uint32_t slcan_can_read(struct slcan_t *slcan_port);
 // write one message to TX fifo  from canfd buffer  & send out
 uint32_t slcan_can_write(struct slcan_t *slcan_port);
 
-// read one message in sclan from uart
-// return -1 : no data
-// return 0 	: only 1 valid data
-// return 1 	: There's still data left to process
-int32_t slcan_uart_read(struct slcan_t *slcan_port);
+// feed bytes from uart to the resumable command parser, never waits for the rest of a line
+void slcan_uart_feed(struct slcan_t *slcan_port, const uint8_t *data, uint32_t len);
+// decode one command ending with '\r', len includes the '\r'
+void slcan_parse_ascii(struct slcan_t *slcan_port, const uint8_t *buf, uint32_t len);
 // write one message to uart
 uint32_t slcan_uart_write(struct slcan_t *slcan_port, void *buffer,
                           uint32_t size);
@@ -143,6 +174,8 @@ void slcan_process_uart(struct slcan_t *slcan_port);
 void slcan_process_can(struct slcan_t *slcan_port);
 // uart & can process both in
 void slcan_process_task(struct slcan_t *slcan_port);
+// service the channels flagged in g_slcan_ready_mask, false if there was nothing to do
+bool slcan_process_ready(void);
 
 // slcan instance initialization
 void slcan_init(void);
@@ -150,7 +183,6 @@ void slcan_port0_init(void);
 void slcan_port1_init(void);
 void slcan_port2_init(void);
 void slcan_port3_init(void);
-void slcan_timestamp(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _SLCAN_ASCII_H
+#define _SLCAN_ASCII_H
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "hpm_mcan_drv.h"
+#include "slcan_dlc.h"
+
+/*
+ * Table driven SLCAN ASCII encoder/decoder.
+ * No libc formatting is used, every hex digit comes from a lookup table and
+ * every field has a fixed width, so the frame length is known before encoding.
+ */
+
+/* longest frame: "B" + 8 id + dlc + 64 * 2 data + 8 timestamp + '\r' */
+#define SLCAN_ASCII_FRAME_MAX (1 + 8 + 1 + 64 * 2 + 8 + 1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief       length of the ascii form of one can message
+ * @param[in]   msg           : received can message
+ * @param[in]   ts_digits     : timestamp hex digits to append, 0 for none, 4 (ms) or 8 (us)
+ * @return      exact number of bytes slcan_ascii_encode_frame() will write
+ */
+uint32_t slcan_ascii_frame_len(const mcan_rx_message_t *msg, uint8_t ts_digits);
+
+/**
+ * @brief       encode one can message as SLCAN ascii, terminated by '\r'
+ * @param[out]  dst           : room for slcan_ascii_frame_len() bytes
+ * @param[in]   msg           : received can message
+ * @param[in]   ts_digits     : timestamp hex digits to append, 0 for none, 4 (ms) or 8 (us)
+ * @param[in]   timestamp     : timestamp value
+ * @return      number of bytes written, no terminating zero is appended
+ */
+uint32_t slcan_ascii_encode_frame(uint8_t *dst, const mcan_rx_message_t *msg, uint8_t ts_digits, uint32_t timestamp);
+
+/**
+ * @brief       write value as a fixed number of upper case hex digits
+ * @param[out]  dst    : destination, digits bytes are written
+ * @param[in]   value  : value to encode
+ * @param[in]   digits : number of hex digits, 1 ~ 8
+ * @return      dst advanced past the written digits
+ */
+uint8_t *slcan_ascii_put_hex(uint8_t *dst, uint32_t value, uint8_t digits);
+
+/**
+ * @brief       decode a fixed number of hex digits, upper or lower case
+ * @param[in]   src    : ascii digits
+ * @param[in]   digits : number of hex digits, 1 ~ 8
+ * @param[out]  value  : decoded value
+ * @return      true if every digit was a valid hex digit
+ */
+bool slcan_ascii_get_hex(const uint8_t *src, uint8_t digits, uint32_t *value);
+
+/**
+ * @brief       decode len data bytes from 2 * len hex digits
+ * @return      true if every digit was a valid hex digit
+ */
+bool slcan_ascii_get_bytes(const uint8_t *src, uint8_t *data, uint32_t len);
+
+/**
+ * @brief       decode one SLCAN ascii frame (t/T/d/D/b/B/r/R syntax) into a tx frame
+ * @param[in]   src   : frame text starting at the type character
+ * @param[in]   len   : bytes available at src
+ * @param[out]  frame : decoded frame
+ * @return      number of bytes the frame text used, 0 if it is malformed or truncated
+ */
+uint32_t slcan_ascii_decode_frame(const uint8_t *src, uint32_t len, mcan_tx_frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SLCAN_ASCII_H */
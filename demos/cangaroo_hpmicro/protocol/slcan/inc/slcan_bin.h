@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _SLCAN_BIN_H
+#define _SLCAN_BIN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Compact binary framing for received can frames, an alternative to the
+ * SLCAN ascii lines. The host switches a channel with "H1\r" and back with
+ * "H0\r"; commands from the host always stay ascii and so do replies.
+ *
+ * One record, little endian:
+ *   [0]      sync  SLCAN_BIN_SYNC
+ *   [1]      flags SLCAN_BIN_FLAG_*
+ *   [2]      dlc   dlc code 0 ~ 15
+ *   [3]      channel
+ *   [4..7]   id    11bit or 29bit
+ *   [8..11]  timestamp in microseconds, free running, wraps at 2^32
+ *   [12..]   data, size given by dlc, absent for remote frames
+ *   [n..n+1] crc16 ccitt (poly 0x1021, init 0xFFFF) over all previous bytes
+ *
+ * The sync byte is not valid ascii, so replies and records can share the
+ * same stream: a host reads ascii up to '\r' and a record when it sees the
+ * sync byte. Records are packed back to back into the usb tx batch.
+ *
+ * This file depends on nothing but the C library so the same code, with
+ * slcan_dlc.c, is the host side encoder/decoder.
+ */
+
+#define SLCAN_BIN_SYNC         (0xA5U)
+
+#define SLCAN_BIN_FLAG_EXT     (0x01U)
+#define SLCAN_BIN_FLAG_RTR     (0x02U)
+#define SLCAN_BIN_FLAG_FD      (0x04U)
+#define SLCAN_BIN_FLAG_BRS     (0x08U)
+#define SLCAN_BIN_FLAG_MASK    (0x0FU)
+
+#define SLCAN_BIN_HEADER_SIZE  (12U)
+#define SLCAN_BIN_CRC_SIZE     (2U)
+#define SLCAN_BIN_FRAME_MAX    (SLCAN_BIN_HEADER_SIZE + 64U + SLCAN_BIN_CRC_SIZE)
+
+typedef struct {
+    uint8_t flags;
+    uint8_t dlc;
+    uint8_t channel;
+    uint32_t id;
+    uint32_t timestamp_us;
+} slcan_bin_header_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief       crc16 ccitt, table driven
+ * @param[in]   crc : 0xFFFF to start, or the result of the previous call
+ * @param[in]   buf : data
+ * @param[in]   len : data length
+ * @return      updated crc
+ */
+uint16_t slcan_bin_crc16(uint16_t crc, const uint8_t *buf, uint32_t len);
+
+/**
+ * @brief       number of data bytes carried by a record
+ */
+uint32_t slcan_bin_data_size(const slcan_bin_header_t *hdr);
+
+/**
+ * @brief       size of the whole record, header and crc included
+ */
+uint32_t slcan_bin_frame_len(const slcan_bin_header_t *hdr);
+
+/**
+ * @brief       encode one record
+ * @param[out]  dst  : room for slcan_bin_frame_len() bytes
+ * @param[in]   hdr  : record header
+ * @param[in]   data : slcan_bin_data_size() payload bytes, unused for remote frames
+ * @return      number of bytes written
+ */
+uint32_t slcan_bin_encode(uint8_t *dst, const slcan_bin_header_t *hdr, const uint8_t *data);
+
+/**
+ * @brief       decode one record from the head of a byte stream
+ * @param[in]   src  : stream bytes, src[0] is expected to be the sync byte
+ * @param[in]   len  : number of valid bytes at src
+ * @param[out]  hdr  : decoded header
+ * @param[out]  data : room for 64 payload bytes
+ * @return      > 0  : record size, consume that many bytes
+ *              0    : record incomplete, wait for more bytes
+ *              -1   : no sync, bad dlc/flags or crc mismatch, drop one byte and retry
+ */
+int32_t slcan_bin_decode(const uint8_t *src, uint32_t len, slcan_bin_header_t *hdr, uint8_t *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SLCAN_BIN_H */
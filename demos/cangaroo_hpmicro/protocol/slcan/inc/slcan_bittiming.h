@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _SLCAN_BITTIMING_H
+#define _SLCAN_BITTIMING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * CAN / CAN-FD bit timing solver for arbitrary rates.
+ * Searches every prescaler for the time quanta split closest to the requested
+ * rate and sample point, no SDK dependency so it also builds on a host.
+ *
+ * seg1 counts the time quanta before the sample point with the sync segment
+ * included, seg2 the ones after it: bit time = seg1 + seg2 quanta,
+ * sample point = seg1 / (seg1 + seg2). This is the num_seg1 / num_seg2
+ * convention of mcan_bit_timing_param_t.
+ */
+
+/* worst rate error accepted, parts per million */
+#ifndef SLCAN_BT_MAX_ERROR_PPM
+#define SLCAN_BT_MAX_ERROR_PPM  (5000U)
+#endif
+
+/* default sample points, permille */
+#define SLCAN_BT_NOMINAL_SP     (875U)
+#define SLCAN_BT_DATA_SP        (750U)
+
+/* transceiver delay compensation is used from this data rate up */
+#define SLCAN_BT_TDC_MIN_RATE   (1000000UL)
+
+typedef struct {
+    uint16_t prescaler_min;
+    uint16_t prescaler_max;
+    uint16_t seg1_min;
+    uint16_t seg1_max;
+    uint16_t seg2_min;
+    uint16_t seg2_max;
+    uint16_t sjw_max;
+    uint16_t tdco_max;      /* secondary sample point offset limit, 0 without TDC */
+} slcan_bt_limits_t;
+
+typedef struct {
+    uint16_t prescaler;
+    uint16_t seg1;
+    uint16_t seg2;
+    uint16_t sjw;
+    uint32_t bitrate;       /* achieved rate */
+    uint16_t sample_point;  /* achieved sample point, permille */
+    bool tdc_enable;
+    uint8_t tdc_offset;     /* secondary sample point, in clock periods from the bit start */
+} slcan_bt_timing_t;
+
+/* MCAN nominal (NBTP) and data (DBTP/TDCR) phase limits */
+extern const slcan_bt_limits_t slcan_bt_mcan_nominal;
+extern const slcan_bt_limits_t slcan_bt_mcan_data;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief       find the bit timing closest to a requested rate and sample point
+ * @param[in]   clock_hz     : CAN source clock, as returned by board_init_can_clock()
+ * @param[in]   bitrate      : requested rate in bit/s
+ * @param[in]   sample_point : requested sample point in permille, 0 for the phase default
+ * @param[in]   data_phase   : true for the CAN-FD data phase, also computes the TDC offset
+ * @param[in]   limits       : controller register ranges
+ * @param[out]  timing       : best combination
+ * @return      false if no combination is within SLCAN_BT_MAX_ERROR_PPM of bitrate
+ * @details     the rate error is minimised first, then the sample point error, ties go to the
+                smaller prescaler (more quanta per bit, finer resynchronisation)
+ */
+bool slcan_bt_solve(uint32_t clock_hz, uint32_t bitrate, uint16_t sample_point, bool data_phase,
+                    const slcan_bt_limits_t *limits, slcan_bt_timing_t *timing);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SLCAN_BITTIMING_H */
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _SLCAN_DLC_H
+#define _SLCAN_DLC_H
+
+#include <stdint.h>
+
+/*
+ * Payload bytes of a can / can fd dlc code, shared by the ascii and binary
+ * framing and the statistics. Depends on nothing but the C library, as
+ * slcan_bin.c does.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const uint8_t slcan_dlc_to_size[16];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
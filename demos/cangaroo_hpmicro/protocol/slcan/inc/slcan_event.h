@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _SLCAN_EVENT_H
+#define _SLCAN_EVENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Per-channel ready bits for the slcan scheduler.
+ * Interrupt handlers (USB OUT completion, MCAN RX) set the bit of the channel
+ * that got work, the main loop takes the whole mask at once and only services
+ * the flagged channels. Bit n belongs to slcan channel n, channels past the
+ * mask width are ignored.
+ */
+
+extern volatile uint32_t g_slcan_ready_mask;
+
+static inline void slcan_event_set(uint8_t channel)
+{
+    if (channel >= 32) {
+        return;
+    }
+    __atomic_fetch_or(&g_slcan_ready_mask, 1UL << channel, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t slcan_event_take(void)
+{
+    return __atomic_exchange_n(&g_slcan_ready_mask, 0, __ATOMIC_ACQUIRE);
+}
+
+static inline bool slcan_event_pending(void)
+{
+    return __atomic_load_n(&g_slcan_ready_mask, __ATOMIC_RELAXED) != 0;
+}
+
+#endif /* _SLCAN_EVENT_H */
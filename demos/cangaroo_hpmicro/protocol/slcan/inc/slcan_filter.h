@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _SLCAN_FILTER_H
+#define _SLCAN_FILTER_H
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "hpm_mcan_drv.h"
+
+/*
+ * Hardware acceptance filtering for one slcan channel.
+ * The rules are kept as MCAN classic filter elements and written into the
+ * message RAM by mcan_init() when the channel is opened, so rejected frames
+ * never raise an interrupt.
+ *
+ * Two ways to fill the rules, they never combine:
+ *  - m/M: SJA1000 style 32bit acceptance code and mask (mask bit 1 = don't care),
+ *         code[31:21] is the standard id, code[31:3] the extended id.
+ *         Each m/M replaces every rule, J rules included.
+ *  - J  : explicit standard/extended id + mask rules, mask bit 1 = must match.
+ *         Rules add up slot by slot; the first J after an m/M drops the
+ *         rules the code/mask pair made before storing its own.
+ * With no rule every frame is accepted, with any rule only matching frames are.
+ */
+
+#ifndef SLCAN_FILTER_STD_MAX
+#define SLCAN_FILTER_STD_MAX (16U)
+#endif
+#ifndef SLCAN_FILTER_EXT_MAX
+#define SLCAN_FILTER_EXT_MAX (16U)
+#endif
+
+typedef struct {
+    uint32_t acc_code;
+    uint32_t acc_mask;
+    bool acc_rules;    /* rules were made by m/M, the next J starts over */
+    uint8_t std_count; /* highest used standard element + 1 */
+    uint8_t ext_count; /* highest used extended element + 1 */
+    mcan_filter_elem_t std_elem[SLCAN_FILTER_STD_MAX];
+    mcan_filter_elem_t ext_elem[SLCAN_FILTER_EXT_MAX];
+} slcan_filter_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief       drop every rule, accept all frames
+ */
+void slcan_filter_reset(slcan_filter_t *filter);
+
+/**
+ * @brief       set the SJA1000 style acceptance code (m command)
+ */
+void slcan_filter_set_code(slcan_filter_t *filter, uint32_t code);
+
+/**
+ * @brief       set the SJA1000 style acceptance mask (M command)
+ */
+void slcan_filter_set_mask(slcan_filter_t *filter, uint32_t mask);
+
+/**
+ * @brief       set one explicit rule (J command)
+ * @param[in]   filter : channel filter
+ * @param[in]   ext    : extended (29bit) rule when true
+ * @param[in]   index  : rule slot
+ * @param[in]   id     : id to match
+ * @param[in]   mask   : id bits that must match
+ * @return      false if index or id is out of range
+ */
+bool slcan_filter_set_rule(slcan_filter_t *filter, bool ext, uint8_t index, uint32_t id, uint32_t mask);
+
+/**
+ * @brief       copy the rules into a channel configuration before mcan_init()
+ */
+void slcan_filter_apply(slcan_filter_t *filter, mcan_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SLCAN_FILTER_H */
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _SLCAN_LED_H
+#define _SLCAN_LED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * RGB status LEDs, kept off the frame path.
+ * The hot path only ORs a per-channel activity bit, slcan_led_poll() takes the
+ * bits at SLCAN_LED_REFRESH_HZ, lights the LED of every channel/direction that
+ * saw traffic during the last period and starts a non-blocking WS2812 refresh
+ * when the picture changed.
+ */
+
+#ifndef USE_RGB_LED
+#define USE_RGB_LED 0
+#endif
+
+#ifndef SLCAN_LED_REFRESH_HZ
+#define SLCAN_LED_REFRESH_HZ (30U)
+#endif
+
+/* bit 2n: channel n received, bit 2n + 1: channel n transmitted */
+extern volatile uint32_t g_slcan_led_activity;
+
+static inline void slcan_led_activity(uint8_t channel, bool read)
+{
+#if USE_RGB_LED
+    __atomic_fetch_or(&g_slcan_led_activity, 1UL << (channel * 2 + (read ? 0 : 1)), __ATOMIC_RELAXED);
+#else
+    (void)channel;
+    (void)read;
+#endif
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief       render the activity of the last period, call from the main loop
+ * @return      true while LEDs are lit or a refresh is due, the caller should not sleep
+ */
+bool slcan_led_poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SLCAN_LED_H */
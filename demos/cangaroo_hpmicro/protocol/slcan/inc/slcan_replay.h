@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _SLCAN_REPLAY_H
+#define _SLCAN_REPLAY_H
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "hpm_mcan_drv.h"
+#include "hpm_gptmr_drv.h"
+
+/*
+ * On-device replay of an uploaded frame list.
+ * The host fills the list with G commands while replay is stopped, every entry
+ * carries its channel and the delay after the previous entry. Once started, a
+ * GPTMR channel wakes up shortly before each entry is due and the interrupt
+ * handler writes the frame straight into the MCAN TX FIFO, so the inter-frame
+ * timing no longer depends on USB.
+ *
+ * Due times are absolute core cycle counts derived from the sum of the deltas,
+ * a late interrupt never shifts the following entries.
+ */
+
+/* entries in the replay list */
+#ifndef SLCAN_REPLAY_DEPTH
+#define SLCAN_REPLAY_DEPTH        (256U)
+#endif
+
+/* GPTMR channel owned by the replay scheduler */
+#ifndef SLCAN_REPLAY_GPTMR
+#define SLCAN_REPLAY_GPTMR        HPM_GPTMR0
+#define SLCAN_REPLAY_GPTMR_CH     (0U)
+#define SLCAN_REPLAY_GPTMR_CLOCK  clock_gptmr0
+#define SLCAN_REPLAY_GPTMR_IRQ    IRQn_GPTMR0
+#endif
+
+/* above the MCAN interrupts, a due frame is not held back by RX draining;
+ * mcan_tx_send_now() masks its FIFO write against them */
+#ifndef SLCAN_REPLAY_IRQ_PRIORITY
+#define SLCAN_REPLAY_IRQ_PRIORITY (2U)
+#endif
+
+/* retry delay when the TX FIFO of the target channel is full */
+#ifndef SLCAN_REPLAY_RETRY_US
+#define SLCAN_REPLAY_RETRY_US     (20U)
+#endif
+
+typedef struct {
+    uint32_t delta_us;      /* delay after the previous entry, after start for the first one */
+    uint8_t channel;        /* can channel the frame is sent on */
+    mcan_tx_frame_t frame;
+} slcan_replay_entry_t;
+
+enum slcan_replay_state {
+    SLCAN_REPLAY_IDLE = 0,  /* stopped, the list may be changed */
+    SLCAN_REPLAY_RUNNING,
+    SLCAN_REPLAY_DONE,      /* every loop sent */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief       attach the replay GPTMR to the running core's clock group
+ */
+void slcan_replay_init(void);
+
+/**
+ * @brief       empty the replay list
+ * @return      false while replay is running
+ */
+bool slcan_replay_clear(void);
+
+/**
+ * @brief       append one frame to the replay list
+ * @param[in]   delta_us : delay after the previous entry
+ * @param[in]   channel  : can channel
+ * @param[in]   frame    : frame to send
+ * @return      false while running, when the list is full or the channel is invalid
+ */
+bool slcan_replay_append(uint32_t delta_us, uint8_t channel, const mcan_tx_frame_t *frame);
+
+/**
+ * @brief       start sending the list
+ * @param[in]   loops : number of passes over the list, 0 repeats until stopped
+ * @return      false if the list is empty or replay is already running
+ */
+bool slcan_replay_start(uint32_t loops);
+
+/**
+ * @brief       stop sending, frames already in the TX FIFOs are still sent
+ */
+void slcan_replay_stop(void);
+
+/**
+ * @brief       current enum slcan_replay_state
+ */
+uint8_t slcan_replay_get_state(void);
+
+/**
+ * @brief       format the replay state and counters as "key=value," text
+ * @param[out]  buf  : text destination
+ * @param[in]   size : size of buf
+ * @return      text length
+ */
+uint32_t slcan_replay_format(char *buf, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SLCAN_REPLAY_H */
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _SLCAN_STATS_H
+#define _SLCAN_STATS_H
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "hpm_mcan_drv.h"
+
+/*
+ * Per-channel bridge statistics.
+ * Every counter has exactly one writer, mcan_isr(), the main loop or the usb
+ * IN completion, so no counter needs a lock; readers only ever see a slightly old value.
+ * Rates and bus load are computed at query time from the delta to the
+ * previous query. Received frames count towards the bus load as mcan_isr()
+ * reads them, before the rx ring or the usb path may drop them.
+ */
+
+#define SLCAN_STATS_CHANNELS    (4U)
+/* bucket n counts latencies in [2^(n-1), 2^n) us, bucket 0 is < 1us, the last one is open ended */
+#define SLCAN_STATS_LAT_BUCKETS (16U)
+
+typedef struct {
+    /* written by mcan_isr() only */
+    volatile uint32_t rx_frames;   /* frames taken out of the MCAN RX FIFOs/buffers */
+    uint64_t rx_nominal_bits;      /* estimated bus bits of those frames at nominal rate */
+    uint64_t rx_data_bits;         /* estimated bus bits of those frames at the data phase rate */
+
+    /* written by the main loop only */
+    uint32_t fwd_frames;           /* received frames handed to the usb batch */
+    uint32_t tx_frames;            /* host frames queued for the bus */
+    uint32_t usb_bytes;            /* bytes committed to the usb batch */
+    uint64_t tx_nominal_bits;      /* estimated bus bits of queued frames at nominal rate */
+    uint64_t tx_data_bits;         /* estimated bus bits of queued frames at the data phase rate */
+
+    /* written by the usb IN completion only */
+    uint32_t latency_max_us;       /* worst ISR to host latency */
+    uint32_t latency_hist[SLCAN_STATS_LAT_BUCKETS];
+
+    /* previous query, for rates */
+    uint64_t last_cycle;
+    uint32_t last_rx_frames;
+    uint32_t last_tx_frames;
+    uint64_t last_nominal_bits;
+    uint64_t last_data_bits;
+} slcan_stats_t;
+
+extern slcan_stats_t g_slcan_stats[SLCAN_STATS_CHANNELS];
+
+/* main loop: one received frame handed to the usb batch */
+static inline void slcan_stats_forwarded(uint8_t channel)
+{
+    g_slcan_stats[channel].fwd_frames++;
+}
+
+/* main loop: bytes committed to the usb batch */
+static inline void slcan_stats_usb(uint8_t channel, uint32_t bytes)
+{
+    g_slcan_stats[channel].usb_bytes += bytes;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief       account one frame mcan_isr() read from the controller, queued or dropped
+ * @param[in]   channel    : can channel
+ * @param[in]   msg        : the frame, its bits count towards the bus load
+ */
+void slcan_stats_isr_rx(uint8_t channel, const mcan_rx_message_t *msg);
+
+/**
+ * @brief       account the received frames of one usb batch the host has taken
+ * @param[in]   channel    : can channel
+ * @param[in]   frames     : received frames in the batch
+ * @param[in]   latency_us : time from mcan_isr() of the oldest frame to the end of the transfer
+ * @details     called from the IN completion; every frame of the batch is counted at the
+ *              latency of the oldest one, so the histogram is an upper bound per frame
+ */
+void slcan_stats_delivered(uint8_t channel, uint32_t frames, uint32_t latency_us);
+
+/**
+ * @brief       account one host frame queued for transmission
+ * @param[in]   channel : can channel
+ * @param[in]   frame   : the frame, its bits count towards the bus load
+ */
+void slcan_stats_tx(uint8_t channel, const mcan_tx_frame_t *frame);
+
+/**
+ * @brief       format the statistics of one channel as "key=value," text
+ * @param[in]   channel : can channel
+ * @param[in]   base    : MCAN instance, for the error counters
+ * @param[in]   config  : channel configuration, for the bus load
+ * @param[out]  buf     : text destination, not zero terminated when full
+ * @param[in]   size    : size of buf
+ * @return      text length
+ * @details     rates are per second since the previous call for this channel
+ */
+uint32_t slcan_stats_format(uint8_t channel, MCAN_Type *base, const mcan_config_t *config, char *buf, uint32_t size);
+
+/**
+ * @brief       print the statistics of one channel on the debug console
+ */
+void slcan_stats_print(uint8_t channel, MCAN_Type *base, const mcan_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SLCAN_STATS_H */
@@ -14,12 +14,13 @@
 #include "string.h"
 #include "board.h"
 #include "cdc_acm.h"
-#include "WS2812.h"
 #include "hpm_clock_drv.h"
-
-#ifndef USE_RGB_LED
-#define USE_RGB_LED 0
-#endif
+#include "slcan_ascii.h"
+#include "slcan_bin.h"
+#include "slcan_event.h"
+#include "slcan_stats.h"
+#include "slcan_replay.h"
+#include "slcan_led.h"
 
 /*------------------------------------------------------------------------------------------------*/
 /* Global variables */
@@ -27,50 +28,23 @@
 
 UART_CFG_T def_uart_cfg = {115200, 0, 0, 8};
 
+volatile uint32_t g_slcan_ready_mask;
 
-#if USE_RGB_LED
-typedef struct
-{
-    uint8_t can_channel;
-    uint8_t read_rgb_index;
-    uint8_t write_rgb_index;
-} can_rgb_index_t;
-
-static const can_rgb_index_t can_rgb_index_table[SCLAN_NUM] =
-{
-    {0, 7, 8},
-    {1, 6, 5},
-    {2, 4, 3},
-    {3, 2, 1},
-};
+static struct slcan_t *const slcan_ports[SCLAN_NUM] = {
+#if (SCLAN_NUM >= 1)
+    &slcan0,
 #endif
-static void can_led(uint8_t channel, bool read, bool status)
-{
-#if !USE_RGB_LED
-    (void)channel;
-    (void)read;
-    (void)status;
-#else
-    uint8_t led_index;
-    uint8_t r = 0x00, b = 0x00, g = 0x00;
-    if (channel >= SCLAN_NUM) {
-        return;
-    }
-    if (read == true) {
-        led_index = can_rgb_index_table[channel].read_rgb_index;
-        r = 0x0F;
-    } else {
-        led_index = can_rgb_index_table[channel].write_rgb_index;
-        b = 0x0F;
-    }
-    if (status == true) {
-        WS2812_SetPixel(led_index, r, g, b);
-    } else {
-        WS2812_SetPixel(led_index, 0, 0, 0);
-    }
-    WS2812_Update(true);
+#if (SCLAN_NUM >= 2)
+    &slcan1,
 #endif
-}
+#if (SCLAN_NUM >= 3)
+    &slcan2,
+#endif
+#if (SCLAN_NUM >= 4)
+    &slcan3,
+#endif
+};
+
 
 /**
  * @brief       read can normal baudrate by index
@@ -112,6 +86,42 @@ uint32_t sclcan_can_baud(uint8_t can_baud_index) {
     return baud;
 }
 
+/**
+ * @brief       solve the phases not set by K and write both as low level timing
+ * @param[in]   slcan_port : one can port will to be operated
+ * @param[in]   can_src_clk_freq : can source clock
+ * @param[out]  cfg : configuration passed to mcan_init()
+ * @return      false if a rate from the S/Y tables has no timing on this clock
+ * @details     the phases set by K were solved when the command was received
+ */
+static bool slcan_can_fill_timing(struct slcan_t *slcan_port, uint32_t can_src_clk_freq, mcan_config_t *cfg) {
+    mcan_config_t *rates = &slcan_port->candev_cfg;
+
+    if (((slcan_port->bt_custom & SLCAN_BT_CUSTOM_NOMINAL) == 0) &&
+        !slcan_bt_solve(can_src_clk_freq, rates->baudrate, 0, false, &slcan_bt_mcan_nominal, &slcan_port->nominal_bt)) {
+        return false;
+    }
+    if (((slcan_port->bt_custom & SLCAN_BT_CUSTOM_DATA) == 0) &&
+        !slcan_bt_solve(can_src_clk_freq, rates->baudrate_fd, 0, true, &slcan_bt_mcan_data, &slcan_port->data_bt)) {
+        return false;
+    }
+    cfg->use_lowlevel_timing_setting = true;
+    cfg->can_timing.prescaler = slcan_port->nominal_bt.prescaler;
+    cfg->can_timing.num_seg1 = slcan_port->nominal_bt.seg1;
+    cfg->can_timing.num_seg2 = slcan_port->nominal_bt.seg2;
+    cfg->can_timing.num_sjw = slcan_port->nominal_bt.sjw;
+    cfg->can_timing.enable_tdc = false;
+    cfg->canfd_timing.prescaler = slcan_port->data_bt.prescaler;
+    cfg->canfd_timing.num_seg1 = slcan_port->data_bt.seg1;
+    cfg->canfd_timing.num_seg2 = slcan_port->data_bt.seg2;
+    cfg->canfd_timing.num_sjw = slcan_port->data_bt.sjw;
+    cfg->canfd_timing.enable_tdc = slcan_port->data_bt.tdc_enable;
+    cfg->enable_tdc = slcan_port->data_bt.tdc_enable;
+    cfg->tdc_config.ssp_offset = slcan_port->data_bt.tdc_offset;
+    cfg->tdc_config.filter_window_length = 0;
+    return true;
+}
+
 /**
  * @brief       open one slcan
  * @param[in]   slcan_port : one can port will to be operated
@@ -120,9 +130,20 @@ uint32_t sclcan_can_baud(uint8_t can_baud_index) {
  */
 void slcan_can_open(struct slcan_t *slcan_port) {
     uint32_t can_src_clk_freq = board_init_can_clock(slcan_port->ptr);
-    mcan_init(slcan_port->ptr, &slcan_port->candev_cfg, can_src_clk_freq);
-    uint32_t interrupt_mask = MCAN_EVENT_RECEIVE;
+    mcan_config_t *cfg = &slcan_port->candev_cfg;
+    mcan_config_t timing_cfg;
+    slcan_filter_apply(&slcan_port->filter, cfg);
+    if (slcan_port->bt_custom != 0) {
+        /* the timing registers share a union with the rates, candev_cfg keeps the rates for the statistics */
+        timing_cfg = *cfg;
+        if (slcan_can_fill_timing(slcan_port, can_src_clk_freq, &timing_cfg)) {
+            cfg = &timing_cfg;
+        }
+    }
+    mcan_init(slcan_port->ptr, cfg, can_src_clk_freq);
+    uint32_t interrupt_mask = MCAN_EVENT_RECEIVE | MCAN_INT_TX_COMPLETED | MCAN_INT_TXFIFO_EMPTY;
     mcan_enable_interrupts(slcan_port->ptr, interrupt_mask);
+    mcan_enable_txbuf_transmission_interrupt(slcan_port->ptr, ~0U);
     intc_m_enable_irq_with_priority(slcan_port->irq_num, 1);
     slcan_port->candev_isopen = 1;
     SLCAN_DEBUG("CAN[%d] Open  [%dkbps][%dkbps] \r\n", slcan_port->candev_sn,
@@ -137,9 +158,10 @@ void slcan_can_open(struct slcan_t *slcan_port) {
  */
 void slcan_can_close(struct slcan_t *slcan_port) {
     mcan_deinit(slcan_port->ptr);
-    uint32_t interrupt_mask = MCAN_EVENT_RECEIVE;
+    uint32_t interrupt_mask = MCAN_EVENT_RECEIVE | MCAN_INT_TX_COMPLETED | MCAN_INT_TXFIFO_EMPTY;
     mcan_disable_interrupts(slcan_port->ptr, interrupt_mask);
     intc_m_disable_irq(slcan_port->irq_num);
+    mcan_tx_flush(slcan_port->candev_sn);
     slcan_port->candev_isopen = 0;
     SLCAN_DEBUG("CAN[%d] Close \r\n", slcan_port->candev_sn);
 }
@@ -153,6 +175,7 @@ void slcan_can_close(struct slcan_t *slcan_port) {
  */
 void slcan_can_set_nbaud(struct slcan_t *slcan_port, uint8_t baud_index) {
     slcan_port->candev_cfg.baudrate = sclcan_can_baud(baud_index);
+    slcan_port->bt_custom &= ~SLCAN_BT_CUSTOM_NOMINAL;
     SLCAN_DEBUG("CAN[%d]set NormBitRate: [%dkbps]\r\n", slcan_port->candev_sn, slcan_port->candev_cfg.baudrate);
 }
 
@@ -167,9 +190,42 @@ void slcan_can_set_nbaud(struct slcan_t *slcan_port, uint8_t baud_index) {
  */
 void slcan_can_set_dbaud(struct slcan_t *slcan_port, uint8_t data_mbps) {
     slcan_port->candev_cfg.baudrate_fd = data_mbps * 1000000;
+    slcan_port->bt_custom &= ~SLCAN_BT_CUSTOM_DATA;
     SLCAN_DEBUG("CAN[%d]set DataBitRate: [%dkbps]\r\n", slcan_port->candev_sn, slcan_port->candev_cfg.baudrate_fd);
 }
 
+/**
+ * @brief       set any can rate and sample point
+ * @param[in]   slcan_port : one can port will to be operated
+ * @param[in]   data_phase : false for the nominal rate, true for the CAN-FD data rate
+ * @param[in]   bitrate : bit/s
+ * @param[in]   sample_point : permille, 0 for the default of the phase
+ * @return      false if the rate can not be reached from the can source clock
+ * @details     solved against the clock of this channel now, written to MCAN by the next open
+ */
+bool slcan_can_set_timing(struct slcan_t *slcan_port, bool data_phase, uint32_t bitrate, uint16_t sample_point) {
+    uint32_t can_src_clk_freq = board_init_can_clock(slcan_port->ptr);
+    slcan_bt_timing_t timing;
+
+    if (!slcan_bt_solve(can_src_clk_freq, bitrate, sample_point, data_phase,
+                        data_phase ? &slcan_bt_mcan_data : &slcan_bt_mcan_nominal, &timing)) {
+        return false;
+    }
+    if (data_phase) {
+        slcan_port->data_bt = timing;
+        slcan_port->candev_cfg.baudrate_fd = timing.bitrate;
+        slcan_port->bt_custom |= SLCAN_BT_CUSTOM_DATA;
+    } else {
+        slcan_port->nominal_bt = timing;
+        slcan_port->candev_cfg.baudrate = timing.bitrate;
+        slcan_port->bt_custom |= SLCAN_BT_CUSTOM_NOMINAL;
+    }
+    SLCAN_DEBUG("CAN[%d]set %s timing: [%dbps] pre %d seg1 %d seg2 %d sp %d\r\n", slcan_port->candev_sn,
+                data_phase ? "data" : "nominal", timing.bitrate, timing.prescaler, timing.seg1, timing.seg2,
+                timing.sample_point);
+    return true;
+}
+
 /**
  * @brief       set can work mode
  * @param[in]   slcan_port : one can port will to be operated
@@ -207,24 +263,35 @@ void slcan_can_set_mode(struct slcan_t *slcan_port, uint8_t mode_index) {
 /**
  * @brief       read one message to slcan instance
  * @param[in]   slcan_port : one can port will to be operated
- * @return  		sizeof(mcan_tx_frame_t)
- * @details     if open debug will print debug menssage
+ * @return  		sizeof(mcan_rx_message_t), 0 if the rx queue is empty
+ * @details     pops the oldest frame queued by mcan_isr() together with its arrival time
  */
-uint32_t slcan_can_read(struct slcan_t *slcan_port, uint8_t fifo_num) {
-    memcpy(&slcan_port->can_rx_msg, &g_mcan_rx_frame[slcan_port->candev_sn][fifo_num], sizeof(mcan_rx_message_t));
-    return sizeof(mcan_tx_frame_t);
+uint32_t slcan_can_read(struct slcan_t *slcan_port) {
+    spsc_ring_t *ring = &g_mcan_rx_queue[slcan_port->candev_sn].ring;
+    mcan_rx_frame_t *frame = (mcan_rx_frame_t *)spsc_ring_read_setup(ring);
+    if (frame == NULL) {
+        return 0;
+    }
+    memcpy(&slcan_port->can_rx_msg, &frame->msg, sizeof(mcan_rx_message_t));
+    slcan_port->can_rx_time_us = mcan_cycle_to_us(frame->rx_cycle);
+    spsc_ring_read_done(ring);
+    return sizeof(mcan_rx_message_t);
 }
 
 /**
  * @brief       write one message to slcan can port
  * @param[in]   slcan_port : one can port will to be operated
- * @return  		sizeof(mcan_tx_frame_t)
- * @details
+ * @return  		sizeof(mcan_tx_frame_t), 0 if the channel is closed or the tx queue is full
+ * @details     the frame is queued and sent from the TX FIFO, this never waits for the bus
  */
 uint32_t slcan_can_write(struct slcan_t *slcan_port) {
-    can_led(slcan_port->candev_sn, false, true);
-    mcan_transmit_blocking(slcan_port->ptr, &slcan_port->can_tx_msg);
-    can_led(slcan_port->candev_sn, false, false);
+    if ((slcan_port->candev_isopen == 0) ||
+        (mcan_tx_enqueue(slcan_port->candev_sn, &slcan_port->can_tx_msg) == false)) {
+        return 0;
+    }
+    slcan_stats_tx(slcan_port->candev_sn, &slcan_port->can_tx_msg);
+    slcan_led_activity(slcan_port->candev_sn, false);
+    mcan_tx_kick(slcan_port->candev_sn);
     return sizeof(mcan_tx_frame_t);
 }
 
@@ -264,39 +331,6 @@ void slcan_uart_close(struct slcan_t *slcan_port) {
     SLCAN_DEBUG("com[%d] close\r\n", slcan_port->uartdev_sn);
 }
 
-/**
- * @brief       read slcan uart data from buffer and check valid data
- * @param[in]   slcan_port : one can port will to be operated
- * @return  		return -1 : no data
-                                                                return 0
- : only 1 valid data return 1 	: There still data left to process
- * @details
- */
-
-int32_t slcan_uart_read(struct slcan_t *slcan_port) {
-    uint32_t ticks_per_us = (hpm_core_clock + 1000000 - 1U) / 1000000;
-    uint64_t expected_ticks = hpm_csr_get_core_cycle() + (uint64_t)ticks_per_us * 1000UL * 1000; //1000ms
-    uint8_t data;
-    if (slcan_port->candev_sn < SCLAN_NUM) {
-        if (get_usb_out_is_empty(slcan_port->candev_sn) == false) {
-            while (1) {
-                if (get_usb_out_char(slcan_port->candev_sn, &data) == true) {
-                    slcan_port->uart_rx_buffer[slcan_port->uart_rx_len++] = (uint8_t)data;
-                    if (data == '\r') {
-                        // printf("sl_r:%d\r\n", slcan_port->uart_rx_len);
-                        return 1;
-                    }
-                }
-                if (hpm_csr_get_core_cycle() > expected_ticks) {
-                    slcan_port->uart_rx_len = 0;
-                    return -1;
-                }
-            }
-        }
-    }
-    return -1; // Data buffer empty
-}
-
 /**
  * @brief       send slcan uart data
  * @param[in]   slcan_port : one can port will to be operated
@@ -308,7 +342,7 @@ int32_t slcan_uart_read(struct slcan_t *slcan_port) {
 
 uint32_t slcan_uart_write(struct slcan_t *slcan_port, void *buffer,
                           uint32_t size) {
-    uint32_t res;
+    uint32_t res = 0;
     if (slcan_port->uartdev_sn < SCLAN_NUM) // USB_VCOM used sn < 4
     {
         res = write_usb_data(slcan_port->uartdev_sn, (uint8_t *)buffer, size); //Data Point to USB_VCOM
@@ -319,165 +353,30 @@ uint32_t slcan_uart_write(struct slcan_t *slcan_port, void *buffer,
     return res;
 }
 
-/**
- * @brief       ASC2 convert to decimal
- * @param[in]   c 		 ：ASC2 code
- * @return  		decimal number
- * @details
- */
-
-static int asc2nibble(char c) {
-    if ((c >= '0') && (c <= '9'))
-        return c - '0';
-
-    if ((c >= 'A') && (c <= 'F'))
-        return c - 'A' + 10;
-
-    if ((c >= 'a') && (c <= 'f'))
-        return c - 'a' + 10;
-
-    return 16; /* error */
-}
-
-/**
- * @brief       hex sting convert to decimal
- * @param[in]   strbuffer		 	：hex sting
- * @param[in]   strlen		 		：sting lenght
- * @return  		decimal number
- * @details
- */
-static int hexstr2int(uint8_t *strbuffer, uint8_t strlen) {
-    uint32_t numcount = 0;
-    int8_t num = 0;
-    int8_t index = 0;
-    while (index < strlen) {
-        num = asc2nibble(strbuffer[index]);
-        if ((0x00 <= num) && (num <= 0x0F)) {
-            numcount = numcount << 4;
-            numcount |= (num & 0x0F);
-        }
-        index++;
-    }
-    return numcount;
-}
-
-/**
- * @brief       Decode the Data Length Code.
- * @param[in]   code:   Data Length Code.
- * @return      Number of bytes in a message.
- * @details     Converts a Data Length Code into a number of message bytes.
- */
-static uint8_t SLCAN_DecodeDLC(uint8_t code) {
-    if (code >= '0' && code < '9') {
-        return code - '0';
-    } else {
-        switch (code) {
-        case '9':
-            return 12;
-        case 'A':
-            return 16;
-        case 'B':
-            return 20;
-        case 'C':
-            return 24;
-        case 'D':
-            return 32;
-        case 'E':
-            return 48;
-        case 'F':
-            return 64;
-        default:
-            return 0xff;
-        }
-    }
-}
-
-/**
- * @brief       Encode the Data Length Code.
- * @param[in]   dlc:  Number of bytes in a message.
- * @return      Data Length Code.
- * @details     Converts number of bytes in a message into a Data Length Code.
- */
-static uint8_t SLCAN_EncodeDLC(uint8_t dlc) {
-    if (dlc < 9) {
-        return dlc + '0';
-    } else {
-        switch (dlc) {
-        case 12:
-            return '9';
-        case 16:
-            return 'A';
-        case 20:
-            return 'B';
-        case 24:
-            return 'C';
-        case 32:
-            return 'D';
-        case 48:
-            return 'E';
-        case 64:
-            return 'F';
-        default:
-            return 0xff;
-        }
-    }
-}
-
-uint8_t mcan_get_dlc_from_message_size(uint8_t message_size)
-{
-    uint32_t dlc = 0;
-    if (message_size <= 8U) {
-        dlc = message_size;
-    } else {
-        switch (message_size)
-        {
-        case 12:
-            dlc = 9;
-            break;
-        case 16:
-            dlc = 10;
-            break;
-        case 20:
-            dlc = 11;
-            break;
-        case 24:
-            dlc = 12;
-            break;
-        case 32:
-            dlc = 13;
-            break;
-        case 48:
-            dlc = 14;
-            break;
-        case 64:
-            dlc = 15;
-            break; 
-        default:
-            break;
-        }
-    }
-    return dlc;
-}
-
 /**
  * @brief       uart ascii data convert to command data
  * @param[in]   slcan_port : one can port will to be operated
+ * @param[in]   buf : one command, ends with '\r'
+ * @param[in]   len : command length including the '\r'
  * @return
  * @details     slcan port operate and send can message
+                buf may point straight into the usb ring, nothing past buf[len - 1] is read
  */
-void slcan_parse_ascii(struct slcan_t *slcan_port) {
+void slcan_parse_ascii(struct slcan_t *slcan_port, const uint8_t *buf, uint32_t len) {
 
     /* for answers to received commands */
     int rx_out_len = 0;                        // uart ack data lenght
     char replybuf[10] = {0};                   // uart ack data buffer
     uint8_t uart_status;                       // uart cmd ack status
-    uint8_t *buf = slcan_port->uart_rx_buffer; // cmd data buffer
 
-    uint8_t cmd_bytes; // uart cmd lenght :	cmd_bytes = 1 has no parameter
-                       //									cmd_bytes
-                       //= 2 has 1 parameter
+    uint32_t cmd_bytes; // uart cmd lenght :	cmd_bytes = 1 has no parameter
+                        //									cmd_bytes
+                        //= 2 has 1 parameter
 
-    int tmp = 0;
+    uint32_t value;
+    uint32_t id;
+    uint32_t size;
+    uint32_t tmp;
 
     uint8_t cmd = buf[0]; // slcan uart cmd
 
@@ -537,89 +436,15 @@ void slcan_parse_ascii(struct slcan_t *slcan_port) {
     case 't': // Transmit an standard (11bit) CAN frame.
     case 'd': // Transmit an standard CAN FD frame
     case 'b': // Transmit an standard CAN FD BRS frame
-        memset(&slcan_port->can_tx_msg, 0, sizeof(slcan_port->can_tx_msg));
-        tmp = SLCAN_DecodeDLC(buf[4]);
-        if (tmp == 0xff) {
-            uart_status = SLCAN_UART_NACK;
-            break;
-        } else {
-            slcan_port->can_tx_msg.dlc = mcan_get_dlc_from_message_size(tmp);
-        }
-        tmp = hexstr2int(buf + 1, 3);
-        slcan_port->can_tx_msg.std_id = tmp; // Frame ID
-        slcan_port->can_tx_msg.use_ext_id = false;// 11bit id  Standard frame format
-        cmd_bytes = 5;    // "Riiin********\a"
-        if (cmd == 'r') { // tiiil[CR]
-            slcan_port->can_tx_msg.rtr = true; // Remote frame
-        } else {
-            switch (cmd) {
-            case 'b':
-                slcan_port->can_tx_msg.bitrate_switch = true;
-                slcan_port->can_tx_msg.canfd_frame = true;
-                break;
-            case 'd':
-                slcan_port->can_tx_msg.bitrate_switch = false;
-                slcan_port->can_tx_msg.canfd_frame = true;
-                break;
-            default:
-                slcan_port->can_tx_msg.canfd_frame = false;
-                slcan_port->can_tx_msg.bitrate_switch = false;
-                break;
-            }
-
-            // tiiildd...[CR]
-            if (mcan_get_message_size_from_dlc(slcan_port->can_tx_msg.dlc) > 0) {
-                cmd_bytes += (mcan_get_message_size_from_dlc(slcan_port->can_tx_msg.dlc) * 2); // add dlc
-                for (tmp = 0; tmp < mcan_get_message_size_from_dlc(slcan_port->can_tx_msg.dlc); tmp++) {
-                    slcan_port->can_tx_msg.data_8[tmp] = hexstr2int(buf + 5 + (tmp * 2), 2);
-                }
-            }
-        }
-        rx_out_len = 1;
-        uart_status = SLCAN_UART_SEND;
-        break;
-
     case 'R': // Transmit an extended RTR (29bit) CAN frame.
     case 'T': // Transmit an extended (29bit) CAN frame.
     case 'D': // Transmit an extended CAN FD frame
     case 'B': // Transmit an extended CAN FD BRS frame
-        memset(&slcan_port->can_tx_msg, 0, sizeof(slcan_port->can_tx_msg));
-        tmp = SLCAN_DecodeDLC(buf[9]);
-        if (tmp == 0xff) {
+        /* tiiildd...[CR], Tiiiiiiiildd...[CR], riiil[CR], Riiiiiiiil[CR] */
+        cmd_bytes = slcan_ascii_decode_frame(buf, len - 1, &slcan_port->can_tx_msg);
+        if (cmd_bytes == 0) {
             uart_status = SLCAN_UART_NACK;
             break;
-        } else
-            slcan_port->can_tx_msg.dlc = mcan_get_dlc_from_message_size(tmp);
-        tmp = hexstr2int(buf + 1, 8);
-        slcan_port->can_tx_msg.ext_id = tmp; // Frame ID
-        slcan_port->can_tx_msg.use_ext_id = true; // 29bit id Extend frame format
-        cmd_bytes = 10;
-        ;                 // "Riiiiiiii********\a"
-        if (cmd == 'R') { // Riiiiiiiil[CR]
-            slcan_port->can_tx_msg.rtr = true; // Remote frame
-        } else {
-            switch (cmd) {
-            case 'B':
-                slcan_port->can_tx_msg.bitrate_switch = true;
-                slcan_port->can_tx_msg.canfd_frame = true;
-                break;
-            case 'D':
-                slcan_port->can_tx_msg.bitrate_switch = false;
-                slcan_port->can_tx_msg.canfd_frame = true;
-                break;
-            default:
-                slcan_port->can_tx_msg.canfd_frame = false;
-                slcan_port->can_tx_msg.bitrate_switch = false;
-                break;
-            }
-
-            // Data frame
-            if (mcan_get_message_size_from_dlc(slcan_port->can_tx_msg.dlc) > 0) { // Tiiiiiiiildd...[CR]
-                cmd_bytes += (mcan_get_message_size_from_dlc(slcan_port->can_tx_msg.dlc) * 2); // add dlc
-                for (tmp = 0; tmp < mcan_get_message_size_from_dlc(slcan_port->can_tx_msg.dlc); tmp++) {
-                    slcan_port->can_tx_msg.data_8[tmp] = hexstr2int(buf + 10 + (tmp * 2), 2);
-                }
-            }
         }
         rx_out_len = 1;
         uart_status = SLCAN_UART_SEND;
@@ -673,7 +498,14 @@ void slcan_parse_ascii(struct slcan_t *slcan_port) {
         Bit 7 Bus Error (BEI), see SJA1000 datasheet **
         */
     case 'F':
-        rx_out_len = sprintf(replybuf, "F00\r");
+        tmp = 0;
+        if (mcan_get_rx_overflow(slcan_port->candev_sn) != 0) {
+            tmp |= 0x08;
+        }
+        if (mcan_tx_is_full(slcan_port->candev_sn)) {
+            tmp |= 0x02;
+        }
+        rx_out_len = sprintf(replybuf, "F%02X\r", (unsigned int)tmp);
         cmd_bytes = 1;
         uart_status = SLCAN_UART_REPLY;
         break;
@@ -750,17 +582,165 @@ void slcan_parse_ascii(struct slcan_t *slcan_port) {
         break;
     case 'M':       // Mxxxxxxxx[CR] Sets Acceptance Mask Register
     case 'm':       // mxxxxxxxx[CR] Sets Acceptance Code Register
-        buf[9] = 0; /* terminate filter string */
+        /* only while closed, the filters are written to MCAN by the next O */
         cmd_bytes = 9;
+        if ((slcan_port->candev_isopen != 0) || (len <= cmd_bytes) ||
+            (slcan_ascii_get_hex(buf + 1, 8, &value) == false)) {
+            uart_status = SLCAN_UART_NACK;
+            break;
+        }
+        if (cmd == 'M') {
+            slcan_filter_set_mask(&slcan_port->filter, value);
+        } else {
+            slcan_filter_set_code(&slcan_port->filter, value);
+        }
         uart_status = SLCAN_UART_ACK;
         break;
 
-    /* Sets Time Stamp ON/OFF for received frames only */
+    /* Extended multi-filter setting, only while closed, applied by the next O.
+        JSniiimmm[CR]            standard rule n (0-F), id iii, mask mmm (1 = bit must match)
+        JEniiiiiiiimmmmmmmm[CR]  extended rule n (0-F), id iiiiiiii, mask mmmmmmmm
+        JC[CR]                   clear every rule, accept all frames
+        With any rule set only matching frames are received */
+    case 'J':
+        cmd_bytes = 2;
+        if ((slcan_port->candev_isopen != 0) || (len <= cmd_bytes)) {
+            uart_status = SLCAN_UART_NACK;
+            break;
+        }
+        uart_status = SLCAN_UART_NACK;
+        if (buf[1] == 'C') {
+            slcan_filter_reset(&slcan_port->filter);
+            uart_status = SLCAN_UART_ACK;
+        } else if ((buf[1] == 'S') || (buf[1] == 'E')) {
+            size = (buf[1] == 'E') ? 8 : 3;
+            cmd_bytes = 3 + size * 2;
+            if ((len > cmd_bytes) && slcan_ascii_get_hex(buf + 2, 1, &tmp) &&
+                slcan_ascii_get_hex(buf + 3, size, &id) && slcan_ascii_get_hex(buf + 3 + size, size, &value) &&
+                slcan_filter_set_rule(&slcan_port->filter, buf[1] == 'E', tmp, id, value)) {
+                uart_status = SLCAN_UART_ACK;
+            }
+        }
+        break;
+
+    /* I[CR]  Read channel statistics, replies I<key=value,...>[CR]
+        IP[CR] Print channel statistics on the debug console
+        rates and bus load are averaged since the previous I/IP of this channel */
+    case 'I':
+        cmd_bytes = 1;
+        if (buf[1] == 'P') {
+            slcan_stats_print(slcan_port->candev_sn, slcan_port->ptr, &slcan_port->candev_cfg);
+            uart_status = SLCAN_UART_ACK;
+        } else {
+            char stats_buf[320];
+            stats_buf[0] = 'I';
+            size = 1 + slcan_stats_format(slcan_port->candev_sn, slcan_port->ptr, &slcan_port->candev_cfg,
+                                          stats_buf + 1, sizeof(stats_buf) - 2);
+            stats_buf[size++] = '\r';
+            slcan_uart_write(slcan_port, stats_buf, size);
+            uart_status = SLCAN_UART_EXIT;
+        }
+        break;
+
+    /* On-device replay, see slcan_replay.h, one list shared by every channel.
+        GC[CR]                  clear the list, only while stopped
+        GAcddddddddFRAME[CR]    append FRAME (t/T/d/D/b/B/r/R syntax) for can channel c,
+                                due dddddddd (hex) microseconds after the previous entry
+        GSnnnn[CR]              start, nnnn (hex) passes over the list, 0000 repeats until stopped
+        GX[CR]                  stop
+        G[CR]                   replies G<key=value,...>[CR] */
+    case 'G':
+        cmd_bytes = 2;
+        uart_status = SLCAN_UART_NACK;
+        if (buf[1] == 'C') {
+            if (slcan_replay_clear()) {
+                uart_status = SLCAN_UART_ACK;
+            }
+        } else if (buf[1] == 'A') {
+            cmd_bytes = 11;
+            if ((len > cmd_bytes) && slcan_ascii_get_hex(buf + 2, 1, &tmp) && slcan_ascii_get_hex(buf + 3, 8, &value) &&
+                (slcan_ascii_decode_frame(buf + cmd_bytes, len - cmd_bytes - 1, &slcan_port->can_tx_msg) != 0) &&
+                slcan_replay_append(value, tmp, &slcan_port->can_tx_msg)) {
+                uart_status = SLCAN_UART_ACK;
+            }
+        } else if (buf[1] == 'S') {
+            cmd_bytes = 6;
+            if ((len > cmd_bytes) && slcan_ascii_get_hex(buf + 2, 4, &value) && slcan_replay_start(value)) {
+                uart_status = SLCAN_UART_ACK;
+            }
+        } else if (buf[1] == 'X') {
+            slcan_replay_stop();
+            uart_status = SLCAN_UART_ACK;
+        } else if (buf[1] == '\r') {
+            char replay_buf[128];
+            replay_buf[0] = 'G';
+            size = 1 + slcan_replay_format(replay_buf + 1, sizeof(replay_buf) - 2);
+            replay_buf[size++] = '\r';
+            slcan_uart_write(slcan_port, replay_buf, size);
+            uart_status = SLCAN_UART_EXIT;
+        }
+        break;
+
+    /* Arbitrary bit rates, only while closed, applied by the next O.
+        KNrrrrrrrrppp[CR]  nominal rate rrrrrrrr (hex bit/s), sample point ppp (hex permille), 000: 87.5%
+        KDrrrrrrrrppp[CR]  data phase rate, 000: 75%, transceiver delay compensation from 1Mbit/s
+        K[CR]              replies KN<pre>:<seg1>:<seg2>:<sjw>:<rate>:<sp>,D<...>:<tdco>[CR] for the K phases
+        S and Y switch their phase back to the fixed rate tables */
+    case 'K':
+        cmd_bytes = 13;
+        uart_status = SLCAN_UART_NACK;
+        if ((buf[1] == 'N') || (buf[1] == 'D')) {
+            if ((slcan_port->candev_isopen == 0) && (len > cmd_bytes) && slcan_ascii_get_hex(buf + 2, 8, &value) &&
+                slcan_ascii_get_hex(buf + 10, 3, &tmp) && slcan_can_set_timing(slcan_port, buf[1] == 'D', value, tmp)) {
+                uart_status = SLCAN_UART_ACK;
+            }
+        } else if (buf[1] == '\r') {
+            char timing_buf[96];
+            slcan_bt_timing_t *n = &slcan_port->nominal_bt;
+            slcan_bt_timing_t *d = &slcan_port->data_bt;
+            size = 0;
+            if (slcan_port->bt_custom & SLCAN_BT_CUSTOM_NOMINAL) {
+                size += snprintf(timing_buf + size, sizeof(timing_buf) - size, "KN%u:%u:%u:%u:%u:%u",
+                                 n->prescaler, n->seg1, n->seg2, n->sjw, (unsigned int)n->bitrate, n->sample_point);
+            }
+            if (slcan_port->bt_custom & SLCAN_BT_CUSTOM_DATA) {
+                size += snprintf(timing_buf + size, sizeof(timing_buf) - size, "%sD%u:%u:%u:%u:%u:%u:%u",
+                                 (size != 0) ? "," : "K", d->prescaler, d->seg1, d->seg2, d->sjw,
+                                 (unsigned int)d->bitrate, d->sample_point, d->tdc_enable ? d->tdc_offset : 0);
+            }
+            if (size == 0) {
+                timing_buf[size++] = 'K';
+            }
+            timing_buf[size++] = '\r';
+            slcan_uart_write(slcan_port, timing_buf, size);
+            uart_status = SLCAN_UART_EXIT;
+        }
+        break;
+
+    /* Hn[CR] Select the format of received frames.
+        H0: slcan ascii lines (default), H1: slcan_bin.h binary records.
+        Commands and replies stay ascii in both modes */
+    case 'H':
+        cmd_bytes = 2;
+        if (buf[1] == '0') {
+            slcan_port->frame_mode = SLCAN_FRAME_ASCII;
+            uart_status = SLCAN_UART_ACK;
+        } else if (buf[1] == '1') {
+            slcan_port->frame_mode = SLCAN_FRAME_BINARY;
+            uart_status = SLCAN_UART_ACK;
+        } else {
+            uart_status = SLCAN_UART_NACK;
+        }
+        break;
+
+    /* Sets Time Stamp ON/OFF for received frames only
+        Z0: off, Z1: milliseconds (4 hex digits), Z2: microseconds (8 hex digits) */
     case 'Z':
-        if ((buf[1] & 0x01)) {
+        slcan_port->set_flag &= ~(SLCAN_SFLAG_TIMESTAMP | SLCAN_SFLAG_TIMESTAMP_US);
+        if (buf[1] == '2') {
+            slcan_port->set_flag |= SLCAN_SFLAG_TIMESTAMP_US;
+        } else if ((buf[1] & 0x01)) {
             slcan_port->set_flag |= SLCAN_SFLAG_TIMESTAMP;
-        } else {
-            slcan_port->set_flag &= ~SLCAN_SFLAG_TIMESTAMP;
         }
         cmd_bytes = 2;
         uart_status = SLCAN_UART_ACK;
@@ -785,7 +765,13 @@ void slcan_parse_ascii(struct slcan_t *slcan_port) {
     case SLCAN_UART_REPLY:
         break;
     case SLCAN_UART_SEND:
-        slcan_can_write(slcan_port);
+        /* channel closed or tx queue full, BELL tells the host to back off and retry */
+        if (slcan_can_write(slcan_port) == 0) {
+            replybuf[0] = '\a';
+            rx_out_len = 1;
+            break;
+        }
+        /* fall through */
     case SLCAN_UART_ACK:
         replybuf[0] = '\r';
         rx_out_len = 0; // cangroo don't need ack
@@ -801,139 +787,149 @@ void slcan_parse_ascii(struct slcan_t *slcan_port) {
     }
 }
 
+/* NACK a line that never reached the parser */
+static void slcan_uart_bell(struct slcan_t *slcan_port) {
+    uint8_t bell = '\a';
+
+    slcan_uart_write(slcan_port, &bell, 1);
+}
+
 /**
- * @brief       uart process
+ * @brief       feed vcom bytes to the command parser
  * @param[in]   slcan_port : one can port will to be operated
+ * @param[in]   data : received bytes, any split of the stream is fine
+ * @param[in]   len  : number of bytes
  * @return
- * @details     serial  data ---> can message
+ * @details     resumable: a command cut by the end of data is kept in uart_rx_buffer and
+                completed by the next call, a command that lies completely in data is parsed in place
  */
-void slcan_process_uart(struct slcan_t *slcan_port) {
-    int32_t rc = 1;
-
-    while (rc) // Buffer still has command. Keep checking
-    {
-        rc = slcan_uart_read(slcan_port); // check uart data correct
-
-        if (rc < 0) // No valid data
-        {
-            memset(slcan_port->uart_rx_buffer, 0, SLCAN_MTU);
-            return;
+void slcan_uart_feed(struct slcan_t *slcan_port, const uint8_t *data, uint32_t len) {
+    const uint8_t *end = data + len;
+    const uint8_t *cr;
+    uint32_t n;
+
+    while (data < end) {
+        cr = memchr(data, '\r', end - data);
+        n = (cr != NULL) ? (uint32_t)(cr - data + 1) : (uint32_t)(end - data);
+        if (slcan_port->uart_rx_discard) {
+            /* tail of an overlong line */
+            slcan_port->uart_rx_discard = (cr == NULL);
+            if (cr != NULL) {
+                slcan_uart_bell(slcan_port);
+            }
+        } else if ((cr != NULL) && (slcan_port->uart_rx_len == 0)) {
+            slcan_parse_ascii(slcan_port, data, n);
+        } else if ((slcan_port->uart_rx_len + n) > SLCAN_RX_MTU) {
+            /* longer than any command, drop the line and NACK it once it ends */
+            slcan_port->uart_rx_len = 0;
+            slcan_port->uart_rx_discard = (cr == NULL);
+            if (cr != NULL) {
+                slcan_uart_bell(slcan_port);
+            }
+        } else {
+            memcpy(slcan_port->uart_rx_buffer + slcan_port->uart_rx_len, data, n);
+            slcan_port->uart_rx_len += n;
+            if (cr != NULL) {
+                slcan_parse_ascii(slcan_port, slcan_port->uart_rx_buffer, slcan_port->uart_rx_len);
+                slcan_port->uart_rx_len = 0;
+            }
         }
-        // SLCAN_DEBUG("[com%d]>>[can%d]:", slcan_port->candev_sn, slcan_port->candev_sn);
-        // for (uint32_t i = 0; i < slcan_port->uart_rx_len; i++) {
-        //     SLCAN_DEBUG("%c",slcan_port->uart_rx_buffer[i]);
-        // }
-        // SLCAN_DEBUG("\n");
-
-        slcan_parse_ascii(slcan_port); // uart data conversion
-        slcan_port->uart_rx_len = 0;
-        memset(slcan_port->uart_rx_buffer, 0, SLCAN_MTU);
+        data += n;
     }
 }
 
 /**
- * @brief       can message convert to uart data
+ * @brief       uart process
  * @param[in]   slcan_port : one can port will to be operated
  * @return
- * @details     can data ---> serial  data
+ * @details     serial  data ---> can message, the usb ring is parsed in place span by span
  */
-static int slcan_can2ascii(struct slcan_t *slcan_port) {
-    int pos = 0;
-    uint32_t temp = 0;
-    memset(slcan_port->uart_tx_buffer, 0, SLCAN_MTU);
-
-    /* RTR frame */
-    if (slcan_port->can_rx_msg.rtr == true) {
-        if (slcan_port->can_rx_msg.use_ext_id == true) {
-            slcan_port->uart_tx_buffer[pos] = 'R';
-        } else {
-            slcan_port->uart_tx_buffer[pos] = 'r';
-        }
-    } else /* data frame */
-    {
-        if (slcan_port->can_rx_msg.use_ext_id == true) {
-            if (slcan_port->can_rx_msg.bitrate_switch == true)
-                slcan_port->uart_tx_buffer[pos] = 'B';
-            else if (slcan_port->can_rx_msg.canfd_frame == true)
-                slcan_port->uart_tx_buffer[pos] = 'D';
-            else
-                slcan_port->uart_tx_buffer[pos] = 'T';
-        } else {
-            if (slcan_port->can_rx_msg.bitrate_switch == true)
-                slcan_port->uart_tx_buffer[pos] = 'b';
-            else if (slcan_port->can_rx_msg.canfd_frame == true)
-                slcan_port->uart_tx_buffer[pos] = 'd';
-            else
-                slcan_port->uart_tx_buffer[pos] = 't';
-        }
-    }
+void slcan_process_uart(struct slcan_t *slcan_port) {
+    uint8_t *span;
+    uint32_t size;
 
-    pos++;
-    /* id */
-    if (slcan_port->can_rx_msg.use_ext_id == true) {
-        temp = slcan_port->can_rx_msg.ext_id;
-        snprintf((char *)(slcan_port->uart_tx_buffer + pos), 9, "%08X", temp);
-        pos += 8;
-    } else {
-        temp = slcan_port->can_rx_msg.std_id;
-        snprintf((char *)(slcan_port->uart_tx_buffer + pos), 4, "%03X", temp);
-        pos += 3;
+    if (slcan_port->uartdev_sn >= SCLAN_NUM) {
+        return; // user add uart port data read code
     }
-    /* len */
-    slcan_port->uart_tx_buffer[pos] = SLCAN_EncodeDLC(mcan_get_message_size_from_dlc(slcan_port->can_rx_msg.dlc));
-    pos++;
-    /* data */
-    if (slcan_port->can_rx_msg.rtr != true) {
-        for (int i = 0; i < mcan_get_message_size_from_dlc(slcan_port->can_rx_msg.dlc); i++) {
-            snprintf((char *)(slcan_port->uart_tx_buffer + pos), 3, "%02X",
-                     slcan_port->can_rx_msg.data_8[i]);
-            pos += 2;
+    /* at most the part up to the ring end and the wrapped part, more data re-flags the channel */
+    for (uint32_t i = 0; i < 2; i++) {
+        span = usbd_out_linear_read_setup(slcan_port->uartdev_sn, &size);
+        if ((span == NULL) || (size == 0)) {
+            return;
         }
+        slcan_uart_feed(slcan_port, span, size);
+        usbd_out_linear_read_done(slcan_port->uartdev_sn, size);
     }
-    /* timestamp */
+}
 
-    if (slcan_port->set_flag & SLCAN_SFLAG_TIMESTAMP) {
-        uint32_t tick = slcan_port->timestamp;
-        sprintf((char *)(slcan_port->uart_tx_buffer + pos), "%04X",
-                (tick & 0x0000FFFF));
-        pos += 4;
+/**
+ * @brief       can message convert to a binary record
+ * @param[in]   slcan_port : one can port will to be operated
+ * @param[out]  dst : destination, NULL only returns the length
+ * @return      record length
+ * @details     see slcan_bin.h for the layout
+ */
+static uint32_t slcan_can2bin(struct slcan_t *slcan_port, uint8_t *dst) {
+    mcan_rx_message_t *msg = &slcan_port->can_rx_msg;
+    slcan_bin_header_t hdr;
+
+    hdr.flags = (msg->use_ext_id ? SLCAN_BIN_FLAG_EXT : 0) | (msg->rtr ? SLCAN_BIN_FLAG_RTR : 0) |
+                (msg->canfd_frame ? SLCAN_BIN_FLAG_FD : 0) | (msg->bitrate_switch ? SLCAN_BIN_FLAG_BRS : 0);
+    hdr.dlc = msg->dlc;
+    if (dst == NULL) {
+        return slcan_bin_frame_len(&hdr);
     }
-    /* end */
-    slcan_port->uart_tx_buffer[pos] = '\r';
-    pos++;
-    slcan_port->uart_tx_buffer[pos] = 0;
-    return pos;
+    hdr.channel = slcan_port->candev_sn;
+    hdr.id = msg->use_ext_id ? msg->ext_id : msg->std_id;
+    hdr.timestamp_us = slcan_port->can_rx_time_us;
+    return slcan_bin_encode(dst, &hdr, msg->data_8);
 }
 
 /**
  * @brief       can process
  * @param[in]   slcan_port : one can port will to be operated
  * @return
- * @details     can data ---> serial  data
+ * @details     can data ---> serial  data, frames are written in place into the usb tx batch
  */
 void slcan_process_can(struct slcan_t *slcan_port)
 {
-    int read_rc = 0;
-    int tx_len = 0;
-    for (uint8_t i = 0; i < MCAN_RXBUF_SIZE_CAN_DEFAULT; i++) {
-        if (g_mcan_rx_fifo_complete_flag[slcan_port->candev_sn][i]) {
-            can_led(slcan_port->candev_sn, true, true);
-            g_mcan_rx_fifo_complete_flag[slcan_port->candev_sn][i] = 0;
-            read_rc = slcan_can_read(slcan_port, i);
-
-            if (read_rc != sizeof(mcan_rx_message_t)) {
-                return;
-            }
-            tx_len = slcan_can2ascii(slcan_port);
-            if (tx_len <= 0) {
-                return;
+    uint32_t tx_len = 0;
+    uint8_t *dst;
+    uint8_t ts_digits = 0;
+    uint32_t ts = 0;
+    bool binary = (slcan_port->frame_mode == SLCAN_FRAME_BINARY);
+    if (slcan_port->set_flag & SLCAN_SFLAG_TIMESTAMP_US) {
+        ts_digits = 8;
+    } else if (slcan_port->set_flag & SLCAN_SFLAG_TIMESTAMP) {
+        ts_digits = 4;
+    }
+    /* bounded so a flooded bus can not starve the vcom direction */
+    for (uint32_t i = 0; i < MCAN_RX_RING_DEPTH; i++) {
+        if (slcan_can_read(slcan_port) != sizeof(mcan_rx_message_t)) {
+            return;
+        }
+        slcan_led_activity(slcan_port->candev_sn, true);
+        if (binary) {
+            tx_len = slcan_can2bin(slcan_port, NULL);
+        } else {
+            tx_len = slcan_ascii_frame_len(&slcan_port->can_rx_msg, ts_digits);
+        }
+        dst = usbd_tx_batch_reserve(slcan_port->uartdev_sn, tx_len);
+        if (dst != NULL) {
+            if (binary) {
+                tx_len = slcan_can2bin(slcan_port, dst);
+            } else {
+                /* Z1 is milliseconds wrapping at 60000, Z2 the raw microsecond counter */
+                ts = (ts_digits == 8) ? slcan_port->can_rx_time_us : (slcan_port->can_rx_time_us / 1000) % 60000;
+                tx_len = slcan_ascii_encode_frame(dst, &slcan_port->can_rx_msg, ts_digits, ts);
             }
-            // SLCAN_DEBUG("[can%d]>>[com%d]: fifo:%d tx_len:%d\r\n", slcan_port->candev_sn,
-            //             slcan_port->candev_sn, i, tx_len);
-            slcan_uart_write(slcan_port, slcan_port->uart_tx_buffer, tx_len);
-            memset(&slcan_port->can_rx_msg, 0, sizeof(mcan_rx_message_t));
-            can_led(slcan_port->candev_sn, true, false);
+            /* the latency is accounted when the host has taken the batch */
+            usbd_tx_batch_stamp(slcan_port->uartdev_sn, slcan_port->can_rx_time_us);
+            usbd_tx_batch_commit(slcan_port->uartdev_sn, tx_len);
+            slcan_stats_forwarded(slcan_port->candev_sn);
         }
+        // SLCAN_DEBUG("[can%d]>>[com%d]: tx_len:%d\r\n", slcan_port->candev_sn,
+        //             slcan_port->candev_sn, tx_len);
     }
 }
 
@@ -946,6 +942,35 @@ void slcan_process_can(struct slcan_t *slcan_port)
 void slcan_process_task(struct slcan_t *slcan_port) {
     slcan_process_can(slcan_port);  // data from CANFD to VCOM
     slcan_process_uart(slcan_port); // data from VCOM  to CANFD
+    usbd_tx_batch_poll(slcan_port->uartdev_sn); // flush aged VCOM batch
+}
+
+/**
+ * @brief       service the channels that have work
+ * @param[in]
+ * @return      false if no channel was ready, the caller may sleep until the next interrupt
+ * @details     a channel stays ready while it still has queued can frames, vcom bytes
+                or a usb batch waiting for its flush timeout
+ */
+bool slcan_process_ready(void) {
+    uint32_t mask = slcan_event_take();
+    uint32_t ch;
+
+    if (mask == 0) {
+        return false;
+    }
+    for (ch = 0; ch < SCLAN_NUM; ch++) {
+        if ((mask & (1UL << ch)) == 0) {
+            continue;
+        }
+        slcan_process_task(slcan_ports[ch]);
+        if ((spsc_ring_check_empty(&g_mcan_rx_queue[ch].ring) == false) ||
+            (get_usb_out_is_empty(slcan_ports[ch]->uartdev_sn) == false) ||
+            usbd_tx_batch_pending(slcan_ports[ch]->uartdev_sn)) {
+            slcan_event_set(ch);
+        }
+    }
+    return true;
 }
 
 /**
@@ -964,17 +989,21 @@ void slcan_port0_init(void) {
     mcan_get_default_config(slcan->ptr, &slcan->candev_cfg);
     slcan->candev_cfg.enable_canfd = true;
     mcan_get_default_ram_config(slcan->ptr, &slcan->candev_cfg.ram_config, true);
+    slcan_filter_reset(&slcan->filter);
     slcan->candev_oflag = 0; // can hardware switch flag
 
     slcan->uartdev_sn = 0;    // USB VCOM1
     slcan->uartdev_oflag = 0; // uart hardware switch flag
     slcan->uart_rx_len = 0;
+    slcan->uart_rx_discard = 0;
 
     slcan->run_state = 0;
     slcan->run_flag = 0;
     slcan->set_flag = 0;
     slcan->timestamp_isopen = 0;
     slcan->candev_isopen = 0; // cangaroo app switch flag
+    slcan->frame_mode = SLCAN_FRAME_ASCII;
+    slcan->bt_custom = 0;
     mcan_pinmux_init(slcan->candev_sn);
     mcan_channel_init(slcan->candev_sn);
     SLCAN_DEBUG("SLCAN0 Port Init: CAN[%d]<=>VCOM[%d]\r\n", slcan->candev_sn,
@@ -999,15 +1028,19 @@ void slcan_port1_init(void) {
     mcan_get_default_config(slcan->ptr, &slcan->candev_cfg);
     slcan->candev_cfg.enable_canfd = true;
     mcan_get_default_ram_config(slcan->ptr, &slcan->candev_cfg.ram_config, true);
+    slcan_filter_reset(&slcan->filter);
     slcan->uartdev_sn = 1;    // USB VCOM2
     slcan->uartdev_oflag = 0; // uart hardware switch flag
     slcan->uart_rx_len = 0;
+    slcan->uart_rx_discard = 0;
 
     slcan->run_state = 0;
     slcan->run_flag = 0;
     slcan->set_flag = 0;
     slcan->timestamp_isopen = 0;
     slcan->candev_isopen = 0; // cangaroo app switch flag
+    slcan->frame_mode = SLCAN_FRAME_ASCII;
+    slcan->bt_custom = 0;
     mcan_pinmux_init(slcan->candev_sn);
     mcan_channel_init(slcan->candev_sn);
     SLCAN_DEBUG("SLCAN1 Port Init: CAN[%d]<=>VCOM[%d]\r\n", slcan->candev_sn,
@@ -1033,15 +1066,19 @@ void slcan_port2_init(void) {
     mcan_get_default_config(slcan->ptr, &slcan->candev_cfg);
     slcan->candev_cfg.enable_canfd = true;
     mcan_get_default_ram_config(slcan->ptr, &slcan->candev_cfg.ram_config, true);
+    slcan_filter_reset(&slcan->filter);
     slcan->uartdev_sn = 2;    // USB VCOM3
     slcan->uartdev_oflag = 0; // uart hardware switch flag
     slcan->uart_rx_len = 0;
+    slcan->uart_rx_discard = 0;
 
     slcan->run_state = 0;
     slcan->run_flag = 0;
     slcan->set_flag = 0;
     slcan->timestamp_isopen = 0;
     slcan->candev_isopen = 0; // cangaroo app switch flag
+    slcan->frame_mode = SLCAN_FRAME_ASCII;
+    slcan->bt_custom = 0;
     mcan_pinmux_init(slcan->candev_sn);
     mcan_channel_init(slcan->candev_sn);
     SLCAN_DEBUG("SLCAN2 Port Init: CAN[%d]<=>VCOM[%d]\r\n", slcan->candev_sn,
@@ -1067,15 +1104,19 @@ void slcan_port3_init(void) {
     mcan_get_default_config(slcan->ptr, &slcan->candev_cfg);
     slcan->candev_cfg.enable_canfd = true;
     mcan_get_default_ram_config(slcan->ptr, &slcan->candev_cfg.ram_config, true);
+    slcan_filter_reset(&slcan->filter);
     slcan->uartdev_sn = 3;    // USB VCOM4
     slcan->uartdev_oflag = 0; // uart hardware switch flag
     slcan->uart_rx_len = 0;
+    slcan->uart_rx_discard = 0;
 
     slcan->run_state = 0;
     slcan->run_flag = 0;
     slcan->set_flag = 0;
     slcan->timestamp_isopen = 0;
     slcan->candev_isopen = 0; // cangaroo app switch flag
+    slcan->frame_mode = SLCAN_FRAME_ASCII;
+    slcan->bt_custom = 0;
     mcan_pinmux_init(slcan->candev_sn);
     mcan_channel_init(slcan->candev_sn);
     SLCAN_DEBUG("SLCAN3 Port Init: CAN[%d]<=>VCOM[%d]\r\n", slcan->candev_sn,
@@ -1091,6 +1132,7 @@ void slcan_port3_init(void) {
  * @details
  */
 void slcan_init(void) {
+    slcan_replay_init();
 #if (SCLAN_NUM >= 1)
     slcan_port0_init();
 #endif
@@ -1104,29 +1146,3 @@ void slcan_init(void) {
     slcan_port3_init();
 #endif
 }
-
-/**
- * @brief      slcan  timestamp  increase
- * @param[in]
- * @return
- * @details
- */
-void slcan_timestamp(void) {
-
-#if (SCLAN_NUM >= 1)
-    if (slcan0.timestamp_isopen)
-        slcan0.timestamp++;
-#endif
-#if (SCLAN_NUM >= 2)
-    if (slcan1.timestamp_isopen)
-        slcan1.timestamp++;
-#endif
-#if (SCLAN_NUM >= 3)
-    if (slcan2.timestamp_isopen)
-        slcan2.timestamp++;
-#endif
-#if (SCLAN_NUM >= 4)
-    if (slcan3.timestamp_isopen)
-        slcan3.timestamp++;
-#endif
-}
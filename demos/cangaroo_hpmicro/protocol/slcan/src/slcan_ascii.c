@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "string.h"
+#include "slcan_ascii.h"
+
+/* "00" "01" ... "FF", pair n starts at index 2 * n */
+static const char slcan_hex_pairs[] =
+    "000102030405060708090A0B0C0D0E0F"
+    "101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F"
+    "303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F"
+    "505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F"
+    "707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F"
+    "909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+    "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+    "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+    "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+/* valid digits carry bit 4 so an invalid one is detected without branching */
+#define SLCAN_NIBBLE_VALID 0x10
+static const uint8_t slcan_nibble_table[256] = {
+    ['0'] = 0x10, ['1'] = 0x11, ['2'] = 0x12, ['3'] = 0x13, ['4'] = 0x14,
+    ['5'] = 0x15, ['6'] = 0x16, ['7'] = 0x17, ['8'] = 0x18, ['9'] = 0x19,
+    ['A'] = 0x1A, ['B'] = 0x1B, ['C'] = 0x1C, ['D'] = 0x1D, ['E'] = 0x1E, ['F'] = 0x1F,
+    ['a'] = 0x1A, ['b'] = 0x1B, ['c'] = 0x1C, ['d'] = 0x1D, ['e'] = 0x1E, ['f'] = 0x1F,
+};
+
+/* SLCAN frame type indexed by [use_ext_id][rtr << 2 | bitrate_switch << 1 | canfd_frame] */
+static const uint8_t slcan_frame_type[2][8] = {
+    { 't', 'd', 'b', 'b', 'r', 'r', 'r', 'r' },
+    { 'T', 'D', 'B', 'B', 'R', 'R', 'R', 'R' },
+};
+
+uint8_t *slcan_ascii_put_hex(uint8_t *dst, uint32_t value, uint8_t digits)
+{
+    uint8_t *end = dst + digits;
+    uint8_t *pos = end;
+
+    /* two digits per lookup, from the least significant end */
+    while ((pos - dst) >= 2) {
+        pos -= 2;
+        pos[0] = slcan_hex_pairs[(value & 0xFF) * 2];
+        pos[1] = slcan_hex_pairs[(value & 0xFF) * 2 + 1];
+        value >>= 8;
+    }
+    if (pos != dst) {
+        dst[0] = slcan_hex_pairs[(value & 0x0F) * 2 + 1];
+    }
+    return end;
+}
+
+bool slcan_ascii_get_hex(const uint8_t *src, uint8_t digits, uint32_t *value)
+{
+    uint32_t result = 0;
+    uint8_t valid = SLCAN_NIBBLE_VALID;
+    uint8_t nibble;
+
+    for (uint8_t i = 0; i < digits; i++) {
+        nibble = slcan_nibble_table[src[i]];
+        valid &= nibble;
+        result = (result << 4) | (nibble & 0x0F);
+    }
+    *value = result;
+    return valid != 0;
+}
+
+bool slcan_ascii_get_bytes(const uint8_t *src, uint8_t *data, uint32_t len)
+{
+    uint8_t valid = SLCAN_NIBBLE_VALID;
+    uint8_t high, low;
+
+    for (uint32_t i = 0; i < len; i++) {
+        high = slcan_nibble_table[src[i * 2]];
+        low = slcan_nibble_table[src[i * 2 + 1]];
+        valid &= high & low;
+        data[i] = (uint8_t)((high << 4) | (low & 0x0F));
+    }
+    return valid != 0;
+}
+
+uint32_t slcan_ascii_frame_len(const mcan_rx_message_t *msg, uint8_t ts_digits)
+{
+    uint32_t len = 1 + 1 + 1; /* type + dlc + '\r' */
+    len += msg->use_ext_id ? 8 : 3;
+    len += msg->rtr ? 0 : (slcan_dlc_to_size[msg->dlc] * 2);
+    len += ts_digits;
+    return len;
+}
+
+uint32_t slcan_ascii_encode_frame(uint8_t *dst, const mcan_rx_message_t *msg, uint8_t ts_digits, uint32_t timestamp)
+{
+    uint8_t *pos = dst;
+    uint32_t size;
+
+    *pos++ = slcan_frame_type[msg->use_ext_id][(msg->rtr << 2) | (msg->bitrate_switch << 1) | msg->canfd_frame];
+    if (msg->use_ext_id) {
+        pos = slcan_ascii_put_hex(pos, msg->ext_id, 8);
+    } else {
+        pos = slcan_ascii_put_hex(pos, msg->std_id, 3);
+    }
+    /* the SLCAN dlc character is the hex digit of the dlc code */
+    *pos++ = slcan_hex_pairs[msg->dlc * 2 + 1];
+    if (!msg->rtr) {
+        size = slcan_dlc_to_size[msg->dlc];
+        for (uint32_t i = 0; i < size; i++) {
+            pos[0] = slcan_hex_pairs[msg->data_8[i] * 2];
+            pos[1] = slcan_hex_pairs[msg->data_8[i] * 2 + 1];
+            pos += 2;
+        }
+    }
+    if (ts_digits != 0) {
+        pos = slcan_ascii_put_hex(pos, timestamp, ts_digits);
+    }
+    *pos++ = '\r';
+    return (uint32_t)(pos - dst);
+}
+
+uint32_t slcan_ascii_decode_frame(const uint8_t *src, uint32_t len, mcan_tx_frame_t *frame)
+{
+    uint8_t type = src[0];
+    bool ext = (type == 'T') || (type == 'D') || (type == 'B') || (type == 'R');
+    uint32_t id_digits = ext ? 8 : 3;
+    uint32_t frame_len = 1 + id_digits + 1;
+    uint32_t dlc;
+    uint32_t id;
+    uint32_t size;
+
+    switch (type) {
+    case 't': case 'd': case 'b': case 'r':
+    case 'T': case 'D': case 'B': case 'R':
+        break;
+    default:
+        return 0;
+    }
+    memset(frame, 0, sizeof(*frame));
+    if ((len < frame_len) || (slcan_ascii_get_hex(src + 1 + id_digits, 1, &dlc) == false) ||
+        (slcan_ascii_get_hex(src + 1, id_digits, &id) == false) || (id > (ext ? 0x1FFFFFFFUL : 0x7FFUL))) {
+        return 0;
+    }
+    frame->dlc = dlc;
+    frame->use_ext_id = ext;
+    if (ext) {
+        frame->ext_id = id;
+    } else {
+        frame->std_id = id;
+    }
+    if ((type == 'r') || (type == 'R')) {
+        frame->rtr = true;
+        return frame_len;
+    }
+    frame->canfd_frame = (type != 't') && (type != 'T');
+    frame->bitrate_switch = (type == 'b') || (type == 'B');
+    size = slcan_dlc_to_size[dlc];
+    if ((len < frame_len + size * 2) || (slcan_ascii_get_bytes(src + frame_len, frame->data_8, size) == false)) {
+        return 0;
+    }
+    return frame_len + size * 2;
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "slcan_bittiming.h"
+
+/* NBTP: NBRP 1~512, NTSEG1 2~256 (+ sync), NTSEG2 2~128, NSJW 1~128 */
+const slcan_bt_limits_t slcan_bt_mcan_nominal = {
+    .prescaler_min = 1,
+    .prescaler_max = 512,
+    .seg1_min = 3,
+    .seg1_max = 257,
+    .seg2_min = 2,
+    .seg2_max = 128,
+    .sjw_max = 128,
+    .tdco_max = 0,
+};
+
+/* DBTP: DBRP 1~32, DTSEG1 1~32 (+ sync), DTSEG2 1~16, DSJW 1~16, TDCR.TDCO 0~127 */
+const slcan_bt_limits_t slcan_bt_mcan_data = {
+    .prescaler_min = 1,
+    .prescaler_max = 32,
+    .seg1_min = 2,
+    .seg1_max = 33,
+    .seg2_min = 1,
+    .seg2_max = 16,
+    .sjw_max = 16,
+    .tdco_max = 127,
+};
+
+static uint32_t slcan_bt_abs_diff(uint32_t a, uint32_t b)
+{
+    return (a > b) ? (a - b) : (b - a);
+}
+
+/* split tq quanta at the sample point, false if the limits do not allow any split */
+static bool slcan_bt_split(uint32_t tq, uint16_t sample_point, const slcan_bt_limits_t *limits, uint32_t *seg1)
+{
+    uint32_t s1 = (tq * sample_point + 500U) / 1000U;
+
+    if ((tq - s1) < limits->seg2_min) {
+        s1 = tq - limits->seg2_min;
+    }
+    if ((tq - s1) > limits->seg2_max) {
+        s1 = tq - limits->seg2_max;
+    }
+    if ((s1 < limits->seg1_min) || (s1 > limits->seg1_max)) {
+        return false;
+    }
+    *seg1 = s1;
+    return true;
+}
+
+bool slcan_bt_solve(uint32_t clock_hz, uint32_t bitrate, uint16_t sample_point, bool data_phase,
+                    const slcan_bt_limits_t *limits, slcan_bt_timing_t *timing)
+{
+    uint32_t tq_min = limits->seg1_min + limits->seg2_min;
+    uint32_t tq_max = limits->seg1_max + limits->seg2_max;
+    uint32_t best_rate_err = UINT32_MAX;
+    uint32_t best_sp_err = UINT32_MAX;
+    uint32_t best_pre = 0;
+    uint32_t best_tq = 0;
+    uint32_t best_seg1 = 0;
+    uint32_t tdco;
+
+    if ((clock_hz == 0) || (bitrate == 0)) {
+        return false;
+    }
+    if (sample_point == 0) {
+        sample_point = data_phase ? SLCAN_BT_DATA_SP : SLCAN_BT_NOMINAL_SP;
+    }
+    if (sample_point >= 1000U) {
+        return false;
+    }
+    for (uint32_t pre = limits->prescaler_min; pre <= limits->prescaler_max; pre++) {
+        uint64_t div = (uint64_t)pre * bitrate;
+        uint32_t tq = (uint32_t)((clock_hz + div / 2) / div);
+        uint32_t achieved;
+        uint32_t rate_err;
+        uint32_t sp_err;
+        uint32_t seg1;
+
+        if (tq < tq_min) {
+            break;  /* only gets shorter with larger prescalers */
+        }
+        if ((tq > tq_max) || (slcan_bt_split(tq, sample_point, limits, &seg1) == false)) {
+            continue;
+        }
+        achieved = clock_hz / (pre * tq);
+        rate_err = (uint32_t)(((uint64_t)slcan_bt_abs_diff(achieved, bitrate) * 1000000U) / bitrate);
+        sp_err = slcan_bt_abs_diff((seg1 * 1000U + tq / 2) / tq, sample_point);
+        if ((rate_err < best_rate_err) || ((rate_err == best_rate_err) && (sp_err < best_sp_err))) {
+            best_rate_err = rate_err;
+            best_sp_err = sp_err;
+            best_pre = pre;
+            best_tq = tq;
+            best_seg1 = seg1;
+        }
+    }
+    if ((best_pre == 0) || (best_rate_err > SLCAN_BT_MAX_ERROR_PPM)) {
+        return false;
+    }
+
+    timing->prescaler = best_pre;
+    timing->seg1 = best_seg1;
+    timing->seg2 = best_tq - best_seg1;
+    /* widest resynchronisation jump the phase buffer after the sample point allows */
+    timing->sjw = (timing->seg2 < limits->sjw_max) ? timing->seg2 : limits->sjw_max;
+    timing->bitrate = clock_hz / (best_pre * best_tq);
+    timing->sample_point = (best_seg1 * 1000U + best_tq / 2) / best_tq;
+
+    /*
+     * At high data rates the transceiver loop delay exceeds the sample point, the
+     * transmitter then checks its own bits at the measured delay plus this offset.
+     * Put the secondary sample point where the primary one is within the bit.
+     */
+    timing->tdc_enable = data_phase && (limits->tdco_max != 0) && (bitrate >= SLCAN_BT_TDC_MIN_RATE);
+    tdco = timing->tdc_enable ? (best_pre * best_seg1) : 0;
+    timing->tdc_offset = (tdco > limits->tdco_max) ? limits->tdco_max : tdco;
+    return true;
+}
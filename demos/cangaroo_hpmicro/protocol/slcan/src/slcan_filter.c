@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "string.h"
+#include "slcan_filter.h"
+
+static void slcan_filter_elem_set(mcan_filter_elem_t *elem, bool ext, uint32_t id, uint32_t mask)
+{
+    memset(elem, 0, sizeof(*elem));
+    elem->filter_type = MCAN_FILTER_TYPE_CLASSIC_FILTER;
+    elem->filter_config = MCAN_FILTER_ELEM_CFG_STORE_IN_RX_FIFO0_IF_MATCH;
+    elem->can_id_type = ext ? MCAN_CAN_ID_TYPE_EXTENDED : MCAN_CAN_ID_TYPE_STANDARD;
+    elem->sync_message = 0U;
+    elem->filter_id = id;
+    elem->filter_mask = mask;
+}
+
+static void slcan_filter_clear_rules(slcan_filter_t *filter)
+{
+    /* zeroed elements are MCAN_FILTER_ELEM_CFG_DISABLED */
+    memset(filter->std_elem, 0, sizeof(filter->std_elem));
+    memset(filter->ext_elem, 0, sizeof(filter->ext_elem));
+    filter->std_count = 0;
+    filter->ext_count = 0;
+}
+
+/* turn the SJA1000 code/mask pair into one standard and one extended rule */
+static void slcan_filter_update_acceptance(slcan_filter_t *filter)
+{
+    uint32_t code = filter->acc_code;
+    uint32_t dont_care = filter->acc_mask;
+
+    slcan_filter_clear_rules(filter);
+    filter->acc_rules = true;
+    if (dont_care == 0xFFFFFFFFUL) {
+        return;
+    }
+    slcan_filter_elem_set(&filter->std_elem[0], false, (code >> 21) & 0x7FFUL, ~(dont_care >> 21) & 0x7FFUL);
+    slcan_filter_elem_set(&filter->ext_elem[0], true, (code >> 3) & 0x1FFFFFFFUL, ~(dont_care >> 3) & 0x1FFFFFFFUL);
+    filter->std_count = 1;
+    filter->ext_count = 1;
+}
+
+/* J rules never mix with the element 0 rules left by m/M */
+static void slcan_filter_take_rules(slcan_filter_t *filter)
+{
+    if (filter->acc_rules) {
+        slcan_filter_clear_rules(filter);
+        filter->acc_rules = false;
+    }
+}
+
+void slcan_filter_reset(slcan_filter_t *filter)
+{
+    filter->acc_code = 0;
+    filter->acc_mask = 0xFFFFFFFFUL;
+    filter->acc_rules = false;
+    slcan_filter_clear_rules(filter);
+}
+
+void slcan_filter_set_code(slcan_filter_t *filter, uint32_t code)
+{
+    filter->acc_code = code;
+    slcan_filter_update_acceptance(filter);
+}
+
+void slcan_filter_set_mask(slcan_filter_t *filter, uint32_t mask)
+{
+    filter->acc_mask = mask;
+    slcan_filter_update_acceptance(filter);
+}
+
+bool slcan_filter_set_rule(slcan_filter_t *filter, bool ext, uint8_t index, uint32_t id, uint32_t mask)
+{
+    if (ext) {
+        if ((index >= SLCAN_FILTER_EXT_MAX) || (id > 0x1FFFFFFFUL)) {
+            return false;
+        }
+        slcan_filter_take_rules(filter);
+        slcan_filter_elem_set(&filter->ext_elem[index], true, id, mask & 0x1FFFFFFFUL);
+        if (index >= filter->ext_count) {
+            filter->ext_count = index + 1;
+        }
+    } else {
+        if ((index >= SLCAN_FILTER_STD_MAX) || (id > 0x7FFUL)) {
+            return false;
+        }
+        slcan_filter_take_rules(filter);
+        slcan_filter_elem_set(&filter->std_elem[index], false, id, mask & 0x7FFUL);
+        if (index >= filter->std_count) {
+            filter->std_count = index + 1;
+        }
+    }
+    return true;
+}
+
+void slcan_filter_apply(slcan_filter_t *filter, mcan_config_t *config)
+{
+    mcan_all_filters_config_t *all = &config->all_filters_config;
+    bool active = (filter->std_count != 0) || (filter->ext_count != 0);
+    uint8_t option = active ? MCAN_ACCEPT_NON_MATCHING_FRAME_OPTION_REJECT : MCAN_ACCEPT_NON_MATCHING_FRAME_OPTION_IN_RXFIFO0;
+
+    all->global_filter_config.accept_non_matching_std_frame_option = option;
+    all->global_filter_config.accept_non_matching_ext_frame_option = option;
+    all->global_filter_config.reject_remote_std_frame = false;
+    all->global_filter_config.reject_remote_ext_frame = false;
+    all->ext_id_mask = 0x1FFFFFFFUL;
+    all->std_id_filter_list.mcan_filter_elem_count = filter->std_count;
+    all->std_id_filter_list.filter_elem_list = filter->std_elem;
+    all->ext_id_filter_list.mcan_filter_elem_count = filter->ext_count;
+    all->ext_id_filter_list.filter_elem_list = filter->ext_elem;
+    config->ram_config.enable_std_filter = (filter->std_count != 0);
+    config->ram_config.std_filter_elem_count = filter->std_count;
+    config->ram_config.enable_ext_filter = (filter->ext_count != 0);
+    config->ram_config.ext_filter_elem_count = filter->ext_count;
+}
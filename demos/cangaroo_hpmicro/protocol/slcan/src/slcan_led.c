@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "slcan_led.h"
+#include "slcan.h"
+#include "WS2812.h"
+#include "hpm_common.h"
+#include "hpm_clock_drv.h"
+#include "hpm_csr_drv.h"
+
+volatile uint32_t g_slcan_led_activity;
+
+#if USE_RGB_LED
+typedef struct
+{
+    uint8_t can_channel;
+    uint8_t read_rgb_index;
+    uint8_t write_rgb_index;
+} can_rgb_index_t;
+
+static const can_rgb_index_t can_rgb_index_table[SCLAN_NUM] =
+{
+    {0, 7, 8},
+    {1, 6, 5},
+    {2, 4, 3},
+    {3, 2, 1},
+};
+
+static uint32_t slcan_led_shown;      /* activity bits on the strip */
+static bool slcan_led_dirty;          /* pixels changed, not yet sent */
+static uint64_t slcan_led_next_cycle; /* next render */
+
+bool slcan_led_poll(void)
+{
+    uint64_t now = hpm_csr_get_core_cycle();
+    uint32_t active;
+
+    if (now >= slcan_led_next_cycle) {
+        slcan_led_next_cycle = now + hpm_core_clock / SLCAN_LED_REFRESH_HZ;
+        active = __atomic_exchange_n(&g_slcan_led_activity, 0, __ATOMIC_RELAXED);
+        if (active != slcan_led_shown) {
+            for (uint32_t ch = 0; ch < SCLAN_NUM; ch++) {
+                const can_rgb_index_t *led = &can_rgb_index_table[ch];
+                WS2812_SetPixel(led->read_rgb_index, (active & (1UL << (ch * 2))) ? 0x0F : 0, 0, 0);
+                WS2812_SetPixel(led->write_rgb_index, 0, 0, (active & (1UL << (ch * 2 + 1))) ? 0x0F : 0);
+            }
+            slcan_led_shown = active;
+            slcan_led_dirty = true;
+        }
+    }
+    /* a refresh still clocking out is left alone, the picture goes out with the next poll */
+    if (slcan_led_dirty && !WS2812_IsBusy()) {
+        WS2812_Update(false);
+        slcan_led_dirty = false;
+    }
+    return (slcan_led_shown != 0) || slcan_led_dirty || (g_slcan_led_activity != 0);
+}
+#else
+bool slcan_led_poll(void)
+{
+    return false;
+}
+#endif
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "stdio.h"
+#include "slcan_replay.h"
+#include "slcan.h"
+#include "mcan.h"
+#include "board.h"
+#include "hpm_clock_drv.h"
+#include "hpm_csr_drv.h"
+#include "hpm_interrupt.h"
+
+/* the timer is armed this much before an entry is due, the rest is waited out in the handler */
+#define SLCAN_REPLAY_LEAD_US      (2U)
+/* longest single timer period, longer delays take several wake ups */
+#define SLCAN_REPLAY_MAX_WAIT_US  (1000000U)
+/* entries handled per interrupt before yielding, bounds a list of zero delays on closed channels */
+#define SLCAN_REPLAY_BURST        (64U)
+
+typedef struct {
+    slcan_replay_entry_t entries[SLCAN_REPLAY_DEPTH];
+    uint32_t count;
+    uint32_t loops;               /* requested passes, 0 forever */
+    volatile uint8_t state;       /* enum slcan_replay_state */
+
+    /* owned by slcan_replay_isr() while running */
+    uint32_t index;               /* next entry to send */
+    uint32_t loop;                /* completed passes */
+    uint64_t due_cycle;           /* core cycle at which entries[index] is due */
+    uint32_t cycles_per_us;
+    uint32_t ticks_per_us;        /* GPTMR ticks */
+
+    /* written by slcan_replay_isr() only */
+    volatile uint32_t sent;
+    volatile uint32_t skipped;    /* target channel closed */
+    volatile uint32_t retries;    /* target TX FIFO full */
+    volatile uint32_t late_max_us;
+} slcan_replay_t;
+
+static slcan_replay_t g_slcan_replay;
+static struct slcan_t *const slcan_replay_ports[CANFD_NUM] = { &slcan0, &slcan1, &slcan2, &slcan3 };
+
+static void slcan_replay_arm(slcan_replay_t *replay, uint32_t delay_us)
+{
+    uint32_t reload;
+
+    if (delay_us > SLCAN_REPLAY_MAX_WAIT_US) {
+        delay_us = SLCAN_REPLAY_MAX_WAIT_US;
+    }
+    reload = delay_us * replay->ticks_per_us;
+    if (reload == 0) {
+        reload = 1;
+    }
+    gptmr_channel_config_update_reload(SLCAN_REPLAY_GPTMR, SLCAN_REPLAY_GPTMR_CH, reload);
+    gptmr_channel_update_count(SLCAN_REPLAY_GPTMR, SLCAN_REPLAY_GPTMR_CH, 0);
+}
+
+static void slcan_replay_halt(void)
+{
+    gptmr_stop_counter(SLCAN_REPLAY_GPTMR, SLCAN_REPLAY_GPTMR_CH);
+    gptmr_disable_irq(SLCAN_REPLAY_GPTMR, GPTMR_CH_RLD_IRQ_MASK(SLCAN_REPLAY_GPTMR_CH));
+    gptmr_clear_status(SLCAN_REPLAY_GPTMR, GPTMR_CH_RLD_STAT_MASK(SLCAN_REPLAY_GPTMR_CH));
+}
+
+void slcan_replay_isr(void)
+{
+    slcan_replay_t *replay = &g_slcan_replay;
+    slcan_replay_entry_t *entry;
+    uint64_t now;
+    uint32_t wait_us;
+    uint32_t late_us;
+
+    if (!gptmr_check_status(SLCAN_REPLAY_GPTMR, GPTMR_CH_RLD_STAT_MASK(SLCAN_REPLAY_GPTMR_CH))) {
+        return;
+    }
+    gptmr_clear_status(SLCAN_REPLAY_GPTMR, GPTMR_CH_RLD_STAT_MASK(SLCAN_REPLAY_GPTMR_CH));
+    if (replay->state != SLCAN_REPLAY_RUNNING) {
+        return;
+    }
+    for (uint32_t burst = 0; burst < SLCAN_REPLAY_BURST; burst++) {
+        now = hpm_csr_get_core_cycle();
+        if (now < replay->due_cycle) {
+            wait_us = (uint32_t)((replay->due_cycle - now) / replay->cycles_per_us);
+            if (wait_us > SLCAN_REPLAY_LEAD_US) {
+                slcan_replay_arm(replay, wait_us - SLCAN_REPLAY_LEAD_US);
+                return;
+            }
+            /* less than the lead left, wait it out for sub-microsecond accuracy */
+            while ((now = hpm_csr_get_core_cycle()) < replay->due_cycle) {
+            }
+        }
+        entry = &replay->entries[replay->index];
+        if (slcan_replay_ports[entry->channel]->candev_isopen == 0) {
+            replay->skipped++;
+        } else if (mcan_tx_send_now(entry->channel, &entry->frame) == false) {
+            /* keep the entry, the following ones stay on their own schedule */
+            replay->retries++;
+            slcan_replay_arm(replay, SLCAN_REPLAY_RETRY_US);
+            return;
+        } else {
+            replay->sent++;
+            late_us = (uint32_t)((now - replay->due_cycle) / replay->cycles_per_us);
+            if (late_us > replay->late_max_us) {
+                replay->late_max_us = late_us;
+            }
+        }
+        if (++replay->index >= replay->count) {
+            replay->index = 0;
+            replay->loop++;
+            if ((replay->loops != 0) && (replay->loop >= replay->loops)) {
+                slcan_replay_halt();
+                replay->state = SLCAN_REPLAY_DONE;
+                return;
+            }
+        }
+        replay->due_cycle += (uint64_t)replay->entries[replay->index].delta_us * replay->cycles_per_us;
+    }
+    /* burst limit hit, come back right away */
+    slcan_replay_arm(replay, 0);
+}
+SDK_DECLARE_EXT_ISR_M(SLCAN_REPLAY_GPTMR_IRQ, slcan_replay_isr);
+
+void slcan_replay_init(void)
+{
+    clock_add_to_group(SLCAN_REPLAY_GPTMR_CLOCK, BOARD_RUNNING_CORE & 0x1);
+    g_slcan_replay.count = 0;
+    g_slcan_replay.state = SLCAN_REPLAY_IDLE;
+}
+
+bool slcan_replay_clear(void)
+{
+    if (g_slcan_replay.state == SLCAN_REPLAY_RUNNING) {
+        return false;
+    }
+    g_slcan_replay.count = 0;
+    g_slcan_replay.state = SLCAN_REPLAY_IDLE;
+    return true;
+}
+
+bool slcan_replay_append(uint32_t delta_us, uint8_t channel, const mcan_tx_frame_t *frame)
+{
+    slcan_replay_entry_t *entry;
+
+    if ((g_slcan_replay.state == SLCAN_REPLAY_RUNNING) || (g_slcan_replay.count >= SLCAN_REPLAY_DEPTH) ||
+        (channel >= CANFD_NUM)) {
+        return false;
+    }
+    entry = &g_slcan_replay.entries[g_slcan_replay.count++];
+    entry->delta_us = delta_us;
+    entry->channel = channel;
+    entry->frame = *frame;
+    return true;
+}
+
+bool slcan_replay_start(uint32_t loops)
+{
+    slcan_replay_t *replay = &g_slcan_replay;
+    gptmr_channel_config_t config;
+
+    if ((replay->state == SLCAN_REPLAY_RUNNING) || (replay->count == 0)) {
+        return false;
+    }
+    replay->cycles_per_us = (hpm_core_clock + 1000000 - 1U) / 1000000;
+    replay->ticks_per_us = clock_get_frequency(SLCAN_REPLAY_GPTMR_CLOCK) / 1000000;
+    replay->loops = loops;
+    replay->loop = 0;
+    replay->index = 0;
+    replay->sent = 0;
+    replay->skipped = 0;
+    replay->retries = 0;
+    replay->late_max_us = 0;
+    replay->due_cycle = hpm_csr_get_core_cycle() + (uint64_t)replay->entries[0].delta_us * replay->cycles_per_us;
+
+    /* the first period is short, the handler then arms the timer for the first entry */
+    gptmr_channel_get_default_config(SLCAN_REPLAY_GPTMR, &config);
+    config.reload = replay->ticks_per_us;
+    gptmr_channel_config(SLCAN_REPLAY_GPTMR, SLCAN_REPLAY_GPTMR_CH, &config, false);
+    gptmr_enable_irq(SLCAN_REPLAY_GPTMR, GPTMR_CH_RLD_IRQ_MASK(SLCAN_REPLAY_GPTMR_CH));
+    replay->state = SLCAN_REPLAY_RUNNING;
+    intc_m_enable_irq_with_priority(SLCAN_REPLAY_GPTMR_IRQ, SLCAN_REPLAY_IRQ_PRIORITY);
+    gptmr_start_counter(SLCAN_REPLAY_GPTMR, SLCAN_REPLAY_GPTMR_CH);
+    gptmr_channel_reset_count(SLCAN_REPLAY_GPTMR, SLCAN_REPLAY_GPTMR_CH);
+    return true;
+}
+
+void slcan_replay_stop(void)
+{
+    uint32_t level = disable_global_irq(CSR_MSTATUS_MIE_MASK);
+    slcan_replay_halt();
+    g_slcan_replay.state = SLCAN_REPLAY_IDLE;
+    restore_global_irq(level);
+}
+
+uint8_t slcan_replay_get_state(void)
+{
+    return g_slcan_replay.state;
+}
+
+uint32_t slcan_replay_format(char *buf, uint32_t size)
+{
+    slcan_replay_t *replay = &g_slcan_replay;
+    int len;
+
+    len = snprintf(buf, size, "state=%u,count=%u,index=%u,loop=%u,sent=%u,skip=%u,retry=%u,latemax=%u",
+                   (unsigned int)replay->state, (unsigned int)replay->count, (unsigned int)replay->index,
+                   (unsigned int)replay->loop, (unsigned int)replay->sent, (unsigned int)replay->skipped,
+                   (unsigned int)replay->retries, (unsigned int)replay->late_max_us);
+    if (len < 0) {
+        return 0;
+    }
+    return ((uint32_t)len < size) ? (uint32_t)len : size;
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "stdio.h"
+#include "slcan_stats.h"
+#include "slcan_dlc.h"
+#include "mcan.h"
+#include "cdc_acm.h"
+#include "hpm_clock_drv.h"
+#include "hpm_csr_drv.h"
+
+slcan_stats_t g_slcan_stats[SLCAN_STATS_CHANNELS];
+
+/*
+ * Frame length without stuff bits.
+ * Classic: SOF, id, control, data, crc, delimiters, ack, EOF and intermission.
+ * FD with BRS: from ESI to the crc delimiter is sent at the data phase rate.
+ * A classic frame never carries more than 8 bytes, dlc 9 ~ 15 included.
+ */
+static void slcan_stats_frame_bits(bool ext, bool rtr, bool fd, bool brs, uint8_t dlc, uint32_t *nominal, uint32_t *data)
+{
+    uint32_t size = rtr ? 0 : slcan_dlc_to_size[dlc & 0x0F];
+    uint32_t arbitration = ext ? 38 : 19;  /* SOF .. BRS / r0 */
+    uint32_t tail = 12;                    /* ack, EOF, intermission */
+    uint32_t phase;
+
+    if (fd) {
+        /* ESI, DLC, data, stuff count, crc17/21, crc delimiter */
+        phase = 1 + 4 + size * 8 + 4 + ((size > 16) ? 21 : 17) + 1;
+    } else {
+        /* DLC, data, crc15, crc delimiter */
+        if (size > 8) {
+            size = 8;
+        }
+        phase = 4 + size * 8 + 15 + 1;
+    }
+    if (fd && brs) {
+        *nominal = arbitration + tail;
+        *data = phase;
+    } else {
+        *nominal = arbitration + phase + tail;
+        *data = 0;
+    }
+}
+
+void slcan_stats_isr_rx(uint8_t channel, const mcan_rx_message_t *msg)
+{
+    slcan_stats_t *stats = &g_slcan_stats[channel];
+    uint32_t nominal;
+    uint32_t data;
+
+    slcan_stats_frame_bits(msg->use_ext_id, msg->rtr, msg->canfd_frame, msg->bitrate_switch, msg->dlc, &nominal, &data);
+    stats->rx_frames++;
+    stats->rx_nominal_bits += nominal;
+    stats->rx_data_bits += data;
+}
+
+void slcan_stats_delivered(uint8_t channel, uint32_t frames, uint32_t latency_us)
+{
+    slcan_stats_t *stats = &g_slcan_stats[channel];
+    uint32_t bucket;
+
+    bucket = (latency_us == 0) ? 0 : (32 - __builtin_clz(latency_us));
+    if (bucket >= SLCAN_STATS_LAT_BUCKETS) {
+        bucket = SLCAN_STATS_LAT_BUCKETS - 1;
+    }
+    stats->latency_hist[bucket] += frames;
+    if (latency_us > stats->latency_max_us) {
+        stats->latency_max_us = latency_us;
+    }
+}
+
+void slcan_stats_tx(uint8_t channel, const mcan_tx_frame_t *frame)
+{
+    slcan_stats_t *stats = &g_slcan_stats[channel];
+    uint32_t nominal;
+    uint32_t data;
+
+    slcan_stats_frame_bits(frame->use_ext_id, frame->rtr, frame->canfd_frame, frame->bitrate_switch, frame->dlc,
+                           &nominal, &data);
+    stats->tx_frames++;
+    stats->tx_nominal_bits += nominal;
+    stats->tx_data_bits += data;
+}
+
+uint32_t slcan_stats_format(uint8_t channel, MCAN_Type *base, const mcan_config_t *config, char *buf, uint32_t size)
+{
+    slcan_stats_t *stats = &g_slcan_stats[channel];
+    uint32_t ticks_per_us = (hpm_core_clock + 1000000 - 1U) / 1000000;
+    uint64_t now = hpm_csr_get_core_cycle();
+    uint64_t elapsed_us = (now - stats->last_cycle) / ticks_per_us;
+    uint32_t rx_frames;
+    uint64_t nominal_bits;
+    uint64_t data_bits;
+    uint32_t level;
+    uint64_t busy_us = 0;
+    uint32_t rx_ps = 0;
+    uint32_t tx_ps = 0;
+    uint32_t load = 0; /* permille */
+    int len;
+
+    /* the isr counters are 64 bit, read them in one piece */
+    level = disable_global_irq(CSR_MSTATUS_MIE_MASK);
+    rx_frames = stats->rx_frames;
+    nominal_bits = stats->rx_nominal_bits;
+    data_bits = stats->rx_data_bits;
+    restore_global_irq(level);
+    nominal_bits += stats->tx_nominal_bits;
+    data_bits += stats->tx_data_bits;
+
+    if (elapsed_us != 0) {
+        rx_ps = (uint32_t)(((uint64_t)(rx_frames - stats->last_rx_frames) * 1000000U) / elapsed_us);
+        tx_ps = (uint32_t)(((uint64_t)(stats->tx_frames - stats->last_tx_frames) * 1000000U) / elapsed_us);
+        if (config->baudrate != 0) {
+            busy_us += ((nominal_bits - stats->last_nominal_bits) * 1000000U) / config->baudrate;
+        }
+        if (config->baudrate_fd != 0) {
+            busy_us += ((data_bits - stats->last_data_bits) * 1000000U) / config->baudrate_fd;
+        }
+        load = (uint32_t)((busy_us * 1000U) / elapsed_us);
+    }
+    stats->last_cycle = now;
+    stats->last_rx_frames = rx_frames;
+    stats->last_tx_frames = stats->tx_frames;
+    stats->last_nominal_bits = nominal_bits;
+    stats->last_data_bits = data_bits;
+
+    len = snprintf(buf, size,
+                   "rx=%u,rxps=%u,fwd=%u,tx=%u,txps=%u,ovr=%u,txfull=%u,txhw=%u,usb=%u,drop=%u,"
+                   "tec=%u,rec=%u,bo=%u,load=%u.%u,latmax=%u,lat=",
+                   (unsigned int)rx_frames, (unsigned int)rx_ps, (unsigned int)stats->fwd_frames,
+                   (unsigned int)stats->tx_frames, (unsigned int)tx_ps,
+                   (unsigned int)mcan_get_rx_overflow(channel), (unsigned int)mcan_tx_get_full_count(channel),
+                   (unsigned int)mcan_tx_get_high_water(channel), (unsigned int)stats->usb_bytes,
+                   (unsigned int)usbd_get_tx_drop_frames(channel),
+                   (unsigned int)MCAN_ECR_TEC_GET(base->ECR), (unsigned int)MCAN_ECR_REC_GET(base->ECR),
+                   (unsigned int)MCAN_PSR_BO_GET(base->PSR), (unsigned int)(load / 10), (unsigned int)(load % 10),
+                   (unsigned int)stats->latency_max_us);
+    for (uint32_t i = 0; (i < SLCAN_STATS_LAT_BUCKETS) && (len > 0) && ((uint32_t)len < size); i++) {
+        len += snprintf(buf + len, size - len, (i == 0) ? "%u" : ":%u", (unsigned int)stats->latency_hist[i]);
+    }
+    if (len < 0) {
+        return 0;
+    }
+    return ((uint32_t)len < size) ? (uint32_t)len : size;
+}
+
+void slcan_stats_print(uint8_t channel, MCAN_Type *base, const mcan_config_t *config)
+{
+    char text[320];
+
+    slcan_stats_format(channel, base, config, text, sizeof(text));
+    text[sizeof(text) - 1] = 0;
+    printf("CAN[%d] %s\r\n", channel, text);
+}
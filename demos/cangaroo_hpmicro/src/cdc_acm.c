@@ -7,6 +7,13 @@
 
 #include "cdc_acm.h"
 #include "chry_ringbuffer.h"
+#include "slcan_event.h"
+#include "slcan_stats.h"
+#include "mcan.h"
+#include "hpm_clock_drv.h"
+#include "hpm_csr_drv.h"
+#include "hpm_interrupt.h"
+#include <string.h>
 
 /*!< config descriptor size 1cdc = 2 interface(bilateral(in + out) + int)*/
 
@@ -146,9 +153,48 @@ typedef struct {
     uint8_t write_buffer[RX_BUFFER_SIZE];
     chry_ringbuffer_t usb_out_rb;
     uint8_t usb_out_mempool[1024];
+    USB_MEM_ALIGNX uint8_t tx_batch[CDC_TX_BATCH_COUNT][CDC_TX_BATCH_SIZE];
 } cdc_can_device_t;
 
+/*
+ * Batch ring bookkeeping, batches in [send_idx, fill_idx) are closed and waiting for
+ * the IN endpoint, batch fill_idx is the one being filled by the main loop.
+ * fill_idx is only advanced by the main loop, send_idx only by the IN completion.
+ */
+typedef struct {
+    volatile uint32_t len[CDC_TX_BATCH_COUNT];
+    volatile uint32_t fill_idx;
+    volatile uint32_t send_idx;
+    volatile bool inflight;
+    uint64_t fill_start;
+    uint32_t rx_first_us[CDC_TX_BATCH_COUNT];   /* receive time of the oldest can frame in a batch */
+    uint32_t rx_frames[CDC_TX_BATCH_COUNT];     /* can frames in a batch, for the latency statistics */
+    volatile uint32_t reply_len;    /* r_can reply waiting in write_buffer for the main loop */
+    uint32_t drop_frames;
+    uint32_t drop_bytes;
+} cdc_tx_batch_t;
+
 USB_NOCACHE_RAM_SECTION USB_MEM_ALIGNX cdc_can_device_t g_cdc_can_device[MAX_CDC_COUNT];
+static cdc_tx_batch_t g_cdc_tx_batch[MAX_CDC_COUNT];
+/* can_num -> index into g_cdc_can_device, -1 if no vcom carries that channel */
+static int8_t g_cdc_can_index[CDC_CAN_NUM_MAX] = { 0, -1, -1, -1, -1, -1, -1, -1, -1, -1 };
+
+static void cdc_can_index_update(void)
+{
+    int8_t index[CDC_CAN_NUM_MAX];
+    uint8_t i;
+
+    for (i = 0; i < CDC_CAN_NUM_MAX; i++) {
+        index[i] = -1;
+    }
+    /* the first vcom claiming a channel wins */
+    for (i = MAX_CDC_COUNT; i > 0; i--) {
+        if (g_cdc_can_device[i - 1].can_num < CDC_CAN_NUM_MAX) {
+            index[g_cdc_can_device[i - 1].can_num] = i - 1;
+        }
+    }
+    memcpy(g_cdc_can_index, index, sizeof(g_cdc_can_index));
+}
 
 // cdc_device_cfg_t cdc_device[MAX_CDC_COUNT];
 
@@ -221,16 +267,38 @@ void usbd_cdc_acm_bulk_out(uint8_t busid, uint8_t ep, uint32_t nbytes)
     if ((g_cdc_can_device[ep - 1].read_buffer[0] == 'r') && (g_cdc_can_device[ep - 1].read_buffer[1] == '_') && (g_cdc_can_device[ep - 1].read_buffer[2] == 'c') &&
         (g_cdc_can_device[ep - 1].read_buffer[3] == 'a') && (g_cdc_can_device[ep - 1].read_buffer[4] == 'n')) {
             can_num = g_cdc_can_device[ep - 1].read_buffer[5] - '0';
-            g_cdc_can_device[ep - 1].can_num = can_num;
-            len = sprintf((char *)g_cdc_can_device[ep - 1].write_buffer, "HPM_CAN%d_BUS", can_num);
-            // printf("%s    %d\r\n ", g_cdc_can_device[ep - 1].write_buffer, can_num);
-            usbd_ep_start_write(busid, 0x80 | ep, (const uint8_t *)g_cdc_can_device[ep - 1].write_buffer, len);
+            /* anything but a channel digit keeps the binding and gets no reply */
+            if (can_num < CDC_CAN_NUM_MAX) {
+                g_cdc_can_device[ep - 1].can_num = can_num;
+                cdc_can_index_update();
+                len = sprintf((char *)g_cdc_can_device[ep - 1].write_buffer, "HPM_CAN%d_BUS", can_num);
+                // printf("%s    %d\r\n ", g_cdc_can_device[ep - 1].write_buffer, can_num);
+                /* a batch may be on the bus, the reply is queued behind it by usbd_tx_batch_poll() */
+                g_cdc_tx_batch[ep - 1].reply_len = len;
+                slcan_event_set(can_num);
+            }
     } else {
         chry_ringbuffer_write(&g_cdc_can_device[ep - 1].usb_out_rb, g_cdc_can_device[ep - 1].read_buffer, nbytes);
+        slcan_event_set(g_cdc_can_device[ep - 1].can_num);
     }
     usbd_ep_start_read(busid, ep, g_cdc_can_device[ep - 1].read_buffer, usbd_get_ep_mps(busid, ep));
 }
 
+static void usbd_tx_batch_kick(uint8_t index);
+
+/* the batch in flight has reached the host, account the latency of its can frames */
+static void usbd_tx_batch_delivered(uint8_t index)
+{
+    cdc_tx_batch_t *batch = &g_cdc_tx_batch[index];
+    uint32_t slot = batch->send_idx % CDC_TX_BATCH_COUNT;
+    uint8_t can_num = g_cdc_can_device[index].can_num;
+
+    if ((batch->rx_frames[slot] != 0) && (can_num < SLCAN_STATS_CHANNELS)) {
+        slcan_stats_delivered(can_num, batch->rx_frames[slot],
+                              mcan_cycle_to_us(hpm_csr_get_core_cycle()) - batch->rx_first_us[slot]);
+    }
+}
+
 void usbd_cdc_acm_bulk_in(uint8_t busid, uint8_t ep, uint32_t nbytes)
 {
     uint8_t i;
@@ -241,6 +309,12 @@ void usbd_cdc_acm_bulk_in(uint8_t busid, uint8_t ep, uint32_t nbytes)
         for (i = 0; i < MAX_CDC_COUNT; i++) {
             if (ep == g_cdc_can_device[i].cdc_device.cdc_in_ep.ep_addr) {
                 g_cdc_can_device[i].cdc_device.ep_tx_busy_flag = false;
+                if (g_cdc_tx_batch[i].inflight) {
+                    usbd_tx_batch_delivered(i);
+                    g_cdc_tx_batch[i].inflight = false;
+                    g_cdc_tx_batch[i].send_idx++;
+                    usbd_tx_batch_kick(i);
+                }
                 break;
             }
         }
@@ -316,45 +390,239 @@ void usbd_cdc_acm_get_line_coding(uint8_t busid, uint8_t intf, struct cdc_line_c
     }
 }
 
+static inline int cdc_can_device_index(uint8_t can_num)
+{
+    return (can_num < CDC_CAN_NUM_MAX) ? g_cdc_can_index[can_num] : -1;
+}
+
 bool get_usb_out_char(uint8_t can_num, uint8_t *data)
 {
-    for (uint8_t i = 0; i < MAX_CDC_COUNT; i++) {
-        if (g_cdc_can_device[i].can_num == can_num) {
-            return chry_ringbuffer_read_byte(&g_cdc_can_device[i].usb_out_rb, data);
-        }
+    int index = cdc_can_device_index(can_num);
+    if (index < 0) {
+        return false;
     }
-    return -1;
+    return chry_ringbuffer_read_byte(&g_cdc_can_device[index].usb_out_rb, data);
 }
 
 bool get_usb_out_is_empty(uint8_t can_num)
 {
-    for (uint8_t i = 0; i < MAX_CDC_COUNT; i++) {
-        if (g_cdc_can_device[i].can_num == can_num) {
-            return chry_ringbuffer_check_empty(&g_cdc_can_device[i].usb_out_rb);
+    int index = cdc_can_device_index(can_num);
+    if (index < 0) {
+        return true;
+    }
+    return chry_ringbuffer_check_empty(&g_cdc_can_device[index].usb_out_rb);
+}
+
+/**
+ * @brief       get the oldest contiguous span of received vcom bytes
+ * @param[in]   can_num : channel to read
+ * @param[out]  size    : span length, 0 if nothing was received
+ * @return      span start, valid until usbd_out_linear_read_done()
+ */
+uint8_t *usbd_out_linear_read_setup(uint8_t can_num, uint32_t *size)
+{
+    int index = cdc_can_device_index(can_num);
+    if (index < 0) {
+        *size = 0;
+        return NULL;
+    }
+    return (uint8_t *)chry_ringbuffer_linear_read_setup(&g_cdc_can_device[index].usb_out_rb, size);
+}
+
+/**
+ * @brief       release size bytes of the span returned by usbd_out_linear_read_setup()
+ */
+void usbd_out_linear_read_done(uint8_t can_num, uint32_t size)
+{
+    int index = cdc_can_device_index(can_num);
+    if (index >= 0) {
+        chry_ringbuffer_linear_read_done(&g_cdc_can_device[index].usb_out_rb, size);
+    }
+}
+
+static uint64_t usbd_tx_batch_timeout_ticks(void)
+{
+    uint32_t ticks_per_us = (hpm_core_clock + 1000000 - 1U) / 1000000;
+    return (uint64_t)ticks_per_us * CDC_TX_FLUSH_TIMEOUT_US;
+}
+
+/* start the oldest closed batch if the IN endpoint is idle, runs from main loop and IN completion */
+static void usbd_tx_batch_kick(uint8_t index)
+{
+    cdc_tx_batch_t *batch = &g_cdc_tx_batch[index];
+    cdc_can_device_t *dev = &g_cdc_can_device[index];
+    uint32_t slot;
+    uint32_t level;
+
+    level = disable_global_irq(CSR_MSTATUS_MIE_MASK);
+    if ((batch->inflight == false) && (dev->cdc_device.ep_tx_busy_flag == false) && (batch->send_idx != batch->fill_idx)) {
+        slot = batch->send_idx % CDC_TX_BATCH_COUNT;
+        batch->inflight = true;
+        dev->cdc_device.ep_tx_busy_flag = true;
+        if (usbd_ep_start_write(USB_BUS_ID, dev->cdc_device.cdc_in_ep.ep_addr, dev->tx_batch[slot], batch->len[slot]) != 0) {
+            batch->inflight = false;
+            dev->cdc_device.ep_tx_busy_flag = false;
         }
     }
+    restore_global_irq(level);
+}
+
+/* hand the batch being filled over to the IN endpoint, fails when every other batch is still queued */
+static bool usbd_tx_batch_close(uint8_t index)
+{
+    cdc_tx_batch_t *batch = &g_cdc_tx_batch[index];
+
+    if ((batch->fill_idx - batch->send_idx) >= (CDC_TX_BATCH_COUNT - 1)) {
+        return false;
+    }
+    batch->len[(batch->fill_idx + 1) % CDC_TX_BATCH_COUNT] = 0;
+    batch->rx_frames[(batch->fill_idx + 1) % CDC_TX_BATCH_COUNT] = 0;
+    batch->fill_idx++;
+    usbd_tx_batch_kick(index);
     return true;
 }
 
-uint32_t write_usb_data(uint8_t can_num, uint8_t *data, uint32_t len)
+/**
+ * @brief       reserve room for one frame in the batch being filled
+ * @param[in]   can_num : channel the frame belongs to
+ * @param[in]   len     : exact frame length in bytes
+ * @return      pointer the frame can be written to in place, NULL if the frame was dropped
+ * @details     every dropped frame is counted, see usbd_get_tx_drop_frames()
+ */
+uint8_t *usbd_tx_batch_reserve(uint8_t can_num, uint32_t len)
 {
-    uint32_t res;
-    for (uint8_t i = 0; i < MAX_CDC_COUNT; i++) {
-        if (g_cdc_can_device[i].can_num == can_num) {
-            if (usbd_is_tx_busy(can_num) == false) {
-                usbd_set_tx_busy(can_num);
-                res = usbd_ep_start_write(USB_BUS_ID, g_cdc_can_device[i].cdc_device.cdc_in_ep.ep_addr, data, len);
-                if (res != 0) {
-                    return 0;
-                }
-            } else {
-                return 0;
-            }
-            return len;
-        }
+    int index = cdc_can_device_index(can_num);
+    cdc_tx_batch_t *batch;
+    uint32_t slot;
+
+    if (index < 0) {
+        return NULL;
+    }
+    batch = &g_cdc_tx_batch[index];
+    slot = batch->fill_idx % CDC_TX_BATCH_COUNT;
+    if ((len == 0) || (len > CDC_TX_BATCH_SIZE) ||
+        (((batch->len[slot] + len) > CDC_TX_BATCH_SIZE) && (usbd_tx_batch_close(index) == false))) {
+        batch->drop_frames++;
+        batch->drop_bytes += len;
+        return NULL;
+    }
+    slot = batch->fill_idx % CDC_TX_BATCH_COUNT;
+    if (batch->len[slot] == 0) {
+        batch->fill_start = hpm_csr_get_core_cycle();
+    }
+    return &g_cdc_can_device[index].tx_batch[slot][batch->len[slot]];
+}
+
+/**
+ * @brief       record the receive time of a can frame for the latency statistics
+ * @param[in]   can_num    : channel the frame belongs to
+ * @param[in]   rx_time_us : mcan_isr() time of the frame, microseconds
+ * @details     call between usbd_tx_batch_reserve() and usbd_tx_batch_commit(), the
+ *              latency is taken in the IN completion once the host has the batch
+ */
+void usbd_tx_batch_stamp(uint8_t can_num, uint32_t rx_time_us)
+{
+    int index = cdc_can_device_index(can_num);
+    cdc_tx_batch_t *batch;
+    uint32_t slot;
+
+    if (index < 0) {
+        return;
+    }
+    batch = &g_cdc_tx_batch[index];
+    slot = batch->fill_idx % CDC_TX_BATCH_COUNT;
+    if (batch->rx_frames[slot] == 0) {
+        batch->rx_first_us[slot] = rx_time_us;
+    }
+    batch->rx_frames[slot]++;
+}
+
+/**
+ * @brief       commit a frame written through usbd_tx_batch_reserve()
+ * @param[in]   can_num : channel the frame belongs to
+ * @param[in]   len     : bytes actually written, must not exceed the reserved length
+ */
+void usbd_tx_batch_commit(uint8_t can_num, uint32_t len)
+{
+    int index = cdc_can_device_index(can_num);
+    cdc_tx_batch_t *batch;
+    uint32_t slot;
+
+    if (index < 0) {
+        return;
+    }
+    batch = &g_cdc_tx_batch[index];
+    slot = batch->fill_idx % CDC_TX_BATCH_COUNT;
+    batch->len[slot] += len;
+    if (can_num < SLCAN_STATS_CHANNELS) {
+        slcan_stats_usb(can_num, len);
+    }
+    if (batch->len[slot] >= CDC_TX_BATCH_SIZE) {
+        usbd_tx_batch_close(index);
     }
-    return 0;
 }
 
+/**
+ * @brief       flush a partially filled batch once it is older than CDC_TX_FLUSH_TIMEOUT_US
+ * @param[in]   can_num : channel to service
+ * @details     must be called periodically from the main loop
+ */
+void usbd_tx_batch_poll(uint8_t can_num)
+{
+    int index = cdc_can_device_index(can_num);
+    cdc_tx_batch_t *batch;
 
+    if (index < 0) {
+        return;
+    }
+    batch = &g_cdc_tx_batch[index];
+    if ((batch->reply_len != 0) &&
+        (write_usb_data(can_num, g_cdc_can_device[index].write_buffer, batch->reply_len) != 0)) {
+        batch->reply_len = 0;
+    }
+    if ((batch->len[batch->fill_idx % CDC_TX_BATCH_COUNT] != 0) &&
+        ((hpm_csr_get_core_cycle() - batch->fill_start) >= usbd_tx_batch_timeout_ticks())) {
+        usbd_tx_batch_close(index);
+    }
+    usbd_tx_batch_kick(index);
+}
+
+/**
+ * @brief       check whether a channel still has bytes waiting in the batch being filled
+ * @param[in]   can_num : channel to check
+ * @return      true while usbd_tx_batch_poll() still has to flush something
+ */
+bool usbd_tx_batch_pending(uint8_t can_num)
+{
+    int index = cdc_can_device_index(can_num);
+    cdc_tx_batch_t *batch;
 
+    if (index < 0) {
+        return false;
+    }
+    batch = &g_cdc_tx_batch[index];
+    return (batch->len[batch->fill_idx % CDC_TX_BATCH_COUNT] != 0) || (batch->reply_len != 0);
+}
+
+uint32_t usbd_get_tx_drop_frames(uint8_t can_num)
+{
+    int index = cdc_can_device_index(can_num);
+    return (index < 0) ? 0 : g_cdc_tx_batch[index].drop_frames;
+}
+
+uint32_t usbd_get_tx_drop_bytes(uint8_t can_num)
+{
+    int index = cdc_can_device_index(can_num);
+    return (index < 0) ? 0 : g_cdc_tx_batch[index].drop_bytes;
+}
+
+uint32_t write_usb_data(uint8_t can_num, uint8_t *data, uint32_t len)
+{
+    uint8_t *dst = usbd_tx_batch_reserve(can_num, len);
+    if (dst == NULL) {
+        return 0;
+    }
+    memcpy(dst, data, len);
+    usbd_tx_batch_commit(can_num, len);
+    return len;
+}
@@ -14,8 +14,13 @@
 #include "cdc_acm.h"
 #include "slcan.h"
 #include "mcan.h"
+#include "slcan_event.h"
+#include "slcan_led.h"
+#include "hpm_interrupt.h"
+
 int main(void)
 {
+    uint32_t level;
     // uint8_t i = 0;
     // uint8_t buffer[100];
     // uint8_t len = 0;
@@ -52,10 +57,16 @@ int main(void)
     }
     WS2812_Update(true);
     while (1) {
-        slcan_process_task(&slcan0);
-        slcan_process_task(&slcan1);
-        slcan_process_task(&slcan2);
-        slcan_process_task(&slcan3);
+        bool busy = slcan_process_ready();
+        busy |= slcan_led_poll();
+        if (busy == false) {
+            /* sleep with interrupts masked, a pending interrupt still ends wfi, so no event is lost */
+            level = disable_global_irq(CSR_MSTATUS_MIE_MASK);
+            if (slcan_event_pending() == false) {
+                __asm volatile("wfi");
+            }
+            restore_global_irq(level);
+        }
     }
     return 0;
 }
@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_BOARD_H
+#define _FAKE_BOARD_H
+
+#include "hpm_common.h"
+#include "hpm_mcan_drv.h"
+#include "hpm_gptmr_drv.h"
+
+#define BOARD_RUNNING_CORE (0U)
+
+uint32_t board_init_can_clock(MCAN_Type *ptr);
+
+#endif /* _FAKE_BOARD_H */
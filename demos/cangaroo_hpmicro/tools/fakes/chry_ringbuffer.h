@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_CHRY_RINGBUFFER_H
+#define _FAKE_CHRY_RINGBUFFER_H
+
+/*
+ * Host stand-in for CherryRB with the same semantics: free running in/out
+ * indexes, a power of two pool, partial writes when full.
+ * Implemented in host_harness/fake_sdk.c.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint32_t in;
+    uint32_t out;
+    uint32_t mask;
+    void *pool;
+} chry_ringbuffer_t;
+
+int chry_ringbuffer_init(chry_ringbuffer_t *rb, void *pool, uint32_t size);
+uint32_t chry_ringbuffer_get_used(chry_ringbuffer_t *rb);
+bool chry_ringbuffer_check_empty(chry_ringbuffer_t *rb);
+uint32_t chry_ringbuffer_write(chry_ringbuffer_t *rb, void *data, uint32_t size);
+bool chry_ringbuffer_read_byte(chry_ringbuffer_t *rb, uint8_t *byte);
+void *chry_ringbuffer_linear_read_setup(chry_ringbuffer_t *rb, uint32_t *size);
+void chry_ringbuffer_linear_read_done(chry_ringbuffer_t *rb, uint32_t size);
+
+#endif /* _FAKE_CHRY_RINGBUFFER_H */
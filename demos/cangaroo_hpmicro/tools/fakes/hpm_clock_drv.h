@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_HPM_CLOCK_DRV_H
+#define _FAKE_HPM_CLOCK_DRV_H
+
+#include "hpm_common.h"
+
+typedef uint32_t clock_name_t;
+
+#define clock_gptmr0 (0U)
+
+uint32_t clock_get_frequency(clock_name_t clock_name);
+void clock_add_to_group(clock_name_t clock_name, uint32_t group);
+
+#endif /* _FAKE_HPM_CLOCK_DRV_H */
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_HPM_COMMON_H
+#define _FAKE_HPM_COMMON_H
+
+/*
+ * Host stand-in for the SDK common header. The host programs run the
+ * "interrupts" between passes of the main loop, so masking them is a no-op.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef uint32_t hpm_stat_t;
+
+enum {
+    status_success = 0,
+    status_fail = 1,
+    status_invalid_argument = 2,
+    status_timeout = 3,
+};
+
+#define ATTR_WEAK __attribute__((weak))
+#define SDK_DECLARE_EXT_ISR_M(irq, isr)
+
+#define CSR_MSTATUS_MIE_MASK (1UL << 3)
+
+extern uint32_t hpm_core_clock;
+
+static inline uint32_t disable_global_irq(uint32_t mask)
+{
+    return mask;
+}
+
+static inline void restore_global_irq(uint32_t mask)
+{
+    (void)mask;
+}
+
+static inline void intc_m_enable_irq_with_priority(uint32_t irq, uint32_t priority)
+{
+    (void)irq;
+    (void)priority;
+}
+
+static inline void intc_m_disable_irq(uint32_t irq)
+{
+    (void)irq;
+}
+
+static inline void intc_set_irq_priority(uint32_t irq, uint32_t priority)
+{
+    (void)irq;
+    (void)priority;
+}
+
+#endif /* _FAKE_HPM_COMMON_H */
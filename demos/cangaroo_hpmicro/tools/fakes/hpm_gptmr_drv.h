@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_HPM_GPTMR_DRV_H
+#define _FAKE_HPM_GPTMR_DRV_H
+
+/*
+ * Host stand-in for the SDK timer driver. The timer never runs, so the
+ * replay (slcan_replay.c) links but never fires off target.
+ */
+
+#include "hpm_common.h"
+
+typedef struct {
+    uint32_t reserved;
+} GPTMR_Type;
+
+typedef struct {
+    uint32_t reload;
+    uint32_t cmp[2];
+    bool cmp_initial_polarity_high;
+    bool enable_cmp_output;
+} gptmr_channel_config_t;
+
+extern GPTMR_Type g_fake_gptmr0;
+
+#define HPM_GPTMR0                   (&g_fake_gptmr0)
+#define IRQn_GPTMR0                  (0U)
+#define GPTMR_CH_RLD_STAT_MASK(ch)   (1UL << ((ch) * 4))
+#define GPTMR_CH_RLD_IRQ_MASK(ch)    (1UL << ((ch) * 4))
+
+static inline void gptmr_channel_get_default_config(GPTMR_Type *ptr, gptmr_channel_config_t *config)
+{
+    (void)ptr;
+    memset(config, 0, sizeof(*config));
+}
+
+static inline hpm_stat_t gptmr_channel_config(GPTMR_Type *ptr, uint8_t ch, gptmr_channel_config_t *config, bool enable)
+{
+    (void)ptr;
+    (void)ch;
+    (void)config;
+    (void)enable;
+    return status_success;
+}
+
+static inline void gptmr_start_counter(GPTMR_Type *ptr, uint8_t ch)
+{
+    (void)ptr;
+    (void)ch;
+}
+
+static inline void gptmr_stop_counter(GPTMR_Type *ptr, uint8_t ch)
+{
+    (void)ptr;
+    (void)ch;
+}
+
+static inline void gptmr_enable_irq(GPTMR_Type *ptr, uint32_t mask)
+{
+    (void)ptr;
+    (void)mask;
+}
+
+static inline void gptmr_disable_irq(GPTMR_Type *ptr, uint32_t mask)
+{
+    (void)ptr;
+    (void)mask;
+}
+
+static inline bool gptmr_check_status(GPTMR_Type *ptr, uint32_t mask)
+{
+    (void)ptr;
+    (void)mask;
+    return false;
+}
+
+static inline void gptmr_clear_status(GPTMR_Type *ptr, uint32_t mask)
+{
+    (void)ptr;
+    (void)mask;
+}
+
+static inline void gptmr_channel_reset_count(GPTMR_Type *ptr, uint8_t ch)
+{
+    (void)ptr;
+    (void)ch;
+}
+
+static inline void gptmr_channel_config_update_reload(GPTMR_Type *ptr, uint8_t ch, uint32_t reload)
+{
+    (void)ptr;
+    (void)ch;
+    (void)reload;
+}
+
+static inline void gptmr_channel_update_count(GPTMR_Type *ptr, uint8_t ch, uint32_t value)
+{
+    (void)ptr;
+    (void)ch;
+    (void)value;
+}
+
+#endif /* _FAKE_HPM_GPTMR_DRV_H */
@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_HPM_INTERRUPT_H
+#define _FAKE_HPM_INTERRUPT_H
+
+#include "hpm_common.h"
+
+#endif /* _FAKE_HPM_INTERRUPT_H */
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_HPM_MCAN_DRV_H
+#define _FAKE_HPM_MCAN_DRV_H
+
+/*
+ * Host stand-in for the SDK MCAN driver header, only what the slcan sources
+ * use. The message layouts follow hpm_mcan_drv.h; the functions are
+ * implemented by the host program that links the driver (host_harness/).
+ */
+
+#include "hpm_common.h"
+
+/* the fields the sources read directly, the rest of the controller lives in the fake */
+typedef struct {
+    volatile uint32_t ECR;
+    volatile uint32_t PSR;
+} MCAN_Type;
+
+extern MCAN_Type g_fake_mcan[4];
+
+#define HPM_MCAN0  (&g_fake_mcan[0])
+#define HPM_MCAN1  (&g_fake_mcan[1])
+#define HPM_MCAN2  (&g_fake_mcan[2])
+#define HPM_MCAN3  (&g_fake_mcan[3])
+#define IRQn_MCAN0 (1U)
+#define IRQn_MCAN1 (2U)
+#define IRQn_MCAN2 (3U)
+#define IRQn_MCAN3 (4U)
+
+#define MCAN_ECR_TEC_GET(x) ((uint32_t)(x) & 0xFFUL)
+#define MCAN_ECR_REC_GET(x) (((uint32_t)(x) >> 8) & 0x7FUL)
+#define MCAN_PSR_BO_GET(x)  (((uint32_t)(x) >> 7) & 0x1UL)
+
+#define MCAN_INT_RXFIFO0_NEW_MSG     (1UL << 0)
+#define MCAN_INT_RXFIFO1_NEW_MSG     (1UL << 4)
+#define MCAN_INT_MSG_STORE_TO_RXBUF  (1UL << 19)
+#define MCAN_INT_TX_COMPLETED        (1UL << 9)
+#define MCAN_INT_TXFIFO_EMPTY        (1UL << 11)
+#define MCAN_EVENT_RECEIVE           (MCAN_INT_RXFIFO0_NEW_MSG | MCAN_INT_RXFIFO1_NEW_MSG | MCAN_INT_MSG_STORE_TO_RXBUF)
+#define MCAN_RXBUF_SIZE_CAN_DEFAULT  (8U)
+
+#define MCAN_FILTER_TYPE_CLASSIC_FILTER                  (2U)
+#define MCAN_FILTER_ELEM_CFG_DISABLED                    (0U)
+#define MCAN_FILTER_ELEM_CFG_STORE_IN_RX_FIFO0_IF_MATCH  (1U)
+#define MCAN_CAN_ID_TYPE_STANDARD                        (0U)
+#define MCAN_CAN_ID_TYPE_EXTENDED                        (1U)
+#define MCAN_ACCEPT_NON_MATCHING_FRAME_OPTION_IN_RXFIFO0 (0U)
+#define MCAN_ACCEPT_NON_MATCHING_FRAME_OPTION_REJECT     (2U)
+
+typedef struct mcan_rx_message_struct {
+    union {
+        struct {
+            uint32_t ext_id: 29;
+            uint32_t rtr: 1;
+            uint32_t use_ext_id: 1;
+            uint32_t error_state_indicator: 1;
+        };
+        struct {
+            uint32_t: 18;
+            uint32_t std_id: 11;
+            uint32_t: 3;
+        };
+    };
+    uint32_t rx_timestamp: 16;
+    uint32_t dlc: 4;
+    uint32_t bitrate_switch: 1;
+    uint32_t canfd_frame: 1;
+    uint32_t rx_timestamp_pointer: 4;
+    uint32_t filter_index: 7;
+    uint32_t accepted_non_matching_frame: 1;
+    union {
+        uint8_t data_8[64];
+        uint32_t data_32[16];
+    };
+} mcan_rx_message_t;
+
+typedef struct mcan_tx_message_struct {
+    union {
+        struct {
+            uint32_t ext_id: 29;
+            uint32_t rtr: 1;
+            uint32_t use_ext_id: 1;
+            uint32_t error_state_indicator: 1;
+        };
+        struct {
+            uint32_t: 18;
+            uint32_t std_id: 11;
+            uint32_t: 3;
+        };
+    };
+    uint32_t: 16;
+    uint32_t dlc: 4;
+    uint32_t bitrate_switch: 1;
+    uint32_t canfd_frame: 1;
+    uint32_t timestamp_capture_enable: 1;
+    uint32_t event_fifo_control: 1;
+    uint32_t message_marker_h: 8;
+    union {
+        uint8_t data_8[64];
+        uint32_t data_32[16];
+    };
+} mcan_tx_frame_t;
+
+typedef enum {
+    mcan_mode_normal,
+    mcan_mode_loopback_internal,
+    mcan_mode_loopback_external,
+    mcan_mode_listen_only,
+} mcan_node_mode_t;
+
+typedef struct {
+    uint16_t prescaler;
+    uint16_t num_seg1;
+    uint8_t num_seg2;
+    uint8_t num_sjw;
+    bool enable_tdc;
+} mcan_bit_timing_param_t;
+
+typedef struct {
+    uint8_t ssp_offset;
+    uint8_t filter_window_length;
+} mcan_tdc_config_t;
+
+typedef struct {
+    uint8_t filter_type;
+    uint8_t filter_config;
+    uint8_t can_id_type;
+    uint8_t sync_message;
+    uint32_t filter_id;
+    uint32_t filter_mask;
+} mcan_filter_elem_t;
+
+typedef struct {
+    uint32_t mcan_filter_elem_count;
+    const mcan_filter_elem_t *filter_elem_list;
+} mcan_filter_elem_list_t;
+
+typedef struct {
+    uint8_t accept_non_matching_std_frame_option;
+    uint8_t accept_non_matching_ext_frame_option;
+    bool reject_remote_std_frame;
+    bool reject_remote_ext_frame;
+} mcan_global_filter_config_t;
+
+typedef struct {
+    mcan_global_filter_config_t global_filter_config;
+    uint32_t ext_id_mask;
+    mcan_filter_elem_list_t std_id_filter_list;
+    mcan_filter_elem_list_t ext_id_filter_list;
+} mcan_all_filters_config_t;
+
+typedef struct {
+    bool enable_std_filter;
+    uint32_t std_filter_elem_count;
+    bool enable_ext_filter;
+    uint32_t ext_filter_elem_count;
+} mcan_ram_config_t;
+
+/* the SDK overlays the rates and the low level timing, kept apart here */
+typedef struct {
+    uint32_t baudrate;
+    uint32_t baudrate_fd;
+    bool use_lowlevel_timing_setting;
+    mcan_bit_timing_param_t can_timing;
+    mcan_bit_timing_param_t canfd_timing;
+    mcan_node_mode_t mode;
+    bool enable_canfd;
+    bool enable_tdc;
+    mcan_tdc_config_t tdc_config;
+    mcan_ram_config_t ram_config;
+    mcan_all_filters_config_t all_filters_config;
+} mcan_config_t;
+
+void mcan_get_default_config(MCAN_Type *ptr, mcan_config_t *config);
+void mcan_get_default_ram_config(MCAN_Type *ptr, mcan_ram_config_t *ram_config, bool enable_canfd);
+hpm_stat_t mcan_init(MCAN_Type *ptr, mcan_config_t *config, uint32_t src_clk_freq);
+void mcan_deinit(MCAN_Type *ptr);
+void mcan_enable_interrupts(MCAN_Type *ptr, uint32_t mask);
+void mcan_disable_interrupts(MCAN_Type *ptr, uint32_t mask);
+void mcan_enable_txbuf_transmission_interrupt(MCAN_Type *ptr, uint32_t mask);
+uint32_t mcan_get_interrupt_flags(MCAN_Type *ptr);
+void mcan_clear_interrupt_flags(MCAN_Type *ptr, uint32_t flags);
+hpm_stat_t mcan_read_rxfifo(MCAN_Type *ptr, uint32_t fifo_index, mcan_rx_message_t *rx_msg);
+hpm_stat_t mcan_read_rxbuf(MCAN_Type *ptr, uint32_t index, mcan_rx_message_t *rx_msg);
+bool mcan_is_rxbuf_data_available(MCAN_Type *ptr, uint32_t index);
+void mcan_clear_rxbuf_data_available_flag(MCAN_Type *ptr, uint32_t index);
+hpm_stat_t mcan_transmit_via_txfifo_nonblocking(MCAN_Type *ptr, const mcan_tx_frame_t *tx_frame, uint32_t *fifo_index);
+
+#endif /* _FAKE_HPM_MCAN_DRV_H */
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_PINMUX_H
+#define _FAKE_PINMUX_H
+
+#include "hpm_common.h"
+
+/* pad function registers, written and never read back */
+typedef struct {
+    struct {
+        volatile uint32_t FUNC_CTL;
+    } PAD[512];
+} IOC_Type;
+
+extern IOC_Type g_fake_ioc;
+
+#define HPM_IOC                      (&g_fake_ioc)
+#define IOC_PAD_PA14                 (14U)
+#define IOC_PAD_PA15                 (15U)
+#define IOC_PAD_PB00                 (32U)
+#define IOC_PAD_PB01                 (33U)
+#define IOC_PAD_PB04                 (36U)
+#define IOC_PAD_PB05                 (37U)
+#define IOC_PAD_PB08                 (40U)
+#define IOC_PAD_PB09                 (41U)
+#define IOC_PB00_FUNC_CTL_MCAN0_TXD  (7U)
+#define IOC_PB01_FUNC_CTL_MCAN0_RXD  (7U)
+#define IOC_PB05_FUNC_CTL_MCAN1_TXD  (7U)
+#define IOC_PB04_FUNC_CTL_MCAN1_RXD  (7U)
+#define IOC_PB08_FUNC_CTL_MCAN2_TXD  (7U)
+#define IOC_PB09_FUNC_CTL_MCAN2_RXD  (7U)
+#define IOC_PA15_FUNC_CTL_MCAN3_TXD  (7U)
+#define IOC_PA14_FUNC_CTL_MCAN3_RXD  (7U)
+
+#endif /* _FAKE_PINMUX_H */
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_USBD_CORE_H
+#define _FAKE_USBD_CORE_H
+
+/*
+ * Host stand-in for the CherryUSB device core, only what cdc_acm.c uses.
+ * The descriptors collapse to a placeholder byte; the endpoint functions
+ * are implemented by the host program (host_harness/fake_usbd.c).
+ */
+
+#include "hpm_common.h"
+
+#define USB_MEM_ALIGNX           __attribute__((aligned(4)))
+#define USB_NOCACHE_RAM_SECTION
+
+#define USB_SPEED_FULL           (2U)
+#define USB_SPEED_HIGH           (3U)
+#define USB_BULK_EP_MPS_FS       (64U)
+#define USB_BULK_EP_MPS_HS       (512U)
+#define CDC_ACM_DESCRIPTOR_LEN   (66U)
+
+#define USB_DEVICE_DESCRIPTOR_INIT(...)             0
+#define USB_CONFIG_DESCRIPTOR_INIT(...)             0
+#define USB_OTHER_SPEED_CONFIG_DESCRIPTOR_INIT(...) 0
+#define USB_DEVICE_QUALIFIER_DESCRIPTOR_INIT(...)   0
+#define CDC_ACM_DESCRIPTOR_INIT(...)                0
+
+enum usbd_event_type {
+    USBD_EVENT_ERROR,
+    USBD_EVENT_RESET,
+    USBD_EVENT_SOF,
+    USBD_EVENT_CONNECTED,
+    USBD_EVENT_DISCONNECTED,
+    USBD_EVENT_RESUME,
+    USBD_EVENT_SUSPEND,
+    USBD_EVENT_CONFIGURED,
+    USBD_EVENT_SET_INTERFACE,
+    USBD_EVENT_SET_REMOTE_WAKEUP,
+    USBD_EVENT_CLR_REMOTE_WAKEUP,
+};
+
+typedef void (*usbd_endpoint_callback)(uint8_t busid, uint8_t ep, uint32_t nbytes);
+typedef void (*usbd_event_handler_t)(uint8_t busid, uint8_t event);
+
+struct usbd_endpoint {
+    uint8_t ep_addr;
+    usbd_endpoint_callback ep_cb;
+};
+
+struct usbd_interface {
+    uint8_t intf_num;
+};
+
+struct usb_descriptor {
+    const uint8_t *(*device_descriptor_callback)(uint8_t speed);
+    const uint8_t *(*config_descriptor_callback)(uint8_t speed);
+    const uint8_t *(*device_quality_descriptor_callback)(uint8_t speed);
+    const uint8_t *(*other_speed_descriptor_callback)(uint8_t speed);
+    const char *(*string_descriptor_callback)(uint8_t speed, uint8_t index);
+};
+
+struct cdc_line_coding {
+    uint32_t dwDTERate;
+    uint8_t bCharFormat;
+    uint8_t bParityType;
+    uint8_t bDataBits;
+};
+
+void usbd_desc_register(uint8_t busid, const struct usb_descriptor *desc);
+void usbd_add_interface(uint8_t busid, struct usbd_interface *intf);
+void usbd_add_endpoint(uint8_t busid, struct usbd_endpoint *ep);
+int usbd_initialize(uint8_t busid, uint32_t reg_base, usbd_event_handler_t event_handler);
+int usbd_ep_start_write(uint8_t busid, uint8_t ep, const uint8_t *data, uint32_t data_len);
+int usbd_ep_start_read(uint8_t busid, uint8_t ep, uint8_t *data, uint32_t data_len);
+uint16_t usbd_get_ep_mps(uint8_t busid, uint8_t ep);
+
+#endif /* _FAKE_USBD_CORE_H */
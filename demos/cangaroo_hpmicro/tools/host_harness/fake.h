@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _HOST_HARNESS_FAKE_H
+#define _HOST_HARNESS_FAKE_H
+
+/*
+ * Control side of the in-memory fakes the bridge firmware is linked
+ * against on the host. The firmware sees the SDK and CherryUSB APIs from
+ * tools/fakes/, the harness drives the other end through these calls.
+ *
+ * There are no threads: the harness runs the "interrupts" (mcan_isr() and
+ * the usb completions) between passes of the main loop, so an interrupt
+ * never preempts slcan_process_ready() half way.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hpm_mcan_drv.h"
+
+/* cycles per second of hpm_csr_get_core_cycle(), one cycle is one nanosecond of CLOCK_MONOTONIC */
+#define FAKE_CORE_CLOCK          (1000000000UL)
+
+/* receive FIFO 0 elements of one controller, frames arriving on a full FIFO are lost */
+#ifndef FAKE_MCAN_RXFIFO_DEPTH
+#define FAKE_MCAN_RXFIFO_DEPTH   (32U)
+#endif
+
+/* fixed cost of one bulk IN transfer on the bus, on top of its bytes */
+#ifndef FAKE_USBD_OVERHEAD_NS
+#define FAKE_USBD_OVERHEAD_NS    (2000U)
+#endif
+
+/* fake_mcan.c */
+bool fake_mcan_inject(uint8_t channel, const mcan_rx_message_t *msg);
+bool fake_mcan_irq_pending(uint8_t channel);
+uint32_t fake_mcan_get_lost(uint8_t channel);
+uint32_t fake_mcan_get_sent(uint8_t channel);
+
+/* fake_usbd.c, the sink gets every IN transfer when the host has taken it */
+typedef void (*fake_usbd_sink_t)(uint8_t ep, const uint8_t *data, uint32_t len);
+
+void fake_usbd_set_sink(fake_usbd_sink_t sink);
+void fake_usbd_set_bandwidth(uint32_t bytes_per_s);
+void fake_usbd_configure(void);
+uint32_t fake_usbd_host_write(uint8_t ep, const void *data, uint32_t len);
+void fake_usbd_poll(void);
+bool fake_usbd_busy(void);
+
+#endif /* _HOST_HARNESS_FAKE_H */
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * In-memory MCAN controller: one receive FIFO fed by the harness, a
+ * transmit FIFO that puts every frame on the bus at once, and the
+ * interrupt flags mcan_isr() reads back.
+ */
+
+#include "fake.h"
+
+typedef struct {
+    bool open;
+    uint32_t irq_enable;
+    uint32_t irq_flags;
+    mcan_rx_message_t rxfifo[FAKE_MCAN_RXFIFO_DEPTH];
+    uint32_t rx_in;
+    uint32_t rx_out;
+    uint32_t rx_lost;   /* frames that found the FIFO full */
+    uint32_t tx_sent;   /* frames put on the bus */
+} fake_mcan_t;
+
+MCAN_Type g_fake_mcan[4];
+static fake_mcan_t g_fake_mcan_state[4];
+
+static fake_mcan_t *fake_mcan_get(MCAN_Type *ptr)
+{
+    return &g_fake_mcan_state[ptr - g_fake_mcan];
+}
+
+bool fake_mcan_inject(uint8_t channel, const mcan_rx_message_t *msg)
+{
+    fake_mcan_t *can = &g_fake_mcan_state[channel];
+
+    if ((can->rx_in - can->rx_out) >= FAKE_MCAN_RXFIFO_DEPTH) {
+        can->rx_lost++;
+        return false;
+    }
+    can->rxfifo[can->rx_in % FAKE_MCAN_RXFIFO_DEPTH] = *msg;
+    can->rx_in++;
+    can->irq_flags |= MCAN_INT_RXFIFO0_NEW_MSG;
+    return true;
+}
+
+bool fake_mcan_irq_pending(uint8_t channel)
+{
+    fake_mcan_t *can = &g_fake_mcan_state[channel];
+
+    return can->open && ((can->irq_flags & can->irq_enable) != 0);
+}
+
+uint32_t fake_mcan_get_lost(uint8_t channel)
+{
+    return g_fake_mcan_state[channel].rx_lost;
+}
+
+uint32_t fake_mcan_get_sent(uint8_t channel)
+{
+    return g_fake_mcan_state[channel].tx_sent;
+}
+
+void mcan_get_default_config(MCAN_Type *ptr, mcan_config_t *config)
+{
+    (void)ptr;
+    memset(config, 0, sizeof(*config));
+    config->baudrate = 1000000UL;
+    config->baudrate_fd = 2000000UL;
+    config->mode = mcan_mode_normal;
+}
+
+void mcan_get_default_ram_config(MCAN_Type *ptr, mcan_ram_config_t *ram_config, bool enable_canfd)
+{
+    (void)ptr;
+    (void)enable_canfd;
+    memset(ram_config, 0, sizeof(*ram_config));
+}
+
+hpm_stat_t mcan_init(MCAN_Type *ptr, mcan_config_t *config, uint32_t src_clk_freq)
+{
+    fake_mcan_t *can = fake_mcan_get(ptr);
+
+    (void)config;
+    (void)src_clk_freq;
+    can->open = true;
+    can->rx_out = can->rx_in;
+    can->irq_flags = 0;
+    return status_success;
+}
+
+void mcan_deinit(MCAN_Type *ptr)
+{
+    fake_mcan_get(ptr)->open = false;
+}
+
+void mcan_enable_interrupts(MCAN_Type *ptr, uint32_t mask)
+{
+    fake_mcan_get(ptr)->irq_enable |= mask;
+}
+
+void mcan_disable_interrupts(MCAN_Type *ptr, uint32_t mask)
+{
+    fake_mcan_get(ptr)->irq_enable &= ~mask;
+}
+
+void mcan_enable_txbuf_transmission_interrupt(MCAN_Type *ptr, uint32_t mask)
+{
+    (void)ptr;
+    (void)mask;
+}
+
+uint32_t mcan_get_interrupt_flags(MCAN_Type *ptr)
+{
+    return fake_mcan_get(ptr)->irq_flags;
+}
+
+void mcan_clear_interrupt_flags(MCAN_Type *ptr, uint32_t flags)
+{
+    fake_mcan_t *can = fake_mcan_get(ptr);
+
+    can->irq_flags &= ~flags;
+    /* the controller raises the flag again for frames that came in after the read */
+    if (can->rx_in != can->rx_out) {
+        can->irq_flags |= MCAN_INT_RXFIFO0_NEW_MSG;
+    }
+}
+
+hpm_stat_t mcan_read_rxfifo(MCAN_Type *ptr, uint32_t fifo_index, mcan_rx_message_t *rx_msg)
+{
+    fake_mcan_t *can = fake_mcan_get(ptr);
+
+    if ((fifo_index != 0) || (can->rx_in == can->rx_out)) {
+        return status_fail;
+    }
+    *rx_msg = can->rxfifo[can->rx_out % FAKE_MCAN_RXFIFO_DEPTH];
+    can->rx_out++;
+    return status_success;
+}
+
+hpm_stat_t mcan_read_rxbuf(MCAN_Type *ptr, uint32_t index, mcan_rx_message_t *rx_msg)
+{
+    (void)ptr;
+    (void)index;
+    (void)rx_msg;
+    return status_fail;
+}
+
+bool mcan_is_rxbuf_data_available(MCAN_Type *ptr, uint32_t index)
+{
+    (void)ptr;
+    (void)index;
+    return false;
+}
+
+void mcan_clear_rxbuf_data_available_flag(MCAN_Type *ptr, uint32_t index)
+{
+    (void)ptr;
+    (void)index;
+}
+
+hpm_stat_t mcan_transmit_via_txfifo_nonblocking(MCAN_Type *ptr, const mcan_tx_frame_t *tx_frame, uint32_t *fifo_index)
+{
+    fake_mcan_t *can = fake_mcan_get(ptr);
+
+    (void)tx_frame;
+    *fifo_index = 0;
+    can->tx_sent++;
+    can->irq_flags |= MCAN_INT_TX_COMPLETED;
+    return status_success;
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/* clocks, board and CherryRB stand-ins for the host harness */
+
+#include <time.h>
+#include "fake.h"
+#include "hpm_csr_drv.h"
+#include "hpm_clock_drv.h"
+#include "hpm_gptmr_drv.h"
+#include "board.h"
+#include "pinmux.h"
+#include "chry_ringbuffer.h"
+
+uint32_t hpm_core_clock = FAKE_CORE_CLOCK;
+GPTMR_Type g_fake_gptmr0;
+IOC_Type g_fake_ioc;
+
+uint64_t hpm_csr_get_core_cycle(void)
+{
+    static uint64_t start;
+    struct timespec ts;
+    uint64_t now;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    now = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    if (start == 0) {
+        start = now - 1;
+    }
+    return now - start;
+}
+
+uint32_t clock_get_frequency(clock_name_t clock_name)
+{
+    (void)clock_name;
+    return 100000000UL;
+}
+
+void clock_add_to_group(clock_name_t clock_name, uint32_t group)
+{
+    (void)clock_name;
+    (void)group;
+}
+
+uint32_t board_init_can_clock(MCAN_Type *ptr)
+{
+    (void)ptr;
+    return 80000000UL;
+}
+
+int chry_ringbuffer_init(chry_ringbuffer_t *rb, void *pool, uint32_t size)
+{
+    if ((size == 0) || ((size & (size - 1)) != 0)) {
+        return -1;
+    }
+    rb->in = 0;
+    rb->out = 0;
+    rb->mask = size - 1;
+    rb->pool = pool;
+    return 0;
+}
+
+uint32_t chry_ringbuffer_get_used(chry_ringbuffer_t *rb)
+{
+    return rb->in - rb->out;
+}
+
+bool chry_ringbuffer_check_empty(chry_ringbuffer_t *rb)
+{
+    return rb->in == rb->out;
+}
+
+uint32_t chry_ringbuffer_write(chry_ringbuffer_t *rb, void *data, uint32_t size)
+{
+    uint32_t unused = (rb->mask + 1) - (rb->in - rb->out);
+    uint32_t offset = rb->in & rb->mask;
+    uint32_t first;
+
+    if (size > unused) {
+        size = unused;
+    }
+    first = rb->mask + 1 - offset;
+    if (first > size) {
+        first = size;
+    }
+    memcpy((uint8_t *)rb->pool + offset, data, first);
+    memcpy(rb->pool, (uint8_t *)data + first, size - first);
+    rb->in += size;
+    return size;
+}
+
+bool chry_ringbuffer_read_byte(chry_ringbuffer_t *rb, uint8_t *byte)
+{
+    if (rb->in == rb->out) {
+        return false;
+    }
+    *byte = ((uint8_t *)rb->pool)[rb->out & rb->mask];
+    rb->out++;
+    return true;
+}
+
+void *chry_ringbuffer_linear_read_setup(chry_ringbuffer_t *rb, uint32_t *size)
+{
+    uint32_t offset = rb->out & rb->mask;
+    uint32_t used = rb->in - rb->out;
+    uint32_t linear = rb->mask + 1 - offset;
+
+    *size = (used < linear) ? used : linear;
+    return (uint8_t *)rb->pool + offset;
+}
+
+void chry_ringbuffer_linear_read_done(chry_ringbuffer_t *rb, uint32_t size)
+{
+    rb->out += size;
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * In-memory CherryUSB device: bulk IN transfers share one bus of a given
+ * bandwidth and complete in the order they were started, bulk OUT data is
+ * handed to the endpoint the firmware armed with usbd_ep_start_read().
+ */
+
+#include "fake.h"
+#include "hpm_csr_drv.h"
+#include "usbd_core.h"
+#include "usbd_cdc.h"
+
+#define FAKE_USBD_EP_NUM (16U)
+
+typedef struct {
+    usbd_endpoint_callback cb;
+    const uint8_t *data;   /* IN: transfer on the bus, OUT: armed buffer */
+    uint32_t len;
+    uint64_t done_ns;      /* IN: when the host has taken the transfer */
+    bool busy;
+} fake_usbd_ep_t;
+
+static fake_usbd_ep_t g_fake_in[FAKE_USBD_EP_NUM];
+static fake_usbd_ep_t g_fake_out[FAKE_USBD_EP_NUM];
+static usbd_event_handler_t g_fake_event_handler;
+static fake_usbd_sink_t g_fake_sink;
+static uint32_t g_fake_bandwidth = 40000000UL;
+static uint64_t g_fake_bus_free_ns;
+static uint8_t g_fake_intf_num;
+
+void fake_usbd_set_sink(fake_usbd_sink_t sink)
+{
+    g_fake_sink = sink;
+}
+
+void fake_usbd_set_bandwidth(uint32_t bytes_per_s)
+{
+    g_fake_bandwidth = bytes_per_s;
+}
+
+void fake_usbd_configure(void)
+{
+    if (g_fake_event_handler != NULL) {
+        g_fake_event_handler(0, USBD_EVENT_CONFIGURED);
+    }
+}
+
+uint32_t fake_usbd_host_write(uint8_t ep, const void *data, uint32_t len)
+{
+    fake_usbd_ep_t *out = &g_fake_out[ep & 0x0F];
+
+    if ((out->busy == false) || (out->cb == NULL)) {
+        return 0;
+    }
+    if (len > out->len) {
+        len = out->len;
+    }
+    memcpy((uint8_t *)out->data, data, len);
+    out->busy = false;
+    out->cb(0, ep & 0x0F, len);
+    return len;
+}
+
+void fake_usbd_poll(void)
+{
+    uint64_t now = hpm_csr_get_core_cycle();
+    fake_usbd_ep_t *in;
+    uint32_t len;
+
+    for (uint8_t i = 0; i < FAKE_USBD_EP_NUM; i++) {
+        in = &g_fake_in[i];
+        if (in->busy && (now >= in->done_ns)) {
+            len = in->len;
+            in->busy = false;
+            if ((g_fake_sink != NULL) && (len != 0)) {
+                g_fake_sink(0x80 | i, in->data, len);
+            }
+            if (in->cb != NULL) {
+                in->cb(0, 0x80 | i, len);
+            }
+        }
+    }
+}
+
+bool fake_usbd_busy(void)
+{
+    for (uint8_t i = 0; i < FAKE_USBD_EP_NUM; i++) {
+        if (g_fake_in[i].busy) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void usbd_desc_register(uint8_t busid, const struct usb_descriptor *desc)
+{
+    (void)busid;
+    (void)desc;
+}
+
+void usbd_add_interface(uint8_t busid, struct usbd_interface *intf)
+{
+    (void)busid;
+    intf->intf_num = g_fake_intf_num++;
+}
+
+void usbd_add_endpoint(uint8_t busid, struct usbd_endpoint *ep)
+{
+    (void)busid;
+    if (ep->ep_addr & 0x80) {
+        g_fake_in[ep->ep_addr & 0x0F].cb = ep->ep_cb;
+    } else {
+        g_fake_out[ep->ep_addr & 0x0F].cb = ep->ep_cb;
+    }
+}
+
+int usbd_initialize(uint8_t busid, uint32_t reg_base, usbd_event_handler_t event_handler)
+{
+    (void)busid;
+    (void)reg_base;
+    g_fake_event_handler = event_handler;
+    return 0;
+}
+
+struct usbd_interface *usbd_cdc_acm_init_intf(uint8_t busid, struct usbd_interface *intf)
+{
+    (void)busid;
+    return intf;
+}
+
+int usbd_ep_start_write(uint8_t busid, uint8_t ep, const uint8_t *data, uint32_t data_len)
+{
+    fake_usbd_ep_t *in = &g_fake_in[ep & 0x0F];
+    uint64_t now = hpm_csr_get_core_cycle();
+    uint64_t start = (g_fake_bus_free_ns > now) ? g_fake_bus_free_ns : now;
+
+    (void)busid;
+    if (in->busy) {
+        return -1;
+    }
+    in->data = data;
+    in->len = data_len;
+    in->done_ns = start + FAKE_USBD_OVERHEAD_NS + ((uint64_t)data_len * 1000000000ULL) / g_fake_bandwidth;
+    in->busy = true;
+    g_fake_bus_free_ns = in->done_ns;
+    return 0;
+}
+
+int usbd_ep_start_read(uint8_t busid, uint8_t ep, uint8_t *data, uint32_t data_len)
+{
+    fake_usbd_ep_t *out = &g_fake_out[ep & 0x0F];
+
+    (void)busid;
+    out->data = data;
+    out->len = data_len;
+    out->busy = true;
+    return 0;
+}
+
+uint16_t usbd_get_ep_mps(uint8_t busid, uint8_t ep)
+{
+    (void)busid;
+    (void)ep;
+    return USB_BULK_EP_MPS_HS;
+}
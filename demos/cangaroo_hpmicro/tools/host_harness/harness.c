@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host harness for the can -> usb path of the bridge.
+ * The firmware sources (mcan.c, slcan*.c, cdc_acm.c) are linked unchanged
+ * against the in-memory fakes. The harness opens the channels the way a
+ * host does (r_canN, S8, O over the OUT endpoint), then injects received
+ * frames into the fake controllers at a fixed rate and runs mcan_isr(),
+ * the usb completions and slcan_process_ready() in a loop.
+ *
+ * Every injected frame carries its sequence number and injection time in
+ * data bytes 0..7. The host side sink decodes what arrives on the IN
+ * endpoints and reports throughput, drops by cause and the end to end
+ * latency from injection to the end of the usb transfer. The fake bus has
+ * no bitrate: the offered rate is what the controller hands over.
+ *
+ * The harness runs in real time. mcan_isr() runs right after each arrival,
+ * as the interrupt would; frames due while the harness process itself was
+ * descheduled arrive in a burst and can show up as ring_ovr, like a main
+ * loop stalled for that long.
+ *
+ * build: make
+ * usage: harness [-c channels] [-r frames/s] [-t seconds] [-d dlc] [-f] [-b] [-z]
+ *                [-u usb bytes/s] [-w host frames/s]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "fake.h"
+#include "hpm_csr_drv.h"
+#include "cdc_acm.h"
+#include "slcan.h"
+#include "mcan.h"
+#include "slcan_ascii.h"
+#include "slcan_bin.h"
+#include "slcan_stats.h"
+
+/* end to end latency histogram, 1us bins, the last one is open ended */
+#define HARNESS_LAT_BINS   (65536U)
+#define HARNESS_LINE_MAX   (256U)
+
+typedef struct {
+    uint8_t buf[HARNESS_LINE_MAX];
+    uint32_t len;
+    uint32_t next_seq;
+    uint32_t recv;
+    uint32_t missing;   /* sequence numbers never seen */
+    uint32_t bad;       /* undecodable lines/records or sequence going back */
+    uint32_t lat_max;
+    uint32_t lat_hist[HARNESS_LAT_BINS];
+} harness_rx_t;
+
+typedef struct {
+    uint32_t channels;
+    uint32_t rate;
+    double seconds;
+    uint8_t dlc;
+    bool fd;
+    bool binary;
+    bool timestamp;
+    uint32_t usb_bandwidth;
+    uint32_t host_rate;
+} harness_config_t;
+
+static struct slcan_t *const harness_ports[CANFD_NUM] = { &slcan0, &slcan1, &slcan2, &slcan3 };
+static harness_config_t harness_cfg = { 1, 10000, 2.0, 8, false, false, false, 40000000UL, 0 };
+static harness_rx_t harness_rx[CANFD_NUM];
+static uint32_t harness_sent[CANFD_NUM];
+static uint32_t harness_host_sent[CANFD_NUM];
+static bool harness_counting;   /* decoded frames are counted */
+static bool harness_injecting;  /* frames are injected */
+static uint64_t harness_t0;
+static uint64_t harness_last_pass;
+static uint64_t harness_gap_max;    /* longest time between two passes, ns */
+
+static void harness_record(harness_rx_t *rx, const uint8_t *data)
+{
+    uint32_t seq = (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+    uint32_t stamp = (uint32_t)data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24);
+    uint32_t lat = (uint32_t)(hpm_csr_get_core_cycle() / 1000U) - stamp;
+
+    if (harness_counting == false) {
+        return;
+    }
+    if (seq < rx->next_seq) {
+        rx->bad++;
+        return;
+    }
+    rx->missing += seq - rx->next_seq;
+    rx->next_seq = seq + 1;
+    rx->recv++;
+    if (lat > rx->lat_max) {
+        rx->lat_max = lat;
+    }
+    rx->lat_hist[(lat < HARNESS_LAT_BINS) ? lat : (HARNESS_LAT_BINS - 1)]++;
+}
+
+/* one ascii line without the '\r': frames are recorded, replies ("z", "") are skipped */
+static void harness_line(harness_rx_t *rx, const uint8_t *line, uint32_t len)
+{
+    uint8_t data[8];
+    uint32_t value;
+    uint32_t pos;
+
+    switch (line[0]) {
+    case 't':
+    case 'd':
+    case 'b':
+        pos = 1 + 3 + 1;
+        break;
+    case 'T':
+    case 'D':
+    case 'B':
+        pos = 1 + 8 + 1;
+        break;
+    default:
+        return;
+    }
+    if (len < pos + sizeof(data) * 2) {
+        rx->bad++;
+        return;
+    }
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        if (!slcan_ascii_get_hex(line + pos + i * 2, 2, &value)) {
+            rx->bad++;
+            return;
+        }
+        data[i] = (uint8_t)value;
+    }
+    harness_record(rx, data);
+}
+
+/* host side reader: binary records start with the sync byte, everything else is ascii up to '\r' */
+static void harness_sink(uint8_t ep, const uint8_t *data, uint32_t len)
+{
+    harness_rx_t *rx = &harness_rx[(ep & 0x0F) - 1];
+    slcan_bin_header_t hdr;
+    uint8_t payload[64];
+    int32_t ret;
+
+    for (uint32_t i = 0; i < len; i++) {
+        if (rx->len >= HARNESS_LINE_MAX) {
+            rx->bad++;
+            rx->len = 0;
+        }
+        rx->buf[rx->len++] = data[i];
+        if (rx->buf[0] == SLCAN_BIN_SYNC) {
+            ret = slcan_bin_decode(rx->buf, rx->len, &hdr, payload);
+            if (ret > 0) {
+                harness_record(rx, payload);
+                rx->len = 0;
+            } else if (ret < 0) {
+                rx->bad++;
+                rx->len = 0;
+            }
+        } else if (data[i] == '\r') {
+            harness_line(rx, rx->buf, rx->len - 1);
+            rx->len = 0;
+        }
+    }
+}
+
+static void harness_command(uint8_t channel, const char *cmd)
+{
+    if (fake_usbd_host_write(channel + 1, cmd, (uint32_t)strlen(cmd)) != strlen(cmd)) {
+        fprintf(stderr, "vcom%u did not take \"%s\"\n", (unsigned int)channel, cmd);
+    }
+}
+
+/* arrivals and interrupts first, then one pass of the firmware main loop */
+static void harness_pass(void)
+{
+    uint64_t now = hpm_csr_get_core_cycle();
+    uint64_t elapsed = now - harness_t0;
+    mcan_rx_message_t msg;
+    uint32_t stamp;
+    uint64_t due;
+    char line[40];
+
+    if (harness_injecting && (harness_last_pass != 0) && ((now - harness_last_pass) > harness_gap_max)) {
+        harness_gap_max = now - harness_last_pass;
+    }
+    harness_last_pass = now;
+    for (uint8_t ch = 0; ch < harness_cfg.channels; ch++) {
+        if (harness_injecting) {
+            due = (elapsed * harness_cfg.rate) / FAKE_CORE_CLOCK;
+            while (harness_sent[ch] < due) {
+                memset(&msg, 0, sizeof(msg));
+                msg.std_id = 0x100 + ch;
+                msg.dlc = harness_cfg.dlc;
+                msg.canfd_frame = harness_cfg.fd;
+                msg.bitrate_switch = harness_cfg.fd;
+                stamp = (uint32_t)(now / 1000U);
+                memcpy(&msg.data_8[0], &harness_sent[ch], 4);
+                memcpy(&msg.data_8[4], &stamp, 4);
+                fake_mcan_inject(ch, &msg);
+                harness_sent[ch]++;
+                /* the receive interrupt preempts the main loop on every arrival */
+                mcan_isr(harness_ports[ch]);
+            }
+            due = (elapsed * harness_cfg.host_rate) / FAKE_CORE_CLOCK;
+            if (harness_host_sent[ch] < due) {
+                snprintf(line, sizeof(line), "t%03X8%016X\r", 0x200 + ch, harness_host_sent[ch]);
+                if (fake_usbd_host_write(ch + 1, line, (uint32_t)strlen(line)) != 0) {
+                    harness_host_sent[ch]++;
+                }
+            }
+        }
+        if (fake_mcan_irq_pending(ch)) {
+            mcan_isr(harness_ports[ch]);
+        }
+    }
+    fake_usbd_poll();
+    slcan_process_ready();
+}
+
+static bool harness_idle(void)
+{
+    if (fake_usbd_busy()) {
+        return false;
+    }
+    for (uint8_t ch = 0; ch < harness_cfg.channels; ch++) {
+        if (fake_mcan_irq_pending(ch) || !spsc_ring_check_empty(&g_mcan_rx_queue[ch].ring) ||
+            usbd_tx_batch_pending(ch)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* run until nothing is left in flight for a while, at most limit_ns */
+static void harness_drain(uint64_t limit_ns)
+{
+    uint64_t start = hpm_csr_get_core_cycle();
+    uint64_t idle_since = 0;
+    uint64_t now;
+
+    while (((now = hpm_csr_get_core_cycle()) - start) < limit_ns) {
+        harness_pass();
+        if (!harness_idle()) {
+            idle_since = 0;
+        } else if (idle_since == 0) {
+            idle_since = now;
+        } else if ((now - idle_since) > 1000000U) {
+            break;
+        }
+    }
+}
+
+static uint32_t harness_percentile(const harness_rx_t *rx, uint32_t permille)
+{
+    uint64_t target = ((uint64_t)rx->recv * permille + 999U) / 1000U;
+    uint64_t sum = 0;
+
+    for (uint32_t i = 0; i < HARNESS_LAT_BINS; i++) {
+        sum += rx->lat_hist[i];
+        if ((sum >= target) && (sum != 0)) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static int harness_report(double seconds)
+{
+    char stats[320];
+    int result = 0;
+    int32_t unaccounted;
+
+    printf("%u ch x %u frames/s offered, dlc %u %s, %s%s, usb %u B/s, host tx %u frames/s, %.2f s\n",
+           (unsigned int)harness_cfg.channels, (unsigned int)harness_cfg.rate, (unsigned int)harness_cfg.dlc,
+           harness_cfg.fd ? "fd+brs" : "classic", harness_cfg.binary ? "binary" : "ascii",
+           harness_cfg.timestamp ? " Z2" : "", (unsigned int)harness_cfg.usb_bandwidth,
+           (unsigned int)harness_cfg.host_rate, seconds);
+    printf("longest gap between main loop passes %u us\n", (unsigned int)(harness_gap_max / 1000U));
+    printf("ch      sent      recv   frames/s fifo_lost  ring_ovr  usb_drop   missing  bad  lat_p50  lat_p99  lat_max\n");
+    for (uint8_t ch = 0; ch < harness_cfg.channels; ch++) {
+        harness_rx_t *rx = &harness_rx[ch];
+        uint32_t fifo_lost = fake_mcan_get_lost(ch);
+        uint32_t ring_ovr = mcan_get_rx_overflow(ch);
+        uint32_t usb_drop = usbd_get_tx_drop_frames(ch);
+
+        /* frames never decoded are either counted by one of the drop counters or a bug */
+        rx->missing += harness_sent[ch] - rx->next_seq;
+        unaccounted = (int32_t)(rx->missing - fifo_lost - ring_ovr - usb_drop);
+        printf("%2u %9u %9u %10.1f %9u %9u %9u %9u %4u %6uus %6uus %6uus\n", (unsigned int)ch,
+               (unsigned int)harness_sent[ch], (unsigned int)rx->recv, rx->recv / seconds,
+               (unsigned int)fifo_lost, (unsigned int)ring_ovr, (unsigned int)usb_drop,
+               (unsigned int)rx->missing, (unsigned int)rx->bad, (unsigned int)harness_percentile(rx, 500),
+               (unsigned int)harness_percentile(rx, 990), (unsigned int)rx->lat_max);
+        if ((rx->bad != 0) || (unaccounted > 0)) {
+            printf("   %d frames missing without a drop counter\n", (int)unaccounted);
+            result = 1;
+        }
+    }
+    for (uint8_t ch = 0; ch < harness_cfg.channels; ch++) {
+        uint32_t len = slcan_stats_format(ch, harness_ports[ch]->ptr, &harness_ports[ch]->candev_cfg,
+                                          stats, sizeof(stats) - 1);
+        stats[len] = 0;
+        printf("I%u %s\n", (unsigned int)ch, stats);
+        if (harness_cfg.host_rate != 0) {
+            printf("   host tx %u, on the bus %u\n", (unsigned int)harness_host_sent[ch],
+                   (unsigned int)fake_mcan_get_sent(ch));
+        }
+    }
+    return result;
+}
+
+static void harness_usage(void)
+{
+    fprintf(stderr, "usage: harness [-c channels] [-r frames/s] [-t seconds] [-d dlc 8~15] [-f] [-b] [-z]\n"
+                    "               [-u usb bytes/s] [-w host frames/s]\n"
+                    "  -f fd frames with bit rate switch, -b binary framing (H1), -z Z2 timestamps\n");
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t start;
+    double seconds;
+    char cmd[16];
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:r:t:d:fbzu:w:")) != -1) {
+        switch (opt) {
+        case 'c':
+            harness_cfg.channels = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            harness_cfg.rate = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            harness_cfg.seconds = strtod(optarg, NULL);
+            break;
+        case 'd':
+            harness_cfg.dlc = (uint8_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            harness_cfg.fd = true;
+            break;
+        case 'b':
+            harness_cfg.binary = true;
+            break;
+        case 'z':
+            harness_cfg.timestamp = true;
+            break;
+        case 'u':
+            harness_cfg.usb_bandwidth = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            harness_cfg.host_rate = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            harness_usage();
+            return 2;
+        }
+    }
+    /* the sequence number and the injection time need 8 data bytes */
+    if ((harness_cfg.channels < 1) || (harness_cfg.channels > CANFD_NUM) || (harness_cfg.dlc < 8) ||
+        (harness_cfg.dlc > 15) || (harness_cfg.usb_bandwidth == 0) || (harness_cfg.seconds <= 0)) {
+        harness_usage();
+        return 2;
+    }
+
+    fake_usbd_set_bandwidth(harness_cfg.usb_bandwidth);
+    fake_usbd_set_sink(harness_sink);
+    cdc_acm_init(USB_BUS_ID, 0);
+    slcan_init();
+    fake_usbd_configure();
+    for (uint8_t ch = 0; ch < harness_cfg.channels; ch++) {
+        snprintf(cmd, sizeof(cmd), "r_can%u", (unsigned int)ch);
+        harness_command(ch, cmd);
+        harness_command(ch, "S8\r");
+        harness_command(ch, "Y5\r");
+        harness_command(ch, harness_cfg.binary ? "H1\r" : "H0\r");
+        harness_command(ch, harness_cfg.timestamp ? "Z2\r" : "Z0\r");
+        harness_command(ch, "O\r");
+    }
+    /* replies to the setup are not frames, let them through before counting */
+    harness_drain(100000000U);
+    for (uint8_t ch = 0; ch < harness_cfg.channels; ch++) {
+        slcan_stats_format(ch, harness_ports[ch]->ptr, &harness_ports[ch]->candev_cfg, cmd, sizeof(cmd));
+        harness_rx[ch].len = 0;
+    }
+
+    harness_counting = true;
+    harness_injecting = true;
+    harness_t0 = hpm_csr_get_core_cycle();
+    start = harness_t0;
+    while ((hpm_csr_get_core_cycle() - start) < (uint64_t)(harness_cfg.seconds * FAKE_CORE_CLOCK)) {
+        harness_pass();
+    }
+    seconds = (double)(hpm_csr_get_core_cycle() - start) / FAKE_CORE_CLOCK;
+    harness_injecting = false;
+    harness_drain(1000000000U);
+    return harness_report(seconds);
+}
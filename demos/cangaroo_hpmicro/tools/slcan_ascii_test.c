@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host golden test and benchmark for protocol/slcan/src/slcan_ascii.c.
+ *
+ * slcan_ascii_golden.txt was written by the snprintf encoder the table driven
+ * one replaced, kept below as ref_encode(). Z2 (8 digit timestamps) did not
+ * exist then, those lines use the same snprintf style with "%08X". One vector
+ * per line:
+ *
+ *     <ext> <rtr> <fd> <brs> <id> <dlc> <data|-> <ts digits> <ts> <ascii frame>
+ *
+ * The test encodes every vector and compares the text and
+ * slcan_ascii_frame_len() with the golden frame, then decodes the golden text
+ * of data frames with slcan_ascii_decode_frame() and compares the fields.
+ *
+ * build: cc -O2 -I../protocol/slcan/inc -Ifakes -o slcan_ascii_test slcan_ascii_test.c ../protocol/slcan/src/slcan_ascii.c \
+ *            ../protocol/slcan/src/slcan_dlc.c
+ * usage: slcan_ascii_test [golden file]   check, slcan_ascii_golden.txt by default
+ *        slcan_ascii_test -g [count]      write vectors from the reference encoder
+ *        slcan_ascii_test -b [frames]     frames/s of both encoders, classic and FD frames
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "slcan_ascii.h"
+
+#define TEST_LINE_MAX 512
+
+static uint8_t ref_size_from_dlc(uint8_t dlc)
+{
+    return slcan_dlc_to_size[dlc & 0x0F];
+}
+
+static uint8_t ref_encode_dlc(uint8_t size)
+{
+    if (size < 9) {
+        return size + '0';
+    }
+    switch (size) {
+    case 12:
+        return '9';
+    case 16:
+        return 'A';
+    case 20:
+        return 'B';
+    case 24:
+        return 'C';
+    case 32:
+        return 'D';
+    case 48:
+        return 'E';
+    case 64:
+        return 'F';
+    default:
+        return 0xff;
+    }
+}
+
+/* the snprintf encoder of slcan_can2ascii() before the table driven one, plus Z2 */
+static int ref_encode(char *dst, const mcan_rx_message_t *msg, uint8_t ts_digits, uint32_t timestamp)
+{
+    char hex[10];
+    int pos = 0;
+
+    if (msg->rtr) {
+        dst[pos] = msg->use_ext_id ? 'R' : 'r';
+    } else if (msg->use_ext_id) {
+        dst[pos] = msg->bitrate_switch ? 'B' : (msg->canfd_frame ? 'D' : 'T');
+    } else {
+        dst[pos] = msg->bitrate_switch ? 'b' : (msg->canfd_frame ? 'd' : 't');
+    }
+    pos++;
+    if (msg->use_ext_id) {
+        snprintf(hex, sizeof(hex), "%08X", (unsigned int)msg->ext_id);
+        memcpy(dst + pos, hex, 8);
+        pos += 8;
+    } else {
+        snprintf(hex, sizeof(hex), "%03X", (unsigned int)msg->std_id);
+        memcpy(dst + pos, hex, 3);
+        pos += 3;
+    }
+    dst[pos++] = (char)ref_encode_dlc(ref_size_from_dlc(msg->dlc));
+    if (!msg->rtr) {
+        for (int i = 0; i < ref_size_from_dlc(msg->dlc); i++) {
+            snprintf(hex, sizeof(hex), "%02X", msg->data_8[i]);
+            memcpy(dst + pos, hex, 2);
+            pos += 2;
+        }
+    }
+    if (ts_digits == 4) {
+        snprintf(hex, sizeof(hex), "%04X", (unsigned int)(timestamp & 0x0000FFFF));
+        memcpy(dst + pos, hex, 4);
+        pos += 4;
+    } else if (ts_digits == 8) {
+        snprintf(hex, sizeof(hex), "%08X", (unsigned int)timestamp);
+        memcpy(dst + pos, hex, 8);
+        pos += 8;
+    }
+    dst[pos++] = '\r';
+    return pos;
+}
+
+static uint32_t test_seed = 0x12345678;
+
+static uint32_t test_rand(void)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 17;
+    test_seed ^= test_seed << 5;
+    return test_seed;
+}
+
+static void test_random_msg(mcan_rx_message_t *msg, uint32_t n)
+{
+    memset(msg, 0, sizeof(*msg));
+    msg->use_ext_id = test_rand() & 1;
+    msg->canfd_frame = (n % 3) == 1;
+    msg->bitrate_switch = msg->canfd_frame && (test_rand() & 1);
+    msg->rtr = !msg->canfd_frame && ((test_rand() % 5) == 0);
+    /* walk every dlc, classic frames included, then random ones */
+    msg->dlc = (n < 32) ? (n % 16) : (test_rand() % 16);
+    if (msg->use_ext_id) {
+        msg->ext_id = (n < 4) ? ((n & 1) ? 0x1FFFFFFF : 0) : (test_rand() & 0x1FFFFFFF);
+    } else {
+        msg->std_id = (n < 4) ? ((n & 1) ? 0x7FF : 0) : (test_rand() & 0x7FF);
+    }
+    for (uint32_t i = 0; i < 64; i++) {
+        msg->data_8[i] = (uint8_t)test_rand();
+    }
+}
+
+static int test_generate(uint32_t count)
+{
+    static const uint8_t ts_digits[3] = { 0, 4, 8 };
+    mcan_rx_message_t msg;
+    char text[SLCAN_ASCII_FRAME_MAX + 1];
+    uint32_t ts;
+    uint8_t digits;
+    int len;
+
+    for (uint32_t n = 0; n < count; n++) {
+        test_random_msg(&msg, n);
+        digits = ts_digits[(n / 2) % 3];
+        ts = test_rand();
+        len = ref_encode(text, &msg, digits, ts);
+        printf("%u %u %u %u %X %u ", (unsigned int)msg.use_ext_id, (unsigned int)msg.rtr, (unsigned int)msg.canfd_frame,
+               (unsigned int)msg.bitrate_switch, (unsigned int)(msg.use_ext_id ? msg.ext_id : msg.std_id), (unsigned int)msg.dlc);
+        if (msg.rtr || (slcan_dlc_to_size[msg.dlc] == 0)) {
+            printf("-");
+        }
+        for (uint32_t i = 0; !msg.rtr && (i < slcan_dlc_to_size[msg.dlc]); i++) {
+            printf("%02X", msg.data_8[i]);
+        }
+        printf(" %u %X %.*s\n", digits, (unsigned int)ts, len - 1, text);
+    }
+    return 0;
+}
+
+static int test_parse_line(char *line, mcan_rx_message_t *msg, uint8_t *digits, uint32_t *ts, char **frame)
+{
+    unsigned int ext, rtr, fd, brs, id, dlc, ts_digits, ts_value;
+    char data[130];
+    char text[SLCAN_ASCII_FRAME_MAX + 1];
+    uint32_t size;
+
+    if (sscanf(line, "%u %u %u %u %x %u %129s %u %x %150s", &ext, &rtr, &fd, &brs, &id, &dlc, data, &ts_digits,
+               &ts_value, text) != 10) {
+        return -1;
+    }
+    memset(msg, 0, sizeof(*msg));
+    msg->use_ext_id = ext;
+    msg->rtr = rtr;
+    msg->canfd_frame = fd;
+    msg->bitrate_switch = brs;
+    msg->dlc = dlc;
+    if (ext) {
+        msg->ext_id = id;
+    } else {
+        msg->std_id = id;
+    }
+    size = (data[0] == '-') ? 0 : (uint32_t)strlen(data) / 2;
+    if ((size > 64) || !slcan_ascii_get_bytes((const uint8_t *)data, msg->data_8, size)) {
+        return -1;
+    }
+    *digits = (uint8_t)ts_digits;
+    *ts = ts_value;
+    *frame = strstr(line, text);
+    (*frame)[strlen(text)] = '\0';
+    return 0;
+}
+
+static int test_check(const char *path)
+{
+    char line[TEST_LINE_MAX];
+    uint8_t out[SLCAN_ASCII_FRAME_MAX + 8];
+    mcan_rx_message_t msg;
+    mcan_tx_frame_t frame;
+    uint32_t vectors = 0;
+    uint32_t errors = 0;
+    uint32_t decoded = 0;
+    uint32_t ts;
+    uint32_t len;
+    uint8_t digits;
+    char *golden;
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL) {
+        perror(path);
+        return 1;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (test_parse_line(line, &msg, &digits, &ts, &golden) != 0) {
+            fprintf(stderr, "bad vector line %u\n", vectors + 1);
+            errors++;
+            continue;
+        }
+        vectors++;
+        memset(out, 0, sizeof(out));
+        len = slcan_ascii_encode_frame(out, &msg, digits, ts);
+        if ((len != strlen(golden) + 1) || (len != slcan_ascii_frame_len(&msg, digits)) ||
+            (memcmp(out, golden, len - 1) != 0) || (out[len - 1] != '\r')) {
+            if (errors++ < 10) {
+                fprintf(stderr, "vector %u: got %.*s, golden %s\n", vectors, (int)len - 1, out, golden);
+            }
+            continue;
+        }
+        /* read the frame back without its timestamp, host frames carry none */
+        len = (uint32_t)strlen(golden) - digits;
+        if (slcan_ascii_decode_frame((const uint8_t *)golden, len, &frame) != len) {
+            if (errors++ < 10) {
+                fprintf(stderr, "vector %u: %s does not decode\n", vectors, golden);
+            }
+            continue;
+        }
+        if ((frame.use_ext_id != msg.use_ext_id) || (frame.rtr != msg.rtr) || (frame.dlc != msg.dlc) ||
+            (!msg.rtr && ((frame.canfd_frame != msg.canfd_frame) || (frame.bitrate_switch != msg.bitrate_switch))) ||
+            (msg.use_ext_id ? (frame.ext_id != msg.ext_id) : (frame.std_id != msg.std_id)) ||
+            (!msg.rtr && (memcmp(frame.data_8, msg.data_8, slcan_dlc_to_size[msg.dlc]) != 0))) {
+            if (errors++ < 10) {
+                fprintf(stderr, "vector %u: %s decodes to different fields\n", vectors, golden);
+            }
+            continue;
+        }
+        decoded++;
+    }
+    fclose(fp);
+    printf("%u vectors, %u decoded back, %u errors\n", vectors, decoded, errors);
+    return ((errors == 0) && (vectors != 0)) ? 0 : 1;
+}
+
+static double test_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void test_bench_one(const char *name, bool fd, uint32_t frames)
+{
+    static mcan_rx_message_t msgs[256];
+    static uint8_t out[SLCAN_ASCII_FRAME_MAX + 8];
+    volatile uint32_t sink = 0;
+    double start;
+    double table_fps;
+    double ref_fps;
+
+    for (uint32_t i = 0; i < 256; i++) {
+        test_random_msg(&msgs[i], 100 + i);
+        msgs[i].rtr = false;
+        msgs[i].canfd_frame = fd;
+        msgs[i].bitrate_switch = fd;
+        msgs[i].dlc = fd ? 15 : 8;
+    }
+    start = test_now();
+    for (uint32_t n = 0; n < frames; n++) {
+        sink += slcan_ascii_encode_frame(out, &msgs[n & 255], 4, n);
+    }
+    table_fps = frames / (test_now() - start);
+    start = test_now();
+    for (uint32_t n = 0; n < frames; n++) {
+        sink += (uint32_t)ref_encode((char *)out, &msgs[n & 255], 4, n);
+    }
+    ref_fps = frames / (test_now() - start);
+    printf("%-14s table %8.2f Mframes/s, snprintf %8.2f Mframes/s, %.1fx\n", name, table_fps / 1e6, ref_fps / 1e6,
+           table_fps / ref_fps);
+    (void)sink;
+}
+
+int main(int argc, char **argv)
+{
+    if ((argc > 1) && (strcmp(argv[1], "-g") == 0)) {
+        return test_generate((argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 512);
+    }
+    if ((argc > 1) && (strcmp(argv[1], "-b") == 0)) {
+        uint32_t frames = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 2000000;
+        test_bench_one("classic 8 byte", false, frames);
+        test_bench_one("fd 64 byte", true, frames);
+        return 0;
+    }
+    return test_check((argc > 1) ? argv[1] : "slcan_ascii_golden.txt");
+}
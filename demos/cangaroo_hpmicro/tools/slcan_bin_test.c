@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host round trip fuzz test for protocol/slcan/src/slcan_bin.c.
+ * Random records are encoded into one stream, mixed with ascii reply lines
+ * and noise bytes (stray sync bytes included), and fed to a host style reader
+ * in random sized pieces. The reader must get every record back unchanged and
+ * in order. Every single bit flip of a record must also be rejected.
+ *
+ * build: cc -O2 -I../protocol/slcan/inc -o slcan_bin_test slcan_bin_test.c ../protocol/slcan/src/slcan_bin.c \
+ *            ../protocol/slcan/src/slcan_dlc.c
+ * usage: slcan_bin_test [records] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "slcan_bin.h"
+
+typedef struct {
+    slcan_bin_header_t hdr;
+    uint8_t data[64];
+} test_record_t;
+
+static uint32_t test_seed;
+
+static uint32_t test_rand(void)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 17;
+    test_seed ^= test_seed << 5;
+    return test_seed;
+}
+
+static void test_random_record(test_record_t *rec)
+{
+    rec->hdr.flags = test_rand() & SLCAN_BIN_FLAG_MASK;
+    rec->hdr.dlc = test_rand() & 0x0F;
+    rec->hdr.channel = test_rand() & 0x03;
+    rec->hdr.id = (rec->hdr.flags & SLCAN_BIN_FLAG_EXT) ? (test_rand() & 0x1FFFFFFF) : (test_rand() & 0x7FF);
+    rec->hdr.timestamp_us = test_rand();
+    for (uint32_t i = 0; i < 64; i++) {
+        rec->data[i] = (uint8_t)test_rand();
+    }
+}
+
+static int test_same(const test_record_t *a, const slcan_bin_header_t *hdr, const uint8_t *data)
+{
+    return (a->hdr.flags == hdr->flags) && (a->hdr.dlc == hdr->dlc) && (a->hdr.channel == hdr->channel) &&
+           (a->hdr.id == hdr->id) && (a->hdr.timestamp_us == hdr->timestamp_us) &&
+           (memcmp(a->data, data, slcan_bin_data_size(hdr)) == 0);
+}
+
+static uint32_t test_bit_flips(const test_record_t *rec)
+{
+    uint8_t buf[SLCAN_BIN_FRAME_MAX];
+    uint8_t data[64];
+    slcan_bin_header_t hdr;
+    uint32_t len = slcan_bin_encode(buf, &rec->hdr, rec->data);
+    uint32_t errors = 0;
+
+    for (uint32_t bit = 0; bit < len * 8; bit++) {
+        buf[bit / 8] ^= (uint8_t)(1U << (bit % 8));
+        if (slcan_bin_decode(buf, len, &hdr, data) > 0) {
+            errors++;
+        }
+        buf[bit / 8] ^= (uint8_t)(1U << (bit % 8));
+    }
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint8_t check[] = "123456789";
+    uint32_t count = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 200000;
+    test_record_t *records;
+    uint8_t *stream;
+    uint32_t stream_len = 0;
+    uint32_t stream_size;
+    uint8_t buf[4096];
+    uint32_t buf_len = 0;
+    uint32_t fed = 0;
+    uint32_t next = 0;
+    uint32_t lines = 0;
+    uint32_t lines_read = 0;
+    uint32_t errors = 0;
+    uint32_t flips = 0;
+    slcan_bin_header_t hdr;
+    uint8_t data[64];
+    int32_t ret;
+
+    test_seed = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 0x2545F491;
+    if (slcan_bin_crc16(0xFFFF, check, 9) != 0x29B1) {
+        fprintf(stderr, "crc16 check value %04X, expected 29B1\n", slcan_bin_crc16(0xFFFF, check, 9));
+        return 1;
+    }
+
+    records = malloc(count * sizeof(*records));
+    stream_size = count * (SLCAN_BIN_FRAME_MAX + 16);
+    stream = malloc(stream_size);
+    for (uint32_t i = 0; i < count; i++) {
+        test_random_record(&records[i]);
+        if ((i < 1000) && (test_bit_flips(&records[i]) != 0)) {
+            flips++;
+        }
+        /* a reply line or noise between records now and then */
+        switch (test_rand() % 8) {
+        case 0:
+            memcpy(stream + stream_len, "z\r", 2);
+            stream_len += 2;
+            lines++;
+            break;
+        case 1:
+            for (uint32_t n = test_rand() % 8; n > 0; n--) {
+                stream[stream_len++] = (test_rand() & 1) ? SLCAN_BIN_SYNC : (uint8_t)test_rand();
+            }
+            break;
+        default:
+            break;
+        }
+        stream_len += slcan_bin_encode(stream + stream_len, &records[i].hdr, records[i].data);
+    }
+
+    /* host reader: ascii up to '\r' or a record at the sync byte, resync one byte at a time */
+    while ((fed < stream_len) || (buf_len != 0)) {
+        uint32_t piece = 1 + test_rand() % 200;
+        if (piece > stream_len - fed) {
+            piece = stream_len - fed;
+        }
+        if (piece > sizeof(buf) - buf_len) {
+            piece = sizeof(buf) - buf_len;
+        }
+        memcpy(buf + buf_len, stream + fed, piece);
+        buf_len += piece;
+        fed += piece;
+        for (;;) {
+            uint32_t used = 0;
+            if (buf_len == 0) {
+                break;
+            }
+            if ((buf[0] == 'z') && (buf_len < 2) && (fed < stream_len)) {
+                break;
+            }
+            if ((buf[0] == 'z') && (buf_len >= 2) && (buf[1] == '\r')) {
+                lines_read++;
+                used = 2;
+            } else {
+                ret = slcan_bin_decode(buf, buf_len, &hdr, data);
+                if ((ret == 0) && (fed < stream_len)) {
+                    break;
+                }
+                if (ret > 0) {
+                    if ((next >= count) || !test_same(&records[next], &hdr, data)) {
+                        if (errors++ < 10) {
+                            fprintf(stderr, "record %u: decoded a different record\n", next);
+                        }
+                    }
+                    next++;
+                    used = (uint32_t)ret;
+                } else {
+                    /* noise, or a record cut off at the end of the stream */
+                    used = 1;
+                }
+            }
+            memmove(buf, buf + used, buf_len - used);
+            buf_len -= used;
+        }
+    }
+    if (next != count) {
+        fprintf(stderr, "%u of %u records read back\n", next, count);
+        errors++;
+    }
+    if (lines_read != lines) {
+        fprintf(stderr, "%u of %u reply lines read back\n", lines_read, lines);
+        errors++;
+    }
+    if (flips != 0) {
+        fprintf(stderr, "%u records accepted a single bit flip\n", flips);
+        errors++;
+    }
+    printf("%u records, %u reply lines, %u stream bytes: %u errors\n", count, lines, stream_len, errors);
+    free(records);
+    free(stream);
+    return (errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host test for protocol/slcan/src/slcan_bittiming.c.
+ * A table of nominal and data phase requests at the 40 / 60 / 80 MHz CAN clocks:
+ * exact rates, rates the clock cannot divide to exactly, and rates no register
+ * combination reaches within SLCAN_BT_MAX_ERROR_PPM. Every solution is checked
+ * against the register limits and its own reported rate and sample point, and an
+ * exhaustive search over prescaler and quanta confirms that a rejected request has
+ * no combination in tolerance and an accepted one has the smallest rate error.
+ * The TDC cases pin the enable threshold at SLCAN_BT_TDC_MIN_RATE and the offset clamp.
+ *
+ * build: cc -O2 -I../protocol/slcan/inc -o slcan_bittiming_test slcan_bittiming_test.c \
+ *            ../protocol/slcan/src/slcan_bittiming.c
+ * usage: slcan_bittiming_test [-v]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "slcan_bittiming.h"
+
+#define MHZ (1000000UL)
+
+enum {
+    EXPECT_REJECT,
+    EXPECT_EXACT,   /* achieved rate equals the request */
+    EXPECT_INEXACT, /* off, but within SLCAN_BT_MAX_ERROR_PPM */
+};
+
+typedef struct {
+    uint32_t clock_hz;
+    uint32_t bitrate;
+    uint16_t sample_point;
+    bool data_phase;
+    uint8_t expect;
+    /* pinned solution, 0 if only the invariants are checked */
+    uint16_t prescaler;
+    uint16_t seg1;
+    uint16_t seg2;
+} test_case_t;
+
+static const test_case_t test_cases[] = {
+    /* usual nominal rates, the smallest prescaler at the default sample point wins */
+    { 40 * MHZ, 500000, 0, false, EXPECT_EXACT, 1, 70, 10 },
+    { 40 * MHZ, 1000000, 0, false, EXPECT_EXACT, 1, 35, 5 },
+    { 40 * MHZ, 125000, 0, false, EXPECT_EXACT, 2, 140, 20 },
+    { 40 * MHZ, 10000, 0, false, EXPECT_EXACT, 20, 175, 25 },
+    { 60 * MHZ, 500000, 0, false, EXPECT_EXACT, 1, 105, 15 },
+    { 60 * MHZ, 250000, 0, false, EXPECT_EXACT, 1, 210, 30 },
+    { 60 * MHZ, 1000000, 0, false, EXPECT_EXACT, 1, 53, 7 },
+    { 80 * MHZ, 500000, 0, false, EXPECT_EXACT, 1, 140, 20 },
+    { 80 * MHZ, 1000000, 0, false, EXPECT_EXACT, 1, 70, 10 },
+    { 80 * MHZ, 10000, 0, false, EXPECT_EXACT, 40, 175, 25 },
+    /* requested sample point */
+    { 40 * MHZ, 500000, 800, false, EXPECT_EXACT, 1, 64, 16 },
+    { 80 * MHZ, 250000, 700, false, EXPECT_EXACT, 0, 0, 0 },
+    /* not a common rate, but the clock divides to it */
+    { 40 * MHZ, 800000, 0, false, EXPECT_EXACT, 1, 44, 6 },
+    { 60 * MHZ, 33333, 0, false, EXPECT_EXACT, 0, 0, 0 },
+    { 80 * MHZ, 83333, 0, false, EXPECT_EXACT, 0, 0, 0 },
+    /* no exact divider */
+    { 40 * MHZ, 95000, 0, false, EXPECT_INEXACT, 2, 185, 26 },
+    { 60 * MHZ, 95000, 0, false, EXPECT_INEXACT, 0, 0, 0 },
+    { 80 * MHZ, 95000, 0, false, EXPECT_INEXACT, 3, 246, 35 },
+    /* nominal rates out of reach */
+    { 40 * MHZ, 3000000, 0, false, EXPECT_REJECT, 0, 0, 0 },
+    { 40 * MHZ, 10000000, 0, false, EXPECT_REJECT, 0, 0, 0 },
+    { 60 * MHZ, 7000000, 0, false, EXPECT_REJECT, 0, 0, 0 },
+    { 80 * MHZ, 6000000, 0, false, EXPECT_REJECT, 0, 0, 0 },
+    { 80 * MHZ, 200, 0, false, EXPECT_REJECT, 0, 0, 0 },
+    /* just past the tolerance, 7444 and 8264 ppm at best */
+    { 40 * MHZ, 1300000, 0, false, EXPECT_REJECT, 0, 0, 0 },
+    { 60 * MHZ, 1100000, 0, false, EXPECT_REJECT, 0, 0, 0 },
+
+    /* usual data rates */
+    { 40 * MHZ, 2000000, 0, true, EXPECT_EXACT, 1, 15, 5 },
+    { 40 * MHZ, 5000000, 0, true, EXPECT_EXACT, 1, 6, 2 },
+    { 60 * MHZ, 2000000, 0, true, EXPECT_EXACT, 1, 23, 7 },
+    { 60 * MHZ, 5000000, 0, true, EXPECT_EXACT, 1, 9, 3 },
+    { 80 * MHZ, 2000000, 0, true, EXPECT_EXACT, 1, 30, 10 },
+    { 80 * MHZ, 4000000, 0, true, EXPECT_EXACT, 1, 15, 5 },
+    { 80 * MHZ, 5000000, 0, true, EXPECT_EXACT, 1, 12, 4 },
+    { 80 * MHZ, 8000000, 0, true, EXPECT_EXACT, 1, 8, 2 },
+    { 60 * MHZ, 12000000, 0, true, EXPECT_EXACT, 1, 4, 1 },
+    /* data phase below the TDC threshold */
+    { 80 * MHZ, 500000, 0, true, EXPECT_EXACT, 4, 30, 10 },
+    { 40 * MHZ, 95000, 0, true, EXPECT_INEXACT, 15, 21, 7 },
+    { 80 * MHZ, 95000, 0, true, EXPECT_INEXACT, 0, 0, 0 },
+    /* data rates out of reach: too slow for DBRP * 49 quanta, or no divider */
+    { 40 * MHZ, 20000, 0, true, EXPECT_REJECT, 0, 0, 0 },
+    { 60 * MHZ, 33333, 0, true, EXPECT_REJECT, 0, 0, 0 },
+    { 80 * MHZ, 50000, 0, true, EXPECT_REJECT, 0, 0, 0 },
+    { 40 * MHZ, 3000000, 0, true, EXPECT_REJECT, 0, 0, 0 },
+    { 60 * MHZ, 8000000, 0, true, EXPECT_REJECT, 0, 0, 0 },
+    { 80 * MHZ, 12000000, 0, true, EXPECT_REJECT, 0, 0, 0 },
+    { 40 * MHZ, 3100000, 0, true, EXPECT_REJECT, 0, 0, 0 },
+
+    /* bad arguments */
+    { 0, 500000, 0, false, EXPECT_REJECT, 0, 0, 0 },
+    { 40 * MHZ, 0, 0, false, EXPECT_REJECT, 0, 0, 0 },
+    { 40 * MHZ, 500000, 1000, false, EXPECT_REJECT, 0, 0, 0 },
+};
+
+static bool test_verbose;
+
+static uint32_t test_abs_diff(uint32_t a, uint32_t b)
+{
+    return (a > b) ? (a - b) : (b - a);
+}
+
+static uint32_t test_error_ppm(uint32_t achieved, uint32_t bitrate)
+{
+    return (uint32_t)(((uint64_t)test_abs_diff(achieved, bitrate) * 1000000U) / bitrate);
+}
+
+/* smallest rate error of any prescaler / quanta pair the limits allow, UINT32_MAX for none */
+static uint32_t test_best_error_ppm(uint32_t clock_hz, uint32_t bitrate, const slcan_bt_limits_t *limits)
+{
+    uint32_t best = UINT32_MAX;
+
+    for (uint32_t pre = limits->prescaler_min; pre <= limits->prescaler_max; pre++) {
+        for (uint32_t tq = limits->seg1_min + limits->seg2_min; tq <= limits->seg1_max + limits->seg2_max; tq++) {
+            uint32_t err = test_error_ppm(clock_hz / (pre * tq), bitrate);
+            if (err < best) {
+                best = err;
+            }
+        }
+    }
+    return best;
+}
+
+static int test_one(const test_case_t *tc)
+{
+    const slcan_bt_limits_t *limits = tc->data_phase ? &slcan_bt_mcan_data : &slcan_bt_mcan_nominal;
+    uint16_t sample_point = tc->sample_point;
+    slcan_bt_timing_t t;
+    uint32_t tq;
+    uint32_t err;
+    uint32_t best;
+    bool ok;
+    int errors = 0;
+
+    memset(&t, 0, sizeof(t));
+    ok = slcan_bt_solve(tc->clock_hz, tc->bitrate, tc->sample_point, tc->data_phase, limits, &t);
+    if (test_verbose) {
+        printf("%3lu MHz %8u bit/s %s: ", (unsigned long)(tc->clock_hz / MHZ), tc->bitrate, tc->data_phase ? "data" : "nominal");
+        if (ok) {
+            printf("pre %u seg1 %u seg2 %u sjw %u, %u bit/s sp %u tdc %u/%u\n", t.prescaler, t.seg1, t.seg2, t.sjw,
+                   t.bitrate, t.sample_point, t.tdc_enable, t.tdc_offset);
+        } else {
+            printf("rejected\n");
+        }
+    }
+
+    if ((tc->clock_hz == 0) || (tc->bitrate == 0) || (tc->sample_point >= 1000U)) {
+        if (ok) {
+            fprintf(stderr, "clock %u rate %u sp %u: bad arguments accepted\n", tc->clock_hz, tc->bitrate,
+                    tc->sample_point);
+            errors++;
+        }
+        return errors;
+    }
+
+    best = test_best_error_ppm(tc->clock_hz, tc->bitrate, limits);
+    if (ok != (tc->expect != EXPECT_REJECT)) {
+        fprintf(stderr, "%u Hz %u bit/s: %s, expected %s (best error %u ppm)\n", tc->clock_hz, tc->bitrate,
+                ok ? "accepted" : "rejected", ok ? "rejected" : "accepted", best);
+        return 1;
+    }
+    if (!ok) {
+        if (best <= SLCAN_BT_MAX_ERROR_PPM) {
+            fprintf(stderr, "%u Hz %u bit/s: rejected, but a combination is %u ppm off\n", tc->clock_hz, tc->bitrate,
+                    best);
+            errors++;
+        }
+        return errors;
+    }
+
+    tq = t.seg1 + t.seg2;
+    if ((t.prescaler < limits->prescaler_min) || (t.prescaler > limits->prescaler_max)
+        || (t.seg1 < limits->seg1_min) || (t.seg1 > limits->seg1_max)
+        || (t.seg2 < limits->seg2_min) || (t.seg2 > limits->seg2_max)
+        || (t.sjw == 0) || (t.sjw > t.seg2) || (t.sjw > limits->sjw_max)) {
+        fprintf(stderr, "%u Hz %u bit/s: pre %u seg1 %u seg2 %u sjw %u out of the register limits\n", tc->clock_hz,
+                tc->bitrate, t.prescaler, t.seg1, t.seg2, t.sjw);
+        errors++;
+    }
+    if (t.bitrate != tc->clock_hz / (t.prescaler * tq)) {
+        fprintf(stderr, "%u Hz %u bit/s: reports %u bit/s, the registers give %u\n", tc->clock_hz, tc->bitrate,
+                t.bitrate, tc->clock_hz / (t.prescaler * tq));
+        errors++;
+    }
+    err = test_error_ppm(t.bitrate, tc->bitrate);
+    if ((tc->expect == EXPECT_EXACT) ? (err != 0) : ((err == 0) || (err > SLCAN_BT_MAX_ERROR_PPM))) {
+        fprintf(stderr, "%u Hz %u bit/s: %u bit/s is %u ppm off\n", tc->clock_hz, tc->bitrate, t.bitrate, err);
+        errors++;
+    }
+    if (err != best) {
+        fprintf(stderr, "%u Hz %u bit/s: %u ppm off, %u ppm is possible\n", tc->clock_hz, tc->bitrate, err, best);
+        errors++;
+    }
+    if (t.sample_point != (t.seg1 * 1000U + tq / 2) / tq) {
+        fprintf(stderr, "%u Hz %u bit/s: reports sample point %u for seg1 %u of %u\n", tc->clock_hz, tc->bitrate,
+                t.sample_point, t.seg1, tq);
+        errors++;
+    }
+    if (sample_point == 0) {
+        sample_point = tc->data_phase ? SLCAN_BT_DATA_SP : SLCAN_BT_NOMINAL_SP;
+    }
+    /* a quantum off, or pushed by the seg2 minimum on short bits */
+    if ((test_abs_diff(t.sample_point, sample_point) * tq > 1000U)
+        && (t.seg2 != limits->seg2_min)) {
+        fprintf(stderr, "%u Hz %u bit/s: sample point %u, requested %u\n", tc->clock_hz, tc->bitrate,
+                t.sample_point, sample_point);
+        errors++;
+    }
+    if ((tc->prescaler != 0)
+        && ((t.prescaler != tc->prescaler) || (t.seg1 != tc->seg1) || (t.seg2 != tc->seg2))) {
+        fprintf(stderr, "%u Hz %u bit/s: pre %u seg1 %u seg2 %u, expected %u %u %u\n", tc->clock_hz, tc->bitrate,
+                t.prescaler, t.seg1, t.seg2, tc->prescaler, tc->seg1, tc->seg2);
+        errors++;
+    }
+    if (t.tdc_enable != (tc->data_phase && (tc->bitrate >= SLCAN_BT_TDC_MIN_RATE))) {
+        fprintf(stderr, "%u Hz %u bit/s %s: tdc %s\n", tc->clock_hz, tc->bitrate, tc->data_phase ? "data" : "nominal",
+                t.tdc_enable ? "enabled" : "disabled");
+        errors++;
+    }
+    if (t.tdc_enable && (t.tdc_offset != t.prescaler * t.seg1)) {
+        fprintf(stderr, "%u Hz %u bit/s: tdc offset %u, the sample point is %u clocks in\n", tc->clock_hz,
+                tc->bitrate, t.tdc_offset, t.prescaler * t.seg1);
+        errors++;
+    }
+    if (!t.tdc_enable && (t.tdc_offset != 0)) {
+        fprintf(stderr, "%u Hz %u bit/s: tdc offset %u while disabled\n", tc->clock_hz, tc->bitrate, t.tdc_offset);
+        errors++;
+    }
+    return errors;
+}
+
+/* the threshold itself, and the offset clamp that no MCAN clock reaches */
+static int test_tdc(void)
+{
+    slcan_bt_limits_t limits = slcan_bt_mcan_data;
+    slcan_bt_timing_t t;
+    int errors = 0;
+
+    if (!slcan_bt_solve(40 * MHZ, SLCAN_BT_TDC_MIN_RATE - 1, 0, true, &limits, &t) || t.tdc_enable) {
+        fprintf(stderr, "tdc: enabled, or no timing, just below the threshold\n");
+        errors++;
+    }
+    if (!slcan_bt_solve(40 * MHZ, SLCAN_BT_TDC_MIN_RATE, 0, true, &limits, &t) || !t.tdc_enable
+        || (t.tdc_offset != 30)) {
+        fprintf(stderr, "tdc: not enabled at the threshold, or offset %u instead of 30\n", t.tdc_offset);
+        errors++;
+    }
+    if (!slcan_bt_solve(80 * MHZ, SLCAN_BT_TDC_MIN_RATE, 0, false, &slcan_bt_mcan_nominal, &t) || t.tdc_enable) {
+        fprintf(stderr, "tdc: enabled in the nominal phase\n");
+        errors++;
+    }
+    limits.tdco_max = 20;
+    if (!slcan_bt_solve(80 * MHZ, SLCAN_BT_TDC_MIN_RATE, 0, true, &limits, &t) || !t.tdc_enable
+        || (t.tdc_offset != 20)) {
+        fprintf(stderr, "tdc: offset %u not clamped to 20\n", t.tdc_offset);
+        errors++;
+    }
+    limits.tdco_max = 0;
+    if (!slcan_bt_solve(80 * MHZ, 5 * MHZ, 0, true, &limits, &t) || t.tdc_enable) {
+        fprintf(stderr, "tdc: enabled on a controller without it\n");
+        errors++;
+    }
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t count = sizeof(test_cases) / sizeof(test_cases[0]);
+    int errors = 0;
+
+    test_verbose = (argc > 1) && (strcmp(argv[1], "-v") == 0);
+    for (uint32_t i = 0; i < count; i++) {
+        errors += test_one(&test_cases[i]);
+    }
+    errors += test_tdc();
+    printf("%u bit timing cases, tdc threshold: %d errors\n", count, errors);
+    return (errors == 0) ? 0 : 1;
+}
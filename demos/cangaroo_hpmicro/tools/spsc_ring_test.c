@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host stress test for inc/spsc_ring.h.
+ * One producer and one consumer thread move numbered elements through a small
+ * ring, so it runs full and empty constantly. The consumer checks that every
+ * element arrives once, in order and unchanged. Both threads alternate between
+ * the in place setup/done pair and the copying spsc_ring_write()/_read(). The
+ * indices start just below the 32 bit wrap so the wrap is crossed as well.
+ * A thread that finds the ring full or empty yields, so it also runs on one core.
+ *
+ * build: cc -O2 -pthread -I../inc -o spsc_ring_test spsc_ring_test.c
+ * usage: spsc_ring_test [elements] [depth]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include "spsc_ring.h"
+
+/* about the size of an mcan_rx_frame_t */
+typedef struct {
+    uint32_t seq;
+    uint32_t data[17];
+} test_elem_t;
+
+static spsc_ring_t test_ring;
+static uint64_t test_count;
+static uint64_t test_errors;
+static uint64_t test_full;
+static uint64_t test_empty;
+
+static void test_fill(test_elem_t *elem, uint32_t seq)
+{
+    elem->seq = seq;
+    for (uint32_t i = 0; i < 17; i++) {
+        elem->data[i] = seq * 2654435761U + i;
+    }
+}
+
+static int test_check(const test_elem_t *elem, uint32_t seq)
+{
+    if (elem->seq != seq) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < 17; i++) {
+        if (elem->data[i] != seq * 2654435761U + i) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void *test_producer(void *arg)
+{
+    test_elem_t elem;
+    test_elem_t *slot;
+    (void)arg;
+
+    for (uint64_t n = 0; n < test_count; n++) {
+        if (n & 1) {
+            test_fill(&elem, (uint32_t)n);
+            while (spsc_ring_write(&test_ring, &elem) == false) {
+                test_full++;
+                sched_yield();
+            }
+        } else {
+            while ((slot = spsc_ring_write_setup(&test_ring)) == NULL) {
+                test_full++;
+                sched_yield();
+            }
+            test_fill(slot, (uint32_t)n);
+            spsc_ring_write_done(&test_ring);
+        }
+    }
+    return NULL;
+}
+
+static void *test_consumer(void *arg)
+{
+    test_elem_t elem;
+    test_elem_t *slot;
+    (void)arg;
+
+    for (uint64_t n = 0; n < test_count; n++) {
+        if (n & 2) {
+            while (spsc_ring_read(&test_ring, &elem) == false) {
+                test_empty++;
+                sched_yield();
+            }
+            slot = &elem;
+        } else {
+            while ((slot = spsc_ring_read_setup(&test_ring)) == NULL) {
+                test_empty++;
+                sched_yield();
+            }
+        }
+        if (test_check(slot, (uint32_t)n) != 0) {
+            if (test_errors++ < 10) {
+                fprintf(stderr, "element %llu: got seq %u\n", (unsigned long long)n, slot->seq);
+            }
+        }
+        if (slot != &elem) {
+            spsc_ring_read_done(&test_ring);
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    static test_elem_t pool[1024];
+    pthread_t producer;
+    pthread_t consumer;
+    uint32_t depth;
+
+    test_count = (argc > 1) ? strtoull(argv[1], NULL, 0) : 10000000ULL;
+    depth = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 8;
+    if ((depth > 1024) || (spsc_ring_init(&test_ring, pool, sizeof(test_elem_t), depth) != 0)) {
+        fprintf(stderr, "depth must be a power of two up to 1024\n");
+        return 1;
+    }
+    if (spsc_ring_init(&test_ring, pool, sizeof(test_elem_t), 3) != -1) {
+        fprintf(stderr, "depth 3 accepted\n");
+        return 1;
+    }
+    spsc_ring_init(&test_ring, pool, sizeof(test_elem_t), depth);
+    /* cross the index wrap early on */
+    test_ring.head = 0U - 5U * depth;
+    test_ring.tail = test_ring.head;
+
+    pthread_create(&consumer, NULL, test_consumer, NULL);
+    pthread_create(&producer, NULL, test_producer, NULL);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    if (spsc_ring_check_empty(&test_ring) == false) {
+        fprintf(stderr, "ring not empty at the end\n");
+        test_errors++;
+    }
+    printf("%llu elements through depth %u: %llu errors, %llu full and %llu empty retries\n",
+           (unsigned long long)test_count, depth, (unsigned long long)test_errors,
+           (unsigned long long)test_full, (unsigned long long)test_empty);
+    return (test_errors == 0) ? 0 : 1;
+}
@@ -10,12 +10,29 @@
 #include <hpm_gpiom_soc_drv.h>
 #include <hpm_gptmr_drv.h>
 #include <hpm_soc.h>
+#include <hpm_csr_drv.h>
 #include <string.h>
 
 
 #if WS2812_USE_SPI
 #include "hpm_spi.h"
+#include "hpm_interrupt.h"
 #define  WS212_SPI_FREQ            (8000000UL)
+
+typedef struct {
+    SPI_Type *spi;
+    clock_name_t clock;
+    uint32_t din_pad;
+    uint32_t din_alt;
+} ws2812_strip_t;
+
+static const ws2812_strip_t ws2812_strips[WS2812_STRIP_NUM] = {
+    WS2812_STRIP_TABLE
+};
+
+static volatile uint8_t ws2812_strips_busy;  /* strips still clocking out the current frame */
+
+void spi_txdma_complete_callback(uint32_t channel);
 #endif
 
 #define _BUFFER_CONCAT3(x, y, z)     x ## y ## z
@@ -23,23 +40,32 @@
 
 typedef BUFFER_CONCAT3(uint, WS2812_BIT_TYPE_SIZE, _t)  buffer_type;
 
+/* 两帧之间的复位(锁存)时间 */
+#define WS2812_RESET_US     (300U)
+
 #if !WS2812_USE_SPI
 static uint32_t _gptmr_freq = 0;
 static buffer_type _bit0_pluse_width = 0;
 static buffer_type _bit1_pluse_width = 0;
 static const uint32_t _WS2812_Freq = 800000;
 static const uint32_t _WS2812_DATA_WIDTH = DMA_MGR_TRANSFER_WIDTH_WORD;
+/* one descriptor chain per symbol buffer, built once by DMA_Init() */
 ATTR_PLACE_AT_NONCACHEABLE_BSS_WITH_ALIGNMENT(8)
-static dma_linked_descriptor_t descriptors[WS2812_LED_NUM - 1];
+static dma_linked_descriptor_t descriptors[2][WS2812_LED_NUM - 1];
+static dma_mgr_chn_conf_t dma_head_config[2];
 static dma_resource_t dma_resource_pool;
 #else
 static buffer_type _bit0_pluse_width = 0xe0;  /* 0b11100000 40% high */
 static buffer_type _bit1_pluse_width = 0xF8;  /* 0b11111000 60% high */
 #endif
 
-
+/*
+ * Ping-pong symbol buffers: one is clocked out while the next frame is
+ * encoded into the other. WS2812_LED[].buffer points into buffer 0, the same
+ * offsets are used in buffer 1.
+ */
 ATTR_PLACE_AT_NONCACHEABLE_BSS_WITH_ALIGNMENT(4)
-static buffer_type WS2812_LED_Buffer
+static buffer_type WS2812_LED_Buffer[2]
 #if WS2812_LED_CONNECT == WS2812_CONNECT_LINE
     [WS2812_LED_NUM][24];
 #elif WS2812_LED_CONNECT == WS2812_CONNECT_MATRIX
@@ -53,6 +79,22 @@ ATTR_PLACE_AT_NONCACHEABLE WS2812_LED_t WS2812_LED[WS2812_LED_NUM];
 ATTR_PLACE_AT_NONCACHEABLE WS2812_RGB_t WS2812_Buffer[WS2812_LED_NUM];
 
 static volatile bool dma_is_done = false;
+static volatile uint64_t dma_done_cycle;   /* end of the last frame, for the reset time */
+
+/* the 8 symbols of one colour byte, MSB first */
+static buffer_type ws2812_lut[256][8];
+/* symbol offset of each LED inside a symbol buffer */
+static uint32_t ws2812_offset[WS2812_LED_NUM];
+/* LEDs changed since each symbol buffer was encoded, [lo, hi) */
+static uint32_t ws2812_dirty_lo[2];
+static uint32_t ws2812_dirty_hi[2];
+static uint8_t ws2812_front;              /* buffer being or last clocked out */
+static bool ws2812_pending;               /* the other buffer is encoded and waits for the strip */
+
+static buffer_type *ws2812_led_symbols(uint8_t buf, uint32_t index)
+{
+    return (buffer_type *)WS2812_LED_Buffer[buf] + ws2812_offset[index];
+}
 
 #if !WS2812_USE_SPI
 static void GPTMR_Init()
@@ -72,10 +114,11 @@ static void GPTMR_Init()
 }
 
 #else
-static void spi_init(void)
+static void spi_init(const ws2812_strip_t *strip)
 {
     spi_initialize_config_t init_config;
-    clock_add_to_group(WS2812_SPI_CLCOK, 0);
+    HPM_IOC->PAD[strip->din_pad].FUNC_CTL = IOC_PAD_FUNC_CTL_ALT_SELECT_SET(strip->din_alt);
+    clock_add_to_group(strip->clock, 0);
     hpm_spi_get_default_init_config(&init_config);
     init_config.direction = msb_first;
     init_config.mode = spi_master_mode;
@@ -83,11 +126,23 @@ static void spi_init(void)
     init_config.clk_polarity = spi_sclk_low_idle;
     init_config.data_len = WS2812_BIT_TYPE_SIZE;
     /* step.1  initialize spi */
-    if (hpm_spi_initialize(WS2812_SPI, &init_config) != status_success) {
+    if (hpm_spi_initialize(strip->spi, &init_config) != status_success) {
         printf("hpm_spi_initialize fail\n");
         while (1) {
         }
     }
+    /* step.2  set spi sclk frequency for master */
+    if (hpm_spi_set_sclk_frequency(strip->spi, WS212_SPI_FREQ) != status_success) {
+        printf("hpm_spi_set_sclk_frequency fail\n");
+        while (1) {
+        }
+    }
+    /* step.3 install dma callback if want use dma */
+    if (hpm_spi_dma_install_callback(strip->spi, spi_txdma_complete_callback, NULL) != status_success) {
+        printf("hpm_spi_dma_install_callback fail\n");
+        while (1) {
+        }
+    }
 }
 #endif
 
@@ -101,7 +156,7 @@ void WS2812_LEDConnectInit(void)
     // 默认情况下每一个灯都是首尾相连，链表中的第一个灯的数据是第一个灯的数据，最后一个灯的数据是第一个灯的数据
     for (size_t i = 0; i < WS2812_LED_NUM; i++)
     {
-        WS2812_LED[i].buffer = &WS2812_LED_Buffer[i][0];
+        WS2812_LED[i].buffer = &WS2812_LED_Buffer[0][i][0];
         if (i < WS2812_LED_NUM - 1)
         {
             WS2812_LED[i].next = &WS2812_LED[(i + 1) % WS2812_LED_NUM];
@@ -115,7 +170,7 @@ void WS2812_LEDConnectInit(void)
         for (int j = 0; j < WS2812_LED_ROW; j++)
         {
             uint32_t index = i * WS2812_LED_ROW + j;
-            WS2812_LED[index].buffer = WS2812_LED_Buffer[i][j];
+            WS2812_LED[index].buffer = WS2812_LED_Buffer[0][i][j];
             if (index < WS2812_LED_NUM - 1)
             {
                 WS2812_LED[index].next = &WS2812_LED[index + 1];
@@ -132,7 +187,7 @@ void WS2812_LEDConnectInit(void)
             for (int k = 0; k < WS2812_LED_LAYER; k++)
             {
                 uint32_t index = i * WS2812_LED_ROW * WS2812_LED_LAYER + j * WS2812_LED_LAYER + k;
-                WS2812_LED[index].buffer = WS2812_LED_Buffer[i][j][k];
+                WS2812_LED[index].buffer = WS2812_LED_Buffer[0][i][j][k];
                 if (index < WS2812_LED_NUM - 1)
                 {
                     WS2812_LED[index].next = &WS2812_LED[index + 1];
@@ -164,79 +219,72 @@ void WS2812_DMA_Callback(DMAV2_Type *ptr, uint32_t channel, void *user_data)
             HPM_IOC->PAD[_WS2812_DIN_PIN].FUNC_CTL = IOC_PAD_FUNC_CTL_ALT_SELECT_SET(0);
             gpio_write_pin(HPM_GPIO0, GPIO_GET_PORT_INDEX(_WS2812_DIN_PIN), GPIO_GET_PIN_INDEX(_WS2812_DIN_PIN), 0);
 
+            dma_done_cycle = hpm_csr_get_core_cycle();
             dma_is_done = true;
             i = 0;
         }
     }
 }
 
+static void DMA_Fill_Config(dma_mgr_chn_conf_t *ch_config, buffer_type *src)
+{
+    dma_mgr_get_default_chn_config(ch_config);
+    ch_config->src_addr = core_local_mem_to_sys_address(HPM_CORE0, (uint32_t)src);
+    ch_config->dst_addr = (uint32_t)&_WS2812_GPTMR_PTR->CHANNEL[WS2812_GPTMR_CHANNLE].CMP[0];
+    ch_config->src_mode = DMA_MGR_HANDSHAKE_MODE_NORMAL;
+    ch_config->src_width = _WS2812_DATA_WIDTH;
+    ch_config->src_addr_ctrl = DMA_MGR_ADDRESS_CONTROL_INCREMENT;
+    ch_config->src_burst_size = DMA_MGR_NUM_TRANSFER_PER_BURST_1T;
+    ch_config->dst_width = _WS2812_DATA_WIDTH;
+    ch_config->dst_addr_ctrl = DMA_MGR_ADDRESS_CONTROL_FIXED;
+    ch_config->dst_mode = DMA_MGR_HANDSHAKE_MODE_HANDSHAKE;
+    ch_config->size_in_byte = 96;
+    ch_config->priority = DMA_MGR_CHANNEL_PRIORITY_HIGH;
+    ch_config->en_dmamux = true;
+    ch_config->dmamux_src = _WS2812_DMAMUX_SRC;
+}
+
+/* 为两个缓冲区各生成一次描述符链，之后每帧只需重新装载链头 */
 void DMA_Init()
 {
     dma_mgr_chn_conf_t ch_config;
     dma_resource_t *resource = NULL;
 
     resource = &dma_resource_pool;
-    dma_mgr_get_default_chn_config(&ch_config);
-
-    for (int i = 0; i < WS2812_LED_NUM - 1; i++)
+    for (uint8_t buf = 0; buf < 2; buf++)
     {
-        ch_config.src_addr = core_local_mem_to_sys_address(HPM_CORE0, (uint32_t)&WS2812_LED[i + 1].buffer[0]);
-        ch_config.dst_addr = (uint32_t)&_WS2812_GPTMR_PTR->CHANNEL[WS2812_GPTMR_CHANNLE].CMP[0];
-        ch_config.src_mode = DMA_MGR_HANDSHAKE_MODE_NORMAL;
-        ch_config.src_width = _WS2812_DATA_WIDTH;
-        ch_config.src_addr_ctrl = DMA_MGR_ADDRESS_CONTROL_INCREMENT;
-        ch_config.src_burst_size = DMA_MGR_NUM_TRANSFER_PER_BURST_1T;
-        ch_config.dst_width = _WS2812_DATA_WIDTH;
-        ch_config.dst_addr_ctrl = DMA_MGR_ADDRESS_CONTROL_FIXED;
-        ch_config.dst_mode = DMA_MGR_HANDSHAKE_MODE_HANDSHAKE;
-        ch_config.size_in_byte = 96;
-        ch_config.priority = DMA_MGR_CHANNEL_PRIORITY_HIGH;
-        ch_config.en_dmamux = true;
-        ch_config.dmamux_src = _WS2812_DMAMUX_SRC;
-        if (i == (WS2812_LED_NUM - 2))
-        {
-            ch_config.linked_ptr = 0;
-        }
-        else
-        {
-            ch_config.linked_ptr = core_local_mem_to_sys_address(HPM_CORE0, (uint32_t)&descriptors[i + 1]);
-        }
-        if (status_success !=
-            dma_mgr_config_linked_descriptor(resource, &ch_config, (dma_mgr_linked_descriptor_t *)&descriptors[i]))
+        for (int i = 0; i < WS2812_LED_NUM - 1; i++)
         {
-            printf("generate dma desc fail\n");
-            return;
+            DMA_Fill_Config(&ch_config, ws2812_led_symbols(buf, i + 1));
+            if (i == (WS2812_LED_NUM - 2))
+            {
+                ch_config.linked_ptr = 0;
+            }
+            else
+            {
+                ch_config.linked_ptr = core_local_mem_to_sys_address(HPM_CORE0, (uint32_t)&descriptors[buf][i + 1]);
+            }
+            if (status_success !=
+                dma_mgr_config_linked_descriptor(resource, &ch_config, (dma_mgr_linked_descriptor_t *)&descriptors[buf][i]))
+            {
+                printf("generate dma desc fail\n");
+                return;
+            }
+            descriptors[buf][i].ctrl &= ~DMA_MGR_INTERRUPT_MASK_TC;
         }
-        descriptors[i].ctrl &= ~DMA_MGR_INTERRUPT_MASK_TC;
-    }
 
-    dma_mgr_get_default_chn_config(&ch_config);
-    //    ch_config.src_addr = core_local_mem_to_sys_address(HPM_CORE0, (uint32_t) WS2812_LED[0].buffer);
-    ch_config.src_addr = core_local_mem_to_sys_address(HPM_CORE0, (uint32_t)&WS2812_LED[0].buffer[0]);
-    ch_config.dst_addr = (uint32_t)&_WS2812_GPTMR_PTR->CHANNEL[WS2812_GPTMR_CHANNLE].CMP[0];
-    ch_config.src_mode = DMA_MGR_HANDSHAKE_MODE_NORMAL;
-    ch_config.src_width = _WS2812_DATA_WIDTH;
-    ch_config.src_addr_ctrl = DMA_MGR_ADDRESS_CONTROL_INCREMENT;
-    ch_config.src_burst_size = DMA_MGR_NUM_TRANSFER_PER_BURST_1T;
-    ch_config.dst_width = _WS2812_DATA_WIDTH;
-    ch_config.dst_addr_ctrl = DMA_MGR_ADDRESS_CONTROL_FIXED;
-    ch_config.dst_mode = DMA_MGR_HANDSHAKE_MODE_HANDSHAKE;
-    ch_config.size_in_byte = 96;
-    ch_config.priority = DMA_MGR_CHANNEL_PRIORITY_HIGH;
-    ch_config.en_dmamux = true;
-    ch_config.dmamux_src = _WS2812_DMAMUX_SRC;
+        DMA_Fill_Config(&dma_head_config[buf], ws2812_led_symbols(buf, 0));
 #if WS2812_LED_NUM == 1
-    ch_config.linked_ptr = 0;
+        dma_head_config[buf].linked_ptr = 0;
 #else
-    ch_config.linked_ptr = core_local_mem_to_sys_address(HPM_CORE0, (uint32_t)&descriptors[0]);
-
+        dma_head_config[buf].linked_ptr = core_local_mem_to_sys_address(HPM_CORE0, (uint32_t)&descriptors[buf][0]);
 #endif
-    if (status_success != dma_mgr_setup_channel(resource, &ch_config))
+    }
+    if (status_success != dma_mgr_setup_channel(resource, &dma_head_config[0]))
     {
         printf("DMA setup channel failed\n");
         return;
     }
-    //    dma_mgr_setup_channel(resource, &ch_config);
     dma_mgr_install_chn_tc_callback(resource, WS2812_DMA_Callback, NULL);
     dma_mgr_enable_chn_irq(resource, DMA_MGR_INTERRUPT_MASK_TC);
     dma_mgr_enable_dma_irq_with_priority(resource, 1);
@@ -245,9 +293,92 @@ void DMA_Init()
 void spi_txdma_complete_callback(uint32_t channel)
 {
     (void)channel;
-    dma_is_done = true;
+    /* every strip reports here, the frame is out with the last one */
+    if ((ws2812_strips_busy != 0) && (--ws2812_strips_busy == 0))
+    {
+        dma_done_cycle = hpm_csr_get_core_cycle();
+        dma_is_done = true;
+    }
+}
+#endif
+
+static void ws2812_mark_dirty(uint32_t index)
+{
+    for (int buf = 0; buf < 2; buf++)
+    {
+        if (index < ws2812_dirty_lo[buf])
+        {
+            ws2812_dirty_lo[buf] = index;
+        }
+        if (index >= ws2812_dirty_hi[buf])
+        {
+            ws2812_dirty_hi[buf] = index + 1;
+        }
+    }
+}
+
+/* 用查找表把脏区间内的像素编码到指定缓冲区 */
+static void ws2812_encode(uint8_t buf)
+{
+    for (uint32_t index = ws2812_dirty_lo[buf]; index < ws2812_dirty_hi[buf]; index++)
+    {
+        buffer_type *sym = ws2812_led_symbols(buf, index);
+        // GRB
+        memcpy(&sym[0], ws2812_lut[WS2812_Buffer[index].g], sizeof(ws2812_lut[0]));
+        memcpy(&sym[8], ws2812_lut[WS2812_Buffer[index].r], sizeof(ws2812_lut[0]));
+        memcpy(&sym[16], ws2812_lut[WS2812_Buffer[index].b], sizeof(ws2812_lut[0]));
+    }
+    ws2812_dirty_lo[buf] = WS2812_LED_NUM;
+    ws2812_dirty_hi[buf] = 0;
 }
+
+/* the last frame is out and the strip has latched it */
+static bool ws2812_idle(void)
+{
+    uint64_t reset_cycles = (uint64_t)hpm_core_clock / 1000000U * WS2812_RESET_US;
+    return dma_is_done && ((hpm_csr_get_core_cycle() - dma_done_cycle) >= reset_cycles);
+}
+
+static void ws2812_start(uint8_t buf)
+{
+    ws2812_front = buf;
+    ws2812_pending = false;
+    dma_is_done = false;
+#if !WS2812_USE_SPI
+    HPM_IOC->PAD[_WS2812_DIN_PIN].FUNC_CTL = _WS2812_DIN_FUNC; // 初始化GPIO
+    dma_mgr_setup_channel(&dma_resource_pool, &dma_head_config[buf]);
+    dma_mgr_enable_chn_irq(&dma_resource_pool, DMA_MGR_INTERRUPT_MASK_TC);
+    dma_mgr_enable_channel(&dma_resource_pool);
+    gptmr_start_counter(_WS2812_GPTMR_PTR, WS2812_GPTMR_CHANNLE);
+#else
+    /* all strips are started back to back, completions are counted once every one is running */
+    uint32_t level = disable_global_irq(CSR_MSTATUS_MIE_MASK);
+    uint8_t started = 0;
+    for (int i = 0; i < WS2812_STRIP_NUM; i++)
+    {
+        buffer_type *sym = (buffer_type *)WS2812_LED_Buffer[buf] + i * WS2812_STRIP_LED_NUM * 24;
+        if (hpm_spi_transmit_nonblocking(ws2812_strips[i].spi, sym, WS2812_STRIP_LED_NUM * 24) != status_success) {
+            printf("hpm_spi_transmit_receive_nonblocking fail\n");
+            continue;
+        }
+        started++;
+    }
+    ws2812_strips_busy = started;
+    if (started == 0) {
+        dma_is_done = true;
+    }
+    restore_global_irq(level);
 #endif
+}
+
+/* start a pending frame once the strip is free */
+static void ws2812_kick(void)
+{
+    if (ws2812_pending && ws2812_idle())
+    {
+        ws2812_start(ws2812_front ^ 1);
+    }
+}
 
 void WS2812_Init(void)
 {
@@ -262,120 +393,78 @@ void WS2812_Init(void)
     _bit0_pluse_width = _gptmr_freq / _WS2812_Freq / 3;     // 0的脉冲宽度
     _bit1_pluse_width = _gptmr_freq / _WS2812_Freq * 2 / 3; // 1的脉冲宽度
 #else
-    HPM_IOC->PAD[IOC_PAD_PB13].FUNC_CTL = IOC_PAD_FUNC_CTL_ALT_SELECT_SET(5);
-    /* step.1  initialize spi */
-    spi_init();
-    /* step.2  set spi sclk frequency for master */
-    if (hpm_spi_set_sclk_frequency(WS2812_SPI, WS212_SPI_FREQ) != status_success) {
-        printf("hpm_spi_set_sclk_frequency fail\n");
-        while (1) {
-        }
-    }
-
-    /* step.3 install dma callback if want use dma */
-    if (hpm_spi_dma_install_callback(WS2812_SPI, spi_txdma_complete_callback, NULL) != status_success) {
-        printf("hpm_spi_dma_install_callback fail\n");
-        while (1) {
-        }
+    for (int i = 0; i < WS2812_STRIP_NUM; i++)
+    {
+        spi_init(&ws2812_strips[i]);
     }
 #endif
     WS2812_LEDConnectInit();
     for (int i = 0; i < WS2812_LED_NUM; i++)
     {
+        ws2812_offset[i] = WS2812_LED[i].buffer - (buffer_type *)WS2812_LED_Buffer[0];
         WS2812_SetPixel(i, 0, 0, 0);
     }
 
-    for (int i = 0; i < WS2812_LED_NUM; i++)
+    // 颜色字节 -> 8个符号的查找表，高位先发
+    for (int v = 0; v < 256; v++)
     {
-        for (int j = 0; j < 24; j++)
+        for (int bit = 0; bit < 8; bit++)
         {
 #if !WS2812_USE_SPI
-            WS2812_LED_Buffer[i][j] = (sizeof(buffer_type) == 1) ? UINT8_MAX : UINT32_MAX;
+            ws2812_lut[v][bit] = (v & (0x80 >> bit)) ? _bit0_pluse_width : _bit1_pluse_width;
 #else
-            WS2812_LED_Buffer[i][j] = 0;
+            ws2812_lut[v][bit] = (v & (0x80 >> bit)) ? _bit1_pluse_width : _bit0_pluse_width;
 #endif
         }
     }
+
+    buffer_type *sym = (buffer_type *)WS2812_LED_Buffer;
+    for (uint32_t i = 0; i < sizeof(WS2812_LED_Buffer) / sizeof(buffer_type); i++)
+    {
+#if !WS2812_USE_SPI
+        sym[i] = (sizeof(buffer_type) == 1) ? UINT8_MAX : UINT32_MAX;
+#else
+        sym[i] = 0;
+#endif
+    }
+    // 两个缓冲区都还没有编码过
+    for (int buf = 0; buf < 2; buf++)
+    {
+        ws2812_dirty_lo[buf] = 0;
+        ws2812_dirty_hi[buf] = WS2812_LED_NUM;
+    }
+    ws2812_front = 0;
+    ws2812_pending = false;
 #if !WS2812_USE_SPI
     HPM_IOC->PAD[_WS2812_DIN_PIN].FUNC_CTL = _WS2812_DIN_FUNC; // 初始化GPIO
     dma_mgr_request_resource(&dma_resource_pool);
     DMA_Init();   // 初始化DMA
     GPTMR_Init(); // 初始化GPTMR
 #else
-
+    dma_is_done = true; // idle, WS2812_IsBusy() is false until the first update
 #endif
 }
 
 void WS2812_Update(bool blocking)
 {
-    for (int index = 0; index < WS2812_LED_NUM; index++)
-    {
-        buffer_type *buf = &WS2812_LED_Buffer[index][0];
-        // GRB
-        for (int i = 0; i < 8; i++)
-        {
-#if !WS2812_USE_SPI
-            if (WS2812_Buffer[index].g & (1 << (7 - i)))
-            {
-                buf[i] = _bit0_pluse_width;
-            }
-            else
-            {
-                buf[i] = _bit1_pluse_width;
-            }
+    uint8_t back;
 
-            if (WS2812_Buffer[index].r & (1 << (7 - i)))
-            {
-                buf[i + 8] = _bit0_pluse_width;
-            }
-            else
-            {
-                buf[i + 8] = _bit1_pluse_width;
-            }
+    ws2812_kick();
+    /* the buffer not on the wire; a frame still pending there is simply re-encoded */
+    back = ws2812_front ^ 1;
+    ws2812_pending = false;
+    ws2812_encode(back);
 
-            if (WS2812_Buffer[index].b & (1 << (7 - i)))
-            {
-                buf[i + 16] = _bit0_pluse_width;
-            }
-            else
-            {
-                buf[i + 16] = _bit1_pluse_width;
-            }
-#else
-            WS2812_RGB_t rgb = WS2812_Buffer[index];
-            buf[i]  = (rgb.g & 0x01) ? _bit1_pluse_width : _bit0_pluse_width;
-            buf[i + 8] = (rgb.r & 0x01) ? _bit1_pluse_width : _bit0_pluse_width;
-            buf[i + 16] = (rgb.b & 0x01) ? _bit1_pluse_width : _bit0_pluse_width;
-            rgb.r >>= 1;
-            rgb.g >>= 1;
-            rgb.b >>= 1;
-#endif
-        }
-//        printf("index: %d, r: %d, g: %d, b: %d\n", index, WS2812_Buffer[index].r, WS2812_Buffer[index].g, WS2812_Buffer[index].b);
-    }
-#if !WS2812_USE_SPI
+    ws2812_pending = true;
     if (blocking == true) {
-        while (!dma_is_done) {
+        while (ws2812_pending) {
+            ws2812_kick();
         };
-    }
-    dma_is_done = false;
-
-    DMA_Init();                                                // 每次都重新配置一次
-    HPM_IOC->PAD[_WS2812_DIN_PIN].FUNC_CTL = _WS2812_DIN_FUNC; // 初始化GPIO
-
-    dma_mgr_enable_channel(&dma_resource_pool);
-    gptmr_start_counter(_WS2812_GPTMR_PTR, WS2812_GPTMR_CHANNLE);
-#else
-    if (hpm_spi_transmit_nonblocking(WS2812_SPI, (buffer_type *)&WS2812_LED_Buffer[0][0], WS2812_LED_NUM * 24) != status_success) {
-        printf("hpm_spi_transmit_receive_nonblocking fail\n");
-        return;
-    }
-    if (blocking == true) {
         while (!dma_is_done) {
         };
-        dma_is_done = false;
+    } else {
+        ws2812_kick();
     }
-#endif
 }
 
 void WS2812_SetPixel(uint32_t index, uint8_t r, uint8_t g, uint8_t b)
@@ -384,14 +473,20 @@ void WS2812_SetPixel(uint32_t index, uint8_t r, uint8_t g, uint8_t b)
     {
         return;
     }
+    if ((WS2812_Buffer[index].r == r) && (WS2812_Buffer[index].g == g) && (WS2812_Buffer[index].b == b))
+    {
+        return;
+    }
     WS2812_Buffer[index].r = r;
     WS2812_Buffer[index].g = g;
     WS2812_Buffer[index].b = b;
+    ws2812_mark_dirty(index);
 }
 
 bool WS2812_IsBusy(void)
 {
-    return !dma_is_done;
+    ws2812_kick();
+    return !dma_is_done || ws2812_pending;
 }
 
 void WS2812_MixPixel(uint32_t index, uint8_t r, uint8_t g, uint8_t b)
@@ -403,6 +498,7 @@ void WS2812_MixPixel(uint32_t index, uint8_t r, uint8_t g, uint8_t b)
     WS2812_Buffer[index].r = (WS2812_Buffer[index].r + r) / 2;
     WS2812_Buffer[index].g = (WS2812_Buffer[index].g + g) / 2;
     WS2812_Buffer[index].b = (WS2812_Buffer[index].b + b) / 2;
+    ws2812_mark_dirty(index);
 }
 
 void WS2812_ReverseMixPixel(uint32_t index, uint8_t r, uint8_t g, uint8_t b)
@@ -441,6 +537,7 @@ void WS2812_ReverseMixPixel(uint32_t index, uint8_t r, uint8_t g, uint8_t b)
     {
         WS2812_Buffer[index].b = 0;
     }
+    ws2812_mark_dirty(index);
 }
 
 void WS2812_Clear_Busy(void)
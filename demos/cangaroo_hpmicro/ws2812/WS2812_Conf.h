@@ -21,6 +21,18 @@
 #define WS2812_SPI         HPM_SPI2
 #define WS2812_SPI_CLCOK   clock_spi2
 #define WS2812_DIN         IOC_PAD_PB13     /* SPI MOSI */
+#define WS2812_DIN_ALT     5
+
+/*
+ * 多路并行输出: 每一路灯带使用一个SPI, 所有灯带同时发送。
+ * WS2812_SetPixel() 的索引依次排在各路灯带上, 第 n 个灯位于第 n / WS2812_STRIP_LED_NUM 路。
+ * 每一路: { SPI, SPI时钟, MOSI引脚, 引脚复用号 }
+ */
+#ifndef WS2812_STRIP_NUM
+#define WS2812_STRIP_NUM   1
+#define WS2812_STRIP_TABLE \
+    { WS2812_SPI, WS2812_SPI_CLCOK, WS2812_DIN, WS2812_DIN_ALT },
+#endif
 #endif
 
 #define WS2812_LED_CONNECT WS2812_CONNECT_LINE
@@ -37,4 +49,15 @@
 #define WS2812_LED_LAYER 5 // 层
 #define WS2812_LED_NUM   (WS2812_LED_COL * WS2812_LED_ROW * WS2812_LED_LAYER)
 #endif
+
+#ifndef WS2812_STRIP_NUM
+#define WS2812_STRIP_NUM 1
+#endif
+#if !WS2812_USE_SPI && (WS2812_STRIP_NUM != 1)
+#error "parallel strips need WS2812_USE_SPI"
+#endif
+#if (WS2812_LED_NUM % WS2812_STRIP_NUM) != 0
+#error "WS2812_LED_NUM must be a multiple of WS2812_STRIP_NUM"
+#endif
+#define WS2812_STRIP_LED_NUM (WS2812_LED_NUM / WS2812_STRIP_NUM)
 #endif // WS2812_WS2812_CONF_TEMPLATE_H
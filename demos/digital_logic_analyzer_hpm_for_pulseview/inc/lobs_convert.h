@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef LOBS_CONVERT_H_
+#define LOBS_CONVERT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * LOBS trace records to SUMP samples. No SDK dependency, tools/lobs_decode.c
+ * builds it on a host to decode trace memory dumps and time the conversion.
+ *
+ * A record in one group 128 bit mode is four words: the header count, then the
+ * d0 / oe / di bit triplets of pins 0 .. 31 packed from bit 0 of the second word.
+ */
+#define LOBS_RECORD_WORDS (4)
+
+typedef struct lobs_convert_config
+{
+    uint32_t decimation;    /* every decimation-th record is a sample */
+    uint8_t group_enable;   /* bit n: probes 8n .. 8n + 7 are uploaded */
+    uint8_t sample_bytes;   /* one per enabled group */
+    bool group_low;         /* the enabled groups are the lowest ones, packing is a mask */
+    uint32_t sample_mask;
+} lobs_convert_config_t;
+
+#define LOBS_CONVERT_CONFIG_DEFAULT { 1, 0x0F, 4, true, UINT32_MAX }
+
+/* move bits 0, 3, 6 .. 30 of x to bits 0 .. 10 */
+static inline uint32_t lobs_convert_every_third(uint32_t x)
+{
+    x &= 0x49249249UL;
+    x = (x | (x >> 2)) & 0xC30C30C3UL;
+    x = (x | (x >> 4)) & 0x0F00F00FUL;
+    x = (x | (x >> 8)) & 0x0F0000FFUL;
+    x = (x | (x >> 16)) & 0x000007FFUL;
+    return x;
+}
+
+/*
+ * The di bit of pin n is bit 3 * n + 2 of the three data words: pins 0 .. 9 in
+ * data[0] from bit 2, pins 10 .. 20 in data[1] from bit 0, pins 21 .. 31 in
+ * data[2] from bit 1.
+ */
+static inline uint32_t lobs_convert_pins(const uint32_t *data)
+{
+    return lobs_convert_every_third(data[0] >> 2)
+         | (lobs_convert_every_third(data[1]) << 10)
+         | (lobs_convert_every_third(data[2] >> 1) << 21);
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief       select the uploaded probe groups
+ * @param[in]   enable : bit n for probes 8n .. 8n + 7, 0 for all
+ */
+void lobs_convert_set_groups(lobs_convert_config_t *config, uint8_t enable);
+
+/**
+ * @brief       convert count samples to packed SUMP samples
+ * @param[in]   records    : first record of the trace region
+ * @param[in]   record_num : records in the region, reading wraps at its end
+ * @param[in]   index      : record of the first sample
+ * @param[out]  out        : count * sample_bytes bytes
+ * @return      bytes written
+ */
+uint32_t lobs_convert_raw(const lobs_convert_config_t *config, const uint32_t *records, uint32_t record_num,
+                          uint32_t index, uint32_t count, uint8_t *out);
+
+/**
+ * @brief       as lobs_convert_raw(), SUMP run length encoded
+ * @details     a sample with its top bit (the rle flag) set holds how many more times the
+ *              value sample that follows it occurred. The flag takes the top uploaded probe,
+ *              which reads as 0. Never longer than lobs_convert_raw().
+ */
+uint32_t lobs_convert_rle(const lobs_convert_config_t *config, const uint32_t *records, uint32_t record_num,
+                          uint32_t index, uint32_t count, uint8_t *out);
+
+/**
+ * @brief       repeat the last sample of a conversion count more times
+ * @param[in]   rle : the conversion is run length encoded, the repeats go in as runs
+ * @param[out]  out : the conversion, len bytes and at least one sample
+ * @return      bytes appended after them
+ */
+uint32_t lobs_convert_hold(const lobs_convert_config_t *config, bool rle, uint8_t *out, uint32_t len, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef PROTO_DECODE_H_
+#define PROTO_DECODE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * UART / SPI / I2C decoders over converted samples (bit n = probe n), so a
+ * bus monitor uploads a few bytes per transferred byte instead of every
+ * sample. No SDK dependency, like lobs_convert.c.
+ *
+ * Each decoder slot is set up with a config word and a parameter:
+ *   config bits 0 .. 3   : PROTO_DECODE_* type, PROTO_DECODE_NONE turns the slot off
+ *   config bits 4 .. 8   : pin a  uart rx, spi sck, i2c scl
+ *   config bits 9 .. 13  : pin b  spi mosi, i2c sda
+ *   config bits 14 .. 18 : pin c  spi miso
+ *   config bits 19 .. 23 : pin d  spi cs, active low
+ *   config bit 24        : spi cs is used
+ *   config bits 25 .. 26 : uart PROTO_PARITY_*, spi mode (cpol << 1 | cpha)
+ *   param                : uart samples per bit, 16.16 fixed point
+ */
+#define PROTO_DECODE_SLOTS      (4)
+
+#define PROTO_DECODE_NONE       (0)
+#define PROTO_DECODE_UART       (1)
+#define PROTO_DECODE_SPI        (2)
+#define PROTO_DECODE_I2C        (3)
+
+#define PROTO_PARITY_NONE       (0)
+#define PROTO_PARITY_EVEN       (1)
+#define PROTO_PARITY_ODD        (2)
+
+#define PROTO_CONFIG_TYPE(c)    ((c) & 0x0F)
+#define PROTO_CONFIG_PIN(c, n)  (((c) >> (4 + (n) * 5)) & 0x1F)
+#define PROTO_CONFIG_CS_USED    (1UL << 24)
+#define PROTO_CONFIG_MODE(c)    (((c) >> 25) & 0x03)
+
+/* event types */
+#define PROTO_EVENT_UART_DATA   (0)   /* data: received byte */
+#define PROTO_EVENT_SPI_DATA    (1)   /* data: mosi byte | miso byte << 8 */
+#define PROTO_EVENT_I2C_START   (2)
+#define PROTO_EVENT_I2C_STOP    (3)
+#define PROTO_EVENT_I2C_ADDRESS (4)   /* data: first byte after a start, address << 1 | read */
+#define PROTO_EVENT_I2C_DATA    (5)
+
+/* event flags */
+#define PROTO_FLAG_FRAMING      (0x01)  /* uart stop bit low */
+#define PROTO_FLAG_PARITY       (0x02)  /* uart parity mismatch */
+#define PROTO_FLAG_NACK         (0x04)  /* i2c byte not acknowledged */
+#define PROTO_FLAG_REPEATED     (0x08)  /* i2c start without a stop before it */
+#define PROTO_FLAG_INCOMPLETE   (0x10)  /* spi cs released mid byte, data holds the bits so far */
+
+typedef struct proto_event
+{
+    uint32_t timestamp;     /* sample index the symbol started at, low 32 bits */
+    uint16_t data;
+    uint8_t info;           /* slot << 4 | event type */
+    uint8_t flags;
+} proto_event_t;
+
+#define PROTO_EVENT_SLOT(info)  ((info) >> 4)
+#define PROTO_EVENT_TYPE(info)  ((info) & 0x0F)
+
+typedef struct proto_decoder
+{
+    /* setup */
+    uint8_t type;
+    uint8_t slot;
+    uint8_t mode;
+    bool cs_used;
+    uint32_t pin[4];        /* probe masks */
+    uint32_t pin_mask;      /* every probe the decoder looks at */
+    uint32_t param;
+
+    /* state */
+    uint32_t prev;
+    uint8_t state;
+    uint8_t bits;
+    uint8_t shift;
+    uint8_t shift_b;
+    uint8_t parity;
+    uint32_t start;         /* timestamp of the current symbol */
+    uint32_t pos;           /* uart: 16.16 samples since the start edge */
+    uint32_t next;          /* uart: 16.16 position of the next bit centre */
+} proto_decoder_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief       set up a decoder slot from its config word and parameter
+ */
+void proto_decode_config(proto_decoder_t *dec, uint8_t slot, uint32_t config, uint32_t param);
+
+/**
+ * @brief       forget any symbol in progress, after samples were lost
+ */
+void proto_decode_reset(proto_decoder_t *dec);
+
+/**
+ * @brief       decode count consecutive samples
+ * @param[in]   timestamp : sample index of samples[0]
+ * @param[out]  events    : room for count events, a decoder emits at most one per sample
+ * @return      events written
+ */
+uint32_t proto_decode_run(proto_decoder_t *dec, const uint32_t *samples, uint32_t count, uint32_t timestamp,
+                          proto_event_t *events);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
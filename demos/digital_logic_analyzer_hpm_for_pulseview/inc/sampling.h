@@ -2,9 +2,178 @@
 #define SAMPLING_H_
 
 #include "hpm_common.h"
+#include "vendor_bulk.h"
+#include "proto_decode.h"
+
+/* trace memory records, tools/sump_replay builds with a smaller one */
+#ifndef TRACE_CNT
+#define TRACE_CNT (20480)
+#endif
+
+/* LOBS clock, it takes one sample every 5, 6 or 7 periods */
+#ifndef SAMPLING_LOBS_FREQ
+#define SAMPLING_LOBS_FREQ (200000000UL)
+#endif
+/* lower rates keep one LOBS sample out of up to this many, and never more than TRACE_CNT */
+#ifndef SAMPLING_DECIMATION_MAX
+#define SAMPLING_DECIMATION_MAX (65536UL)
+#endif
+
+/* LOBS trigger signal group carrying the probe inputs */
+#ifndef SAMPLING_TRIG_SIG_GROUP
+#define SAMPLING_TRIG_SIG_GROUP (5)
+#endif
+/* signal index of probe ch inside SAMPLING_TRIG_SIG_GROUP */
+#ifndef SAMPLING_TRIG_SIG_BIT
+#define SAMPLING_TRIG_SIG_BIT(ch) (ch)
+#endif
+
+/* serial trigger stages of the SUMP protocol, each one takes a LOBS state */
+#define SAMPLING_TRIG_STAGES (4)
+/* signals a LOBS state compares, mask bits above this are ignored */
+#define SAMPLING_TRIG_STAGE_BITS (4)
+
+/* SUMP trigger configuration word */
+#define SAMPLING_TRIG_CFG_DELAY_MASK (0x0000FFFFUL)
+#define SAMPLING_TRIG_CFG_START      (1UL << 27)
+
+/* samples per streamed chunk and chunks queued for the bus, larger on the vendor endpoint */
+#if VENDOR_BULK_ENABLE
+#ifndef SAMPLING_STREAM_CHUNK
+#define SAMPLING_STREAM_CHUNK (4096)
+#endif
+#ifndef SAMPLING_STREAM_BUFFERS
+#define SAMPLING_STREAM_BUFFERS (4)
+#endif
+#else
+#ifndef SAMPLING_STREAM_CHUNK
+#define SAMPLING_STREAM_CHUNK (1024)
+#endif
+#ifndef SAMPLING_STREAM_BUFFERS
+#define SAMPLING_STREAM_BUFFERS (2)
+#endif
+#endif
+#define SAMPLING_STREAM_MAGIC (0x4D525453UL) /* "STRM" */
+#define SAMPLING_EVENT_MAGIC  (0x544E5645UL) /* "EVNT" */
+
+/* decoded events per chunk, they take the room of the samples */
+#define SAMPLING_EVENT_CHUNK (SAMPLING_STREAM_CHUNK * sizeof(uint32_t) / sizeof(proto_event_t))
+
+/* samples handed to the decoders at a time */
+#ifndef SAMPLING_DECODE_BATCH
+#define SAMPLING_DECODE_BATCH (32)
+#endif
+
+/* a chunk holding events goes out after at most this long, 1 / hz seconds */
+#ifndef SAMPLING_DECODE_FLUSH_HZ
+#define SAMPLING_DECODE_FLUSH_HZ (10)
+#endif
+
+/*
+ * Streaming mode upload unit, little endian. The samples of consecutive chunks
+ * are contiguous unless lost is non zero: the trace memory ring was overwritten
+ * before it was read and that many samples are missing in front of this chunk.
+ * LOBS stops when its record counter runs out (2^32 records) and is started again,
+ * the samples missed meanwhile are estimated from the core clock and counted in
+ * lost the same way. A chunk can be cut short by count to put such a gap at its end.
+ *
+ * Timestamps count samples from the start of the stream, lost ones included. time
+ * is the timestamp the chunk starts at, in front of its lost samples, and does not
+ * wrap.
+ *
+ * With a decoder set the magic is SAMPLING_EVENT_MAGIC and samples holds count
+ * proto_event_t instead, only the used part of the chunk is sent. An event carries
+ * the low 32 bits of its timestamp, which wrap after 2^32 samples (107 s at 40 MHz):
+ * time + (int32_t)(timestamp - (uint32_t)time) is the full one. The decoders start
+ * over after a gap. Events are ordered per decoder slot, not across slots.
+ */
+typedef struct sampling_stream_chunk
+{
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t count;
+    uint32_t lost;
+    uint64_t time;
+    uint32_t samples[SAMPLING_STREAM_CHUNK];
+} sampling_stream_chunk_t;
 
 void init_lobs_one_group_config(void);
 void lobs_open(void);
 void lobs_close(void);
 void lobs_loop(void);
-#endif
\ No newline at end of file
+
+/**
+ * @brief       CDC IN transfer finished, starts the next queued capture upload
+ */
+void sampling_tx_done(void);
+
+/**
+ * @brief       a streamed chunk has left, starts the next queued one
+ */
+void sampling_stream_tx_done(void);
+
+/**
+ * @brief       SUMP RESET and RUN, safe from the USB interrupt
+ * @details     the request is carried out by the next lobs_loop(): capture stops and the
+ *              uploads still queued are dropped, a run then arms with the current setup.
+ *              A later request replaces one not served yet.
+ */
+void sampling_request_reset(void);
+void sampling_request_run(void);
+
+/**
+ * @brief       samples uploaded per capture and how many of them follow the trigger
+ * @details     a capture holds at most TRACE_CNT samples, fewer when decimated. The upload
+ *              still has read_count samples, as far as the report buffer holds them at the
+ *              enabled groups: the last sample captured is repeated for the rest.
+ * @param[in]   read_count  : samples per capture, clamped to TRACE_CNT * 4
+ * @param[in]   delay_count : samples after the trigger, clamped to read_count
+ */
+void sampling_set_counts(uint32_t read_count, uint32_t delay_count);
+
+/**
+ * @brief       trigger stage setters, one bit per probe, taken over by the next init_lobs_one_group_config()
+ * @details     a stage with an empty mask is skipped. The stages fire one after the other,
+ *              capture starts after the stage with SAMPLING_TRIG_CFG_START (or the last armed one)
+ *              plus its delay. Without any armed stage capture starts right away.
+ */
+void sampling_set_trigger_mask(uint8_t stage, uint32_t mask);
+void sampling_set_trigger_value(uint8_t stage, uint32_t value);
+void sampling_set_trigger_config(uint8_t stage, uint32_t config);
+
+/**
+ * @brief       closest sample rate to rate_hz, LOBS divider and decimation, from the next init_lobs_one_group_config()
+ * @details     a decimated capture takes decimation trace records per sample, the sample count
+ *              is cut to what the trace memory holds. Rates too low for one sample to fit
+ *              TRACE_CNT records are raised to the lowest one that does.
+ */
+void sampling_set_rate(uint32_t rate_hz);
+uint32_t sampling_get_rate(void);
+
+/**
+ * @brief       probe groups uploaded, bit n for probes 8n .. 8n + 7, 0 for all
+ * @details     one shot captures are uploaded with one byte per enabled group and sample,
+ *              as the SUMP protocol expects with groups disabled
+ */
+void sampling_set_groups(uint8_t enable);
+
+/**
+ * @brief       upload one shot captures SUMP run length encoded, the top uploaded probe becomes the count flag
+ */
+void sampling_set_rle(bool enable);
+
+/**
+ * @brief       select continuous streaming instead of one shot captures, from the next init_lobs_one_group_config()
+ * @details     the trace memory is read as a ring while LOBS keeps recording, converted samples
+ *              go out as sampling_stream_chunk_t. Triggers and counts are not used.
+ */
+void sampling_set_stream(bool enable);
+
+/**
+ * @brief       decoder slot setup (proto_decode.h), taken over by the next init_lobs_one_group_config()
+ * @details     while any slot is set, streaming uploads decoded events instead of samples
+ */
+void sampling_set_decoder(uint8_t slot, uint32_t config);
+void sampling_set_decoder_param(uint8_t slot, uint32_t param);
+
+#endif
@@ -22,9 +22,21 @@
 #define SUMP_CMD_SET_SAMPLE_RATE	0x80
 #define SUMP_CMD_SET_COUNTS			0x81
 #define SUMP_CMD_SET_FLAGS			0x82
+//vendor extension, argument 1 streams continuously (sampling_stream_chunk_t), 0 back to captures
+#define SUMP_CMD_SET_STREAM			0x8F
+//vendor extension, decoder slot n config / parameter (proto_decode.h) with 0x90 / 0x94 + n
+#define SUMP_CMD_SET_DECODER		0x90
+#define SUMP_CMD_SET_DECODER_PARAM	0x94
+#define SUMP_CMD_DECODER_MASK		0xFC
+#define SUMP_CMD_DECODER_SLOT(cmd)	((cmd) & 0x03)
 //basic triggers
 #define SUMP_CMD_SET_BT0_MASK		0xC0
 #define SUMP_CMD_SET_BT0_VALUE		0xC1
+#define SUMP_CMD_SET_BT0_CONFIG		0xC2
+//stage n uses the stage 0 commands + 4 * n
+#define SUMP_CMD_TRIGGER_MASK		0xF0
+#define SUMP_CMD_TRIGGER_OP			0x03
+#define SUMP_CMD_TRIGGER_STAGE(cmd)	(((cmd) >> 2) & 0x03)
 
 #define SUMP_META_END	0x00
 #define SUMP_META_NAME	0x01
@@ -51,8 +63,11 @@
 #define SUMP_FLAG1_GR_16BIT		(SUMP_FLAG1_GR2_DISABLE | SUMP_FLAG1_GR3_DISABLE)
 #define SUMP_FLAG1_GR_32BIT		(0)
 
-#define maxSampleRate 200000000
-#define maxSampleMemory (20*1024)
+//LOBS clock over its shortest sample period (SAMPLING_LOBS_FREQ / 5)
+#define maxSampleRate 40000000
+//report buffer in bytes, hosts divide it by the enabled groups for the samples to ask for.
+//A capture holds at most 20k samples, the upload repeats its last one up to the count asked
+#define maxSampleMemory (20*1024*4)
 
 #define BYTE1(v) ((uint8_t)v & 0xff)         //LSB
 #define BYTE2(v) ((uint8_t)(v >> 8) & 0xff)  //
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef VENDOR_BULK_H_
+#define VENDOR_BULK_H_
+
+#include "hpm_common.h"
+
+/*
+ * Optional vendor class interface next to the CDC ACM one, a single bulk IN
+ * endpoint that carries the streaming chunks (sampling_stream_chunk_t). SUMP
+ * commands and one shot captures stay on the CDC port for PulseView.
+ * tools/stream_reader.c reads it from a host with libusb.
+ */
+#ifndef VENDOR_BULK_ENABLE
+#define VENDOR_BULK_ENABLE (0)
+#endif
+
+/*!< endpoint address and interface number, after the two CDC ACM interfaces */
+#define VENDOR_IN_EP    0x82
+#define VENDOR_INTF_NUM 0x02
+
+#define VENDOR_BULK_DESCRIPTOR_LEN (9 + 7)
+#define VENDOR_BULK_DESCRIPTOR_INIT(bFirstInterface, in_ep, wMaxPacketSize)                   \
+    USB_INTERFACE_DESCRIPTOR_INIT(bFirstInterface, 0x00, 0x01, 0xFF, 0x00, 0x00, 0x00),      \
+    USB_ENDPOINT_DESCRIPTOR_INIT(in_ep, USB_ENDPOINT_TYPE_BULK, wMaxPacketSize, 0x00)
+
+/**
+ * @brief       register the interface and endpoint, before usbd_initialize()
+ * @param[in]   busid   : usb bus
+ * @param[in]   tx_done : called from the USB interrupt when a write has completed and when
+ *                        the endpoint becomes configured, starts the next write
+ */
+void vendor_bulk_init(uint8_t busid, void (*tx_done)(void));
+
+/**
+ * @brief       the host has selected a configuration, from usbd_event_handler()
+ */
+void vendor_bulk_set_configured(bool configured);
+
+/**
+ * @brief       true while a write is on the bus or the device is not configured
+ */
+bool vendor_bulk_is_busy(void);
+
+/**
+ * @brief       start sending len bytes, the buffer must stay untouched until tx_done
+ * @return      false if busy
+ */
+bool vendor_bulk_write(const uint8_t *data, uint32_t len);
+
+#endif
@@ -9,22 +9,36 @@
 #include "usbd_cdc_acm.h"
 #include "cdc_acm.h"
 #include "sump.h"
+#include "sampling.h"
+#include "vendor_bulk.h"
 
 /*!< config descriptor size */
+#if VENDOR_BULK_ENABLE
+#define USB_CONFIG_SIZE (9 + CDC_ACM_DESCRIPTOR_LEN + VENDOR_BULK_DESCRIPTOR_LEN)
+#define USB_INTF_NUM    0x03
+#else
 #define USB_CONFIG_SIZE (9 + CDC_ACM_DESCRIPTOR_LEN)
+#define USB_INTF_NUM    0x02
+#endif
 
 static const uint8_t device_descriptor[] = {
     USB_DEVICE_DESCRIPTOR_INIT(USB_2_0, 0xEF, 0x02, 0x01, USBD_VID, USBD_PID, 0x0100, 0x01)
 };
 
 static const uint8_t config_descriptor_hs[] = {
-    USB_CONFIG_DESCRIPTOR_INIT(USB_CONFIG_SIZE, 0x02, 0x01, USB_CONFIG_BUS_POWERED, USBD_MAX_POWER),
+    USB_CONFIG_DESCRIPTOR_INIT(USB_CONFIG_SIZE, USB_INTF_NUM, 0x01, USB_CONFIG_BUS_POWERED, USBD_MAX_POWER),
     CDC_ACM_DESCRIPTOR_INIT(0x00, CDC_INT_EP, CDC_OUT_EP, CDC_IN_EP, USB_BULK_EP_MPS_HS, 0x02),
+#if VENDOR_BULK_ENABLE
+    VENDOR_BULK_DESCRIPTOR_INIT(VENDOR_INTF_NUM, VENDOR_IN_EP, USB_BULK_EP_MPS_HS),
+#endif
 };
 
 static const uint8_t config_descriptor_fs[] = {
-    USB_CONFIG_DESCRIPTOR_INIT(USB_CONFIG_SIZE, 0x02, 0x01, USB_CONFIG_BUS_POWERED, USBD_MAX_POWER),
+    USB_CONFIG_DESCRIPTOR_INIT(USB_CONFIG_SIZE, USB_INTF_NUM, 0x01, USB_CONFIG_BUS_POWERED, USBD_MAX_POWER),
     CDC_ACM_DESCRIPTOR_INIT(0x00, CDC_INT_EP, CDC_OUT_EP, CDC_IN_EP, USB_BULK_EP_MPS_FS, 0x02),
+#if VENDOR_BULK_ENABLE
+    VENDOR_BULK_DESCRIPTOR_INIT(VENDOR_INTF_NUM, VENDOR_IN_EP, USB_BULK_EP_MPS_FS),
+#endif
 };
 
 static const uint8_t device_quality_descriptor[] = {
@@ -32,13 +46,19 @@ static const uint8_t device_quality_descriptor[] = {
 };
 
 static const uint8_t other_speed_config_descriptor_hs[] = {
-    USB_OTHER_SPEED_CONFIG_DESCRIPTOR_INIT(USB_CONFIG_SIZE, 0x02, 0x01, USB_CONFIG_BUS_POWERED, USBD_MAX_POWER),
+    USB_OTHER_SPEED_CONFIG_DESCRIPTOR_INIT(USB_CONFIG_SIZE, USB_INTF_NUM, 0x01, USB_CONFIG_BUS_POWERED, USBD_MAX_POWER),
     CDC_ACM_DESCRIPTOR_INIT(0x00, CDC_INT_EP, CDC_OUT_EP, CDC_IN_EP, USB_BULK_EP_MPS_FS, 0x02),
+#if VENDOR_BULK_ENABLE
+    VENDOR_BULK_DESCRIPTOR_INIT(VENDOR_INTF_NUM, VENDOR_IN_EP, USB_BULK_EP_MPS_FS),
+#endif
 };
 
 static const uint8_t other_speed_config_descriptor_fs[] = {
-    USB_OTHER_SPEED_CONFIG_DESCRIPTOR_INIT(USB_CONFIG_SIZE, 0x02, 0x01, USB_CONFIG_BUS_POWERED, USBD_MAX_POWER),
+    USB_OTHER_SPEED_CONFIG_DESCRIPTOR_INIT(USB_CONFIG_SIZE, USB_INTF_NUM, 0x01, USB_CONFIG_BUS_POWERED, USBD_MAX_POWER),
     CDC_ACM_DESCRIPTOR_INIT(0x00, CDC_INT_EP, CDC_OUT_EP, CDC_IN_EP, USB_BULK_EP_MPS_HS, 0x02),
+#if VENDOR_BULK_ENABLE
+    VENDOR_BULK_DESCRIPTOR_INIT(VENDOR_INTF_NUM, VENDOR_IN_EP, USB_BULK_EP_MPS_HS),
+#endif
 };
 
 static const char *string_descriptors[] = {
@@ -111,10 +131,16 @@ static void usbd_event_handler(uint8_t busid, uint8_t event)
 {
     switch (event) {
     case USBD_EVENT_RESET:
+#if VENDOR_BULK_ENABLE
+        vendor_bulk_set_configured(false);
+#endif
         break;
     case USBD_EVENT_CONNECTED:
         break;
     case USBD_EVENT_DISCONNECTED:
+#if VENDOR_BULK_ENABLE
+        vendor_bulk_set_configured(false);
+#endif
         break;
     case USBD_EVENT_RESUME:
         break;
@@ -123,6 +149,9 @@ static void usbd_event_handler(uint8_t busid, uint8_t event)
     case USBD_EVENT_CONFIGURED:
         /* setup first out ep read transfer */
         usbd_ep_start_read(busid, CDC_OUT_EP, &read_buffer[0], usbd_get_ep_mps(busid, CDC_OUT_EP));
+#if VENDOR_BULK_ENABLE
+        vendor_bulk_set_configured(true);
+#endif
         break;
     case USBD_EVENT_SET_REMOTE_WAKEUP:
         break;
@@ -151,6 +180,7 @@ void usbd_cdc_acm_bulk_in(uint8_t busid, uint8_t ep, uint32_t nbytes)
         usbd_ep_start_write(busid, ep, NULL, 0);
     } else {
         ep_tx_busy_flag = false;
+        sampling_tx_done();
     }
 }
 
@@ -177,6 +207,9 @@ void cdc_acm_init(uint8_t busid, uint32_t reg_base)
     usbd_add_interface(busid, usbd_cdc_acm_init_intf(busid, &intf1));
     usbd_add_endpoint(busid, &cdc_out_ep);
     usbd_add_endpoint(busid, &cdc_in_ep);
+#if VENDOR_BULK_ENABLE
+    vendor_bulk_init(busid, sampling_stream_tx_done);
+#endif
     usbd_initialize(busid, reg_base, usbd_event_handler);
 }
 
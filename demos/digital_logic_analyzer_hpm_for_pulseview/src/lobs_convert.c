@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "lobs_convert.h"
+
+void lobs_convert_set_groups(lobs_convert_config_t *config, uint8_t enable)
+{
+    enable &= 0x0F;
+    if (enable == 0) {
+        enable = 0x0F;
+    }
+    config->group_enable = enable;
+    config->sample_bytes = 0;
+    for (uint8_t g = 0; g < 4; g++) {
+        if (enable & (1U << g)) {
+            config->sample_bytes++;
+        }
+    }
+    config->group_low = (enable == ((1U << config->sample_bytes) - 1U));
+    config->sample_mask = (config->sample_bytes == 4) ? UINT32_MAX : ((1UL << (config->sample_bytes * 8)) - 1UL);
+}
+
+/* keep the bytes of the enabled groups, lowest group first */
+static inline uint32_t pack_groups(const lobs_convert_config_t *config, uint32_t value)
+{
+    uint32_t packed = 0;
+    uint8_t shift = 0;
+
+    if (config->group_low) {
+        return value & config->sample_mask;
+    }
+    for (uint8_t g = 0; g < 4; g++) {
+        if (config->group_enable & (1U << g)) {
+            packed |= ((value >> (g * 8)) & 0xFF) << shift;
+            shift += 8;
+        }
+    }
+    return packed;
+}
+
+static inline uint8_t *put_sample(const lobs_convert_config_t *config, uint8_t *out, uint32_t value)
+{
+    switch (config->sample_bytes) {
+    case 1:
+        *out = (uint8_t)value;
+        break;
+    case 2:
+        *(uint16_t *)out = (uint16_t)value;
+        break;
+    case 3:
+        out[0] = (uint8_t)value;
+        out[1] = (uint8_t)(value >> 8);
+        out[2] = (uint8_t)(value >> 16);
+        break;
+    default:
+        *(uint32_t *)out = value;
+        break;
+    }
+    return out + config->sample_bytes;
+}
+
+uint32_t lobs_convert_raw(const lobs_convert_config_t *config, const uint32_t *records, uint32_t record_num,
+                          uint32_t index, uint32_t count, uint8_t *out)
+{
+    uint8_t *start = out;
+
+    for (uint32_t i = 0; i < count; i++) {
+        out = put_sample(config, out, pack_groups(config, lobs_convert_pins(&records[index * LOBS_RECORD_WORDS + 1])));
+        index += config->decimation;
+        if (index >= record_num) {
+            index -= record_num;
+        }
+    }
+    return out - start;
+}
+
+uint32_t lobs_convert_rle(const lobs_convert_config_t *config, const uint32_t *records, uint32_t record_num,
+                          uint32_t index, uint32_t count, uint8_t *out)
+{
+    uint32_t rle_flag = 1UL << (config->sample_bytes * 8 - 1);
+    uint8_t *start = out;
+    uint32_t value;
+    uint32_t prev = 0;
+    uint32_t run = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        value = pack_groups(config, lobs_convert_pins(&records[index * LOBS_RECORD_WORDS + 1])) & ~rle_flag;
+        index += config->decimation;
+        if (index >= record_num) {
+            index -= record_num;
+        }
+        if ((run != 0) && (value == prev) && (run < rle_flag)) {
+            run++;
+            continue;
+        }
+        if (run > 1) {
+            out = put_sample(config, out, rle_flag | (run - 1));
+        }
+        if (run != 0) {
+            out = put_sample(config, out, prev);
+        }
+        prev = value;
+        run = 1;
+    }
+    if (run > 1) {
+        out = put_sample(config, out, rle_flag | (run - 1));
+    }
+    if (run != 0) {
+        out = put_sample(config, out, prev);
+    }
+    return out - start;
+}
+
+uint32_t lobs_convert_hold(const lobs_convert_config_t *config, bool rle, uint8_t *out, uint32_t len, uint32_t count)
+{
+    uint32_t rle_flag = 1UL << (config->sample_bytes * 8 - 1);
+    const uint8_t *last = out + len - config->sample_bytes;
+    uint8_t *start = out + len;
+    uint32_t value = 0;
+    uint32_t run;
+
+    for (uint8_t i = 0; i < config->sample_bytes; i++) {
+        value |= (uint32_t)last[i] << (i * 8);
+    }
+    out = start;
+    while (count != 0) {
+        run = 1;
+        if (rle) {
+            run = (count < rle_flag) ? count : rle_flag;
+        }
+        if (run > 1) {
+            out = put_sample(config, out, rle_flag | (run - 1));
+        }
+        out = put_sample(config, out, value);
+        count -= run;
+    }
+    return out - start;
+}
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "proto_decode.h"
+
+enum {
+    UART_IDLE = 0,
+    UART_START,
+    UART_DATA,
+    UART_PARITY,
+    UART_STOP,
+};
+
+enum {
+    I2C_IDLE = 0,
+    I2C_ADDRESS,
+    I2C_DATA,
+};
+
+void proto_decode_config(proto_decoder_t *dec, uint8_t slot, uint32_t config, uint32_t param)
+{
+    dec->type = PROTO_CONFIG_TYPE(config);
+    dec->slot = slot;
+    dec->mode = PROTO_CONFIG_MODE(config);
+    dec->cs_used = (config & PROTO_CONFIG_CS_USED) != 0;
+    dec->param = param;
+    dec->pin_mask = 0;
+    for (uint8_t n = 0; n < 4; n++) {
+        dec->pin[n] = 1UL << PROTO_CONFIG_PIN(config, n);
+    }
+    switch (dec->type) {
+    case PROTO_DECODE_UART:
+        dec->pin_mask = dec->pin[0];
+        if (param < (1UL << 16)) {
+            /* less than a sample per bit can not be decoded */
+            dec->type = PROTO_DECODE_NONE;
+        }
+        break;
+    case PROTO_DECODE_SPI:
+        dec->pin_mask = dec->pin[0] | dec->pin[1] | dec->pin[2] | (dec->cs_used ? dec->pin[3] : 0);
+        break;
+    case PROTO_DECODE_I2C:
+        dec->pin_mask = dec->pin[0] | dec->pin[1];
+        break;
+    default:
+        dec->type = PROTO_DECODE_NONE;
+        break;
+    }
+    proto_decode_reset(dec);
+}
+
+void proto_decode_reset(proto_decoder_t *dec)
+{
+    /* idle levels, a bus that starts low shows up as an edge once it is released */
+    dec->prev = UINT32_MAX;
+    if ((dec->type == PROTO_DECODE_SPI) && ((dec->mode & 0x2) == 0)) {
+        dec->prev &= ~dec->pin[0];
+    }
+    dec->state = 0;
+    dec->bits = 0;
+    dec->shift = 0;
+    dec->shift_b = 0;
+}
+
+static inline proto_event_t *put_event(const proto_decoder_t *dec, proto_event_t *event, uint8_t type,
+                                       uint32_t timestamp, uint16_t data, uint8_t flags)
+{
+    event->timestamp = timestamp;
+    event->data = data;
+    event->info = (uint8_t)((dec->slot << 4) | type);
+    event->flags = flags;
+    return event + 1;
+}
+
+/* 8N1 / 8E1 / 8O1, LSB first, every bit read at its centre */
+static uint32_t decode_uart(proto_decoder_t *dec, const uint32_t *samples, uint32_t count, uint32_t timestamp,
+                            proto_event_t *events)
+{
+    proto_event_t *event = events;
+    uint32_t level;
+    uint8_t flags;
+
+    for (uint32_t i = 0; i < count; i++) {
+        level = samples[i] & dec->pin[0];
+        if (dec->state == UART_IDLE) {
+            if ((level == 0) && (dec->prev != 0)) {
+                dec->state = UART_START;
+                dec->start = timestamp + i;
+                dec->pos = 0;
+                dec->next = dec->param / 2;
+            }
+            dec->prev = level;
+            continue;
+        }
+        dec->prev = level;
+        dec->pos += 1UL << 16;
+        if (dec->pos < dec->next) {
+            continue;
+        }
+        dec->next += dec->param;
+        switch (dec->state) {
+        case UART_START:
+            if (level != 0) {
+                /* glitch, not a start bit */
+                dec->state = UART_IDLE;
+                break;
+            }
+            dec->state = UART_DATA;
+            dec->bits = 0;
+            dec->shift = 0;
+            dec->parity = 0;
+            break;
+        case UART_DATA:
+            if (level != 0) {
+                dec->shift |= (uint8_t)(1U << dec->bits);
+                dec->parity ^= 1;
+            }
+            if (++dec->bits == 8) {
+                dec->state = (dec->mode == PROTO_PARITY_NONE) ? UART_STOP : UART_PARITY;
+            }
+            break;
+        case UART_PARITY:
+            dec->parity ^= (level != 0);
+            dec->state = UART_STOP;
+            break;
+        default:
+            flags = (level == 0) ? PROTO_FLAG_FRAMING : 0;
+            if (((dec->mode == PROTO_PARITY_EVEN) && (dec->parity != 0)) ||
+                ((dec->mode == PROTO_PARITY_ODD) && (dec->parity == 0))) {
+                flags |= PROTO_FLAG_PARITY;
+            }
+            event = put_event(dec, event, PROTO_EVENT_UART_DATA, dec->start, dec->shift, flags);
+            /* the start edge of the next byte may come right after the stop bit centre */
+            dec->state = UART_IDLE;
+            break;
+        }
+    }
+    return event - events;
+}
+
+/* 8 bit words, MSB first, sampled on the edge the mode selects */
+static uint32_t decode_spi(proto_decoder_t *dec, const uint32_t *samples, uint32_t count, uint32_t timestamp,
+                           proto_event_t *events)
+{
+    proto_event_t *event = events;
+    bool sample_rising = ((dec->mode >> 1) == (dec->mode & 0x1));
+    uint32_t sample;
+    uint32_t edge;
+
+    for (uint32_t i = 0; i < count; i++) {
+        sample = samples[i];
+        if (((sample ^ dec->prev) & dec->pin_mask) == 0) {
+            continue;
+        }
+        if (dec->cs_used && (sample & dec->pin[3])) {
+            if (((dec->prev & dec->pin[3]) == 0) && (dec->bits != 0)) {
+                event = put_event(dec, event, PROTO_EVENT_SPI_DATA, dec->start,
+                                  (uint16_t)(dec->shift | (dec->shift_b << 8)), PROTO_FLAG_INCOMPLETE);
+            }
+            dec->bits = 0;
+            dec->prev = sample;
+            continue;
+        }
+        edge = (sample ^ dec->prev) & dec->pin[0];
+        if (edge && (((sample & dec->pin[0]) != 0) == sample_rising)) {
+            if (dec->bits == 0) {
+                dec->start = timestamp + i;
+                dec->shift = 0;
+                dec->shift_b = 0;
+            }
+            dec->shift = (uint8_t)((dec->shift << 1) | ((sample & dec->pin[1]) != 0));
+            dec->shift_b = (uint8_t)((dec->shift_b << 1) | ((sample & dec->pin[2]) != 0));
+            if (++dec->bits == 8) {
+                event = put_event(dec, event, PROTO_EVENT_SPI_DATA, dec->start,
+                                  (uint16_t)(dec->shift | (dec->shift_b << 8)), 0);
+                dec->bits = 0;
+            }
+        }
+        dec->prev = sample;
+    }
+    return event - events;
+}
+
+/* start / stop from sda edges while scl is high, data bits and the ack on scl rising edges */
+static uint32_t decode_i2c(proto_decoder_t *dec, const uint32_t *samples, uint32_t count, uint32_t timestamp,
+                           proto_event_t *events)
+{
+    proto_event_t *event = events;
+    uint32_t sample;
+    uint32_t sda;
+
+    for (uint32_t i = 0; i < count; i++) {
+        sample = samples[i];
+        if (((sample ^ dec->prev) & dec->pin_mask) == 0) {
+            continue;
+        }
+        sda = sample & dec->pin[1];
+        if ((sample & dec->prev & dec->pin[0]) && ((sample ^ dec->prev) & dec->pin[1])) {
+            if (sda == 0) {
+                event = put_event(dec, event, PROTO_EVENT_I2C_START, timestamp + i, 0,
+                                  (dec->state != I2C_IDLE) ? PROTO_FLAG_REPEATED : 0);
+                dec->state = I2C_ADDRESS;
+            } else {
+                event = put_event(dec, event, PROTO_EVENT_I2C_STOP, timestamp + i, 0, 0);
+                dec->state = I2C_IDLE;
+            }
+            dec->bits = 0;
+        } else if ((dec->state != I2C_IDLE) && (sample & ~dec->prev & dec->pin[0])) {
+            if (dec->bits < 8) {
+                if (dec->bits == 0) {
+                    dec->start = timestamp + i;
+                }
+                dec->shift = (uint8_t)((dec->shift << 1) | (sda != 0));
+                dec->bits++;
+            } else {
+                event = put_event(dec, event, (dec->state == I2C_ADDRESS) ? PROTO_EVENT_I2C_ADDRESS : PROTO_EVENT_I2C_DATA,
+                                  dec->start, dec->shift, sda ? PROTO_FLAG_NACK : 0);
+                dec->state = I2C_DATA;
+                dec->bits = 0;
+            }
+        }
+        dec->prev = sample;
+    }
+    return event - events;
+}
+
+uint32_t proto_decode_run(proto_decoder_t *dec, const uint32_t *samples, uint32_t count, uint32_t timestamp,
+                          proto_event_t *events)
+{
+    switch (dec->type) {
+    case PROTO_DECODE_UART:
+        return decode_uart(dec, samples, count, timestamp, events);
+    case PROTO_DECODE_SPI:
+        return decode_spi(dec, samples, count, timestamp, events);
+    case PROTO_DECODE_I2C:
+        return decode_i2c(dec, samples, count, timestamp, events);
+    default:
+        return 0;
+    }
+}
@@ -7,15 +7,23 @@
 
 #include "board.h"
 #include "hpm_lobs_drv.h"
+#include "hpm_interrupt.h"
+#include "hpm_clock_drv.h"
+#include "hpm_csr_drv.h"
 #include "cdc_acm.h"
 #include "sampling.h"
+#include "lobs_convert.h"
+#include "proto_decode.h"
+#include "vendor_bulk.h"
 #include "usb_config.h"
 
-#define TRACE_CNT (20480)
 #define TRIG_POINT 64
 
 uint32_t lobs_buffer[TRACE_CNT * 4];
-uint32_t report_buffer[TRACE_CNT];
+uint32_t report_buffer[2][TRACE_CNT];
+
+/* samples a report holds at one byte each, the most a host may ask for */
+#define READ_SAMPLES_MAX (sizeof(report_buffer[0]))
 
 extern int usbd_ep_start_write(uint8_t busid, const uint8_t ep, const uint8_t *data, uint32_t data_len);
 
@@ -161,68 +169,583 @@ typedef struct lobs_type
     } buffer;
 } lobs_type_t;
 
-static void pins_convert_buffer(pins_type_t pins, uint32_t *buffer)
-{
-    (*buffer) = pins.p31_di << 31;
-    (*buffer) |= pins.p30_di << 30;
-    (*buffer) |= pins.p29_di << 29;
-    (*buffer) |= pins.p28_di << 28;
-    (*buffer) |= pins.p27_di << 27;
-    (*buffer) |= pins.p26_di << 26;
-    (*buffer) |= pins.p25_di << 25;
-    (*buffer) |= pins.p24_di << 24;
-    (*buffer) |= pins.p23_di << 23;
-    (*buffer) |= pins.p22_di << 22;
-    (*buffer) |= pins.p21_di << 21;
-    (*buffer) |= pins.p20_di << 20;
-    (*buffer) |= pins.p19_di << 19;
-    (*buffer) |= pins.p18_di << 18;
-    (*buffer) |= pins.p17_di << 17;
-    (*buffer) |= pins.p16_di << 16;
-    (*buffer) |= pins.p15_di << 15;
-    (*buffer) |= pins.p14_di << 14;
-    (*buffer) |= pins.p13_di << 13;
-    (*buffer) |= pins.p12_di << 12;
-    (*buffer) |= pins.p11_di << 11;
-    (*buffer) |= pins.p10_di << 10;
-    (*buffer) |= pins.p9_di << 9;
-    (*buffer) |= pins.p8_di << 8;
-    (*buffer) |= pins.p7_di << 7;
-    (*buffer) |= pins.p6_di << 6;
-    (*buffer) |= pins.p5_di << 5;
-    (*buffer) |= pins.p4_di << 4;
-    (*buffer) |= pins.p3_di << 3;
-    (*buffer) |= pins.p2_di << 2;
-    (*buffer) |= pins.p1_di << 1;
-    (*buffer) |= pins.p0_di << 0;
+typedef struct trigger_stage
+{
+    uint32_t mask;
+    uint32_t value;
+    uint32_t config;
+} trigger_stage_t;
+
+static trigger_stage_t trigger_stages[SAMPLING_TRIG_STAGES];
+static uint32_t read_samples = TRACE_CNT;   /* uploaded per capture, the ones past capture_samples repeat the last */
+static uint32_t delay_samples = TRACE_CNT;
+static uint32_t capture_samples = TRACE_CNT;  /* read_samples that fit the trace memory at the current decimation */
+static uint32_t capture_delay = TRACE_CNT;
+
+/*
+ * Trace memory region LOBS records into: all of it, or, when a capture fits, one half
+ * while the previous capture is converted out of the other one.
+ */
+static uint32_t trace_first;
+static uint32_t trace_records = TRACE_CNT;
+static uint8_t trace_half;
+
+/*
+ * Converted captures queue for upload in the order they were taken. The CDC IN completion
+ * frees a report and starts the next ready one, the main loop only converts.
+ */
+enum {
+    REPORT_FREE = 0,
+    REPORT_READY,
+    REPORT_SENDING,
+};
+static volatile uint8_t report_state[2];
+static uint32_t report_len[2];
+static uint8_t report_fill;     /* next capture is converted into this report */
+static uint8_t report_send;     /* oldest report not yet uploaded */
+
+/*
+ * RESET and RUN arrive in the USB interrupt while lobs_loop() may be converting or streaming,
+ * they are only posted there and carried out by the main loop between two passes.
+ */
+enum {
+    REQUEST_NONE = 0,
+    REQUEST_RESET,
+    REQUEST_RUN,
+};
+static volatile uint8_t sampling_request;
+
+/* rate: LOBS takes a sample every lobs_div clocks, every decimation-th one is kept */
+static uint32_t sample_rate_hz = SAMPLING_LOBS_FREQ / 7;
+static lobs_sample_rate_t lobs_rate = lobs_sample_1_per_7;
+
+/* decimation and the packing of the enabled 8 probe groups */
+static lobs_convert_config_t convert_config = LOBS_CONVERT_CONFIG_DEFAULT;
+
+static uint8_t lobs_state_num = 1;
+static bool rle_enable;
+
+static const struct {
+    uint8_t div;
+    lobs_sample_rate_t rate;
+} lobs_rates[] = {
+    { 5, lobs_sample_1_per_5 },
+    { 6, lobs_sample_1_per_6 },
+    { 7, lobs_sample_1_per_7 },
+};
+
+/* streaming mode, a header that is still STREAM_EMPTY has not been written since arming */
+#define STREAM_EMPTY (0xFFFFFFFFUL)
+
+/*
+ * Full chunks queue from stream_head on and are sent back to back, the completion of one
+ * starts the next from the USB interrupt. stream_fill is converted into while it is not queued.
+ */
+static sampling_stream_chunk_t stream_chunks[SAMPLING_STREAM_BUFFERS];
+static bool stream_mode;
+static bool stream_synced;
+static uint8_t stream_fill;
+static bool stream_fill_open;           /* stream_fill is no longer queued and has been cleared */
+static uint8_t stream_head;
+static volatile uint8_t stream_queued;  /* full chunks, the one on the bus included */
+static volatile bool stream_sending;
+static uint32_t stream_index;     /* next trace memory record */
+static uint32_t stream_expected;  /* header count of that record */
+static uint32_t stream_sequence;
+static uint32_t stream_lost;      /* total, for the console */
+static uint32_t stream_gap;       /* samples missed by a rearm, counted in front of the next ones taken */
+static uint32_t stream_len[SAMPLING_STREAM_BUFFERS];
+
+/* decoders, setup from the host and the slots in use from the last init */
+static struct {
+    uint32_t config;
+    uint32_t param;
+} decoder_setup[PROTO_DECODE_SLOTS];
+static proto_decoder_t decoders[PROTO_DECODE_SLOTS];
+static uint8_t decoder_num;
+static uint32_t decode_samples[SAMPLING_DECODE_BATCH];
+static uint64_t stream_time;        /* timestamp of the next sample */
+static uint64_t stream_chunk_time;  /* stream_time when the filled chunk was started */
+static uint32_t stream_flush_samples;
+static uint64_t stream_open_cycle;  /* core cycle LOBS was last started at */
+static uint64_t stream_open_time;   /* stream_time of its first record */
+
+static const uint32_t lobs_next_states[] = {
+    lobs_next_state_0, lobs_next_state_1, lobs_next_state_2, lobs_next_state_3, lobs_next_state_4,
+};
+
+void sampling_set_counts(uint32_t read_count, uint32_t delay_count)
+{
+    if ((read_count == 0) || (read_count > READ_SAMPLES_MAX)) {
+        read_count = READ_SAMPLES_MAX;
+    }
+    if (delay_count > read_count) {
+        delay_count = read_count;
+    }
+    read_samples = read_count;
+    delay_samples = delay_count;
+}
+
+void sampling_set_trigger_mask(uint8_t stage, uint32_t mask)
+{
+    if (stage < SAMPLING_TRIG_STAGES) {
+        trigger_stages[stage].mask = mask;
+    }
+}
+
+void sampling_set_trigger_value(uint8_t stage, uint32_t value)
+{
+    if (stage < SAMPLING_TRIG_STAGES) {
+        trigger_stages[stage].value = value;
+    }
+}
+
+void sampling_set_trigger_config(uint8_t stage, uint32_t config)
+{
+    if (stage < SAMPLING_TRIG_STAGES) {
+        trigger_stages[stage].config = config;
+    }
+}
+
+void sampling_set_rate(uint32_t rate_hz)
+{
+    uint32_t best_err = UINT32_MAX;
+
+    if (rate_hz == 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < ARRAY_SIZE(lobs_rates); i++) {
+        uint32_t lobs_hz = SAMPLING_LOBS_FREQ / lobs_rates[i].div;
+        uint32_t dec = (lobs_hz + rate_hz / 2) / rate_hz;
+        uint32_t err;
+
+        if (dec == 0) {
+            dec = 1;
+        }
+        if (dec > SAMPLING_DECIMATION_MAX) {
+            dec = SAMPLING_DECIMATION_MAX;
+        }
+        /* at least one sample has to fit the trace memory */
+        if (dec > TRACE_CNT) {
+            dec = TRACE_CNT;
+        }
+        err = lobs_hz / dec;
+        err = (err > rate_hz) ? (err - rate_hz) : (rate_hz - err);
+        if (err < best_err) {
+            best_err = err;
+            lobs_rate = lobs_rates[i].rate;
+            convert_config.decimation = dec;
+            sample_rate_hz = lobs_hz / dec;
+        }
+    }
+}
+
+uint32_t sampling_get_rate(void)
+{
+    return sample_rate_hz;
+}
+
+void sampling_set_groups(uint8_t enable)
+{
+    lobs_convert_set_groups(&convert_config, enable);
+}
+
+void sampling_set_rle(bool enable)
+{
+    rle_enable = enable;
+}
+
+void sampling_set_stream(bool enable)
+{
+    stream_mode = enable;
+}
+
+void sampling_set_decoder(uint8_t slot, uint32_t config)
+{
+    if (slot < PROTO_DECODE_SLOTS) {
+        decoder_setup[slot].config = config;
+    }
+}
+
+void sampling_set_decoder_param(uint8_t slot, uint32_t param)
+{
+    if (slot < PROTO_DECODE_SLOTS) {
+        decoder_setup[slot].param = param;
+    }
+}
+
+static void decoders_init(void)
+{
+    decoder_num = 0;
+    for (uint8_t slot = 0; slot < PROTO_DECODE_SLOTS; slot++) {
+        proto_decode_config(&decoders[decoder_num], slot, decoder_setup[slot].config, decoder_setup[slot].param);
+        if (decoders[decoder_num].type != PROTO_DECODE_NONE) {
+            decoder_num++;
+        }
+    }
+    stream_flush_samples = sample_rate_hz / SAMPLING_DECODE_FLUSH_HZ;
+}
+
+static bool stream_write(const uint8_t *data, uint32_t len)
+{
+#if VENDOR_BULK_ENABLE
+    return vendor_bulk_write(data, len);
+#else
+    if (get_usb_cdc_tx_busy()) {
+        return false;
+    }
+    set_usb_cdc_tx_busy(true);
+    usbd_ep_start_write(0, CDC_IN_EP, data, len);
+    return true;
+#endif
+}
+
+/* USB interrupt context or interrupts masked */
+static void stream_kick(void)
+{
+    if (stream_sending || (stream_queued == 0)) {
+        return;
+    }
+    if (stream_write((uint8_t *)&stream_chunks[stream_head], stream_len[stream_head])) {
+        stream_sending = true;
+    }
+}
+
+void sampling_stream_tx_done(void)
+{
+    if (stream_sending) {
+        stream_sending = false;
+        stream_head = (stream_head + 1) % SAMPLING_STREAM_BUFFERS;
+        stream_queued--;
+    }
+    stream_kick();
+}
+
+/* LOBS starts over at the first record, the reader syncs on the first header it writes */
+static void stream_clear_trace(void)
+{
+    for (uint32_t i = 0; i < TRACE_CNT; i++) {
+        ((lobs_type_t *)&lobs_buffer[i * 4])->header_count = STREAM_EMPTY;
+    }
+    stream_synced = false;
+    stream_index = 0;
+}
+
+static void stream_reset(void)
+{
+    uint32_t level;
+
+    stream_clear_trace();
+    stream_sequence = 0;
+    stream_lost = 0;
+    stream_gap = 0;
+    stream_time = 0;
+    stream_chunk_time = 0;
+    stream_open_time = 0;
+    for (uint8_t i = 0; i < decoder_num; i++) {
+        proto_decode_reset(&decoders[i]);
+    }
+
+    level = disable_global_irq(CSR_MSTATUS_MIE_MASK);
+    /* the chunk on the bus is still handed back by sampling_stream_tx_done() */
+    if (stream_sending) {
+        stream_queued = 1;
+        stream_fill = (stream_head + 1) % SAMPLING_STREAM_BUFFERS;
+    } else {
+        stream_queued = 0;
+        stream_head = 0;
+        stream_fill = 0;
+    }
+    restore_global_irq(level);
+    stream_chunks[stream_fill].count = 0;
+    stream_chunks[stream_fill].lost = 0;
+    stream_fill_open = true;
+}
+
+/*
+ * The LOBS record counter has run out and the trace stopped. Restart it without touching the
+ * stream: the sequence and timestamps run on, and the samples it missed go into the lost count
+ * of the next chunk. Those are the records still unread plus the time LOBS stood still, taken
+ * together from the core clock as the samples due since the last start less the ones accounted.
+ */
+static void stream_rearm(void)
+{
+    uint64_t due;
+    uint64_t accounted;
+
+    lobs_close();
+    stream_clear_trace();
+    due = (hpm_csr_get_core_cycle() - stream_open_cycle) * sample_rate_hz / hpm_core_clock;
+    accounted = stream_time + stream_gap - stream_open_time;
+    if (due > accounted) {
+        stream_gap += (uint32_t)(due - accounted);
+    }
+    stream_open_time = stream_time + stream_gap;
+    lobs_open();
+}
+
+/*
+ * Convert up to max of the records LOBS has written since the last call. The header count goes
+ * up by one per record, a record ahead of the expected count means the writer has lapped the
+ * reader and the difference is lost. A record behind it has not been written yet. A gap ends
+ * the batch, so the samples lost always come in front of the ones returned.
+ */
+static uint32_t stream_take(uint32_t *samples, uint32_t max, uint32_t *lost)
+{
+    lobs_type_t *record;
+    uint32_t header;
+    uint32_t count = 0;
+    int32_t ahead;
+
+    if (stream_gap != 0) {
+        *lost += stream_gap;
+        stream_lost += stream_gap;
+        stream_gap = 0;
+    }
+    while (count < max) {
+        record = (lobs_type_t *)&lobs_buffer[stream_index * 4];
+        header = record->header_count;
+        if (stream_synced == false) {
+            if (header == STREAM_EMPTY) {
+                break;
+            }
+            stream_expected = header;
+            stream_synced = true;
+        }
+        ahead = (int32_t)(header - stream_expected);
+        if ((ahead < 0) || ((ahead > 0) && (count != 0))) {
+            break;
+        }
+        samples[count] = lobs_convert_pins(record->buffer.data);
+        if (record->header_count != header) {
+            /* overwritten while converting, take it again on the next round */
+            continue;
+        }
+        if (ahead > 0) {
+            /* in records, decimation of them per sample */
+            *lost += (uint32_t)ahead / convert_config.decimation;
+            stream_lost += (uint32_t)ahead / convert_config.decimation;
+        }
+        count++;
+        stream_expected = header + convert_config.decimation;
+        stream_index = (stream_index + convert_config.decimation) % TRACE_CNT;
+    }
+    return count;
+}
+
+/* hand the filled chunk to the bus, len bytes of it are sent */
+static void stream_queue(uint32_t len)
+{
+    sampling_stream_chunk_t *chunk = &stream_chunks[stream_fill];
+    uint32_t level;
+
+    chunk->sequence = stream_sequence++;
+    chunk->time = stream_chunk_time;
+    if (chunk->lost != 0) {
+        printf("stream overrun: %u samples lost, %u total\n", chunk->lost, stream_lost);
+    }
+    stream_len[stream_fill] = len;
+    /* the next chunk may still be on the bus, stream_poll() clears it once it is free */
+    stream_fill = (stream_fill + 1) % SAMPLING_STREAM_BUFFERS;
+    stream_fill_open = false;
+    stream_chunk_time = stream_time;
+
+    level = disable_global_irq(CSR_MSTATUS_MIE_MASK);
+    stream_queued++;
+    stream_kick();
+    restore_global_irq(level);
+}
+
+/*
+ * Run the decoders over the new samples a batch at a time, a decoder emits at most one event
+ * per sample so a batch is only started with room for all of them. The chunk goes out full or
+ * SAMPLING_DECODE_FLUSH_HZ after it was started, whichever comes first.
+ */
+static void stream_decode(void)
+{
+    sampling_stream_chunk_t *chunk = &stream_chunks[stream_fill];
+    proto_event_t *events = (proto_event_t *)chunk->samples;
+    uint32_t lost;
+    uint32_t count;
+    uint32_t len;
+
+    while ((chunk->count + SAMPLING_DECODE_BATCH * decoder_num) <= SAMPLING_EVENT_CHUNK) {
+        lost = 0;
+        count = stream_take(decode_samples, SAMPLING_DECODE_BATCH, &lost);
+        if (lost != 0) {
+            chunk->lost += lost;
+            stream_time += lost;
+            for (uint8_t i = 0; i < decoder_num; i++) {
+                proto_decode_reset(&decoders[i]);
+            }
+        }
+        if (count == 0) {
+            break;
+        }
+        for (uint8_t i = 0; i < decoder_num; i++) {
+            chunk->count += proto_decode_run(&decoders[i], decode_samples, count, (uint32_t)stream_time,
+                                             &events[chunk->count]);
+        }
+        stream_time += count;
+    }
+    if ((chunk->count + SAMPLING_DECODE_BATCH * decoder_num) <= SAMPLING_EVENT_CHUNK) {
+        if (((chunk->count == 0) && (chunk->lost == 0)) || ((stream_time - stream_chunk_time) < stream_flush_samples)) {
+            return;
+        }
+    }
+    chunk->magic = SAMPLING_EVENT_MAGIC;
+    len = offsetof(sampling_stream_chunk_t, samples) + chunk->count * sizeof(proto_event_t);
+    if ((len % 64) == 0) {
+        /* a short packet ends the host transfer, one spare event keeps chunks from merging */
+        len += sizeof(proto_event_t);
+    }
+    stream_queue(len);
+}
+
+static void stream_poll(void)
+{
+    sampling_stream_chunk_t *chunk = &stream_chunks[stream_fill];
+    uint32_t lost;
+    uint32_t count;
+    uint32_t len;
+
+    if (stream_queued == SAMPLING_STREAM_BUFFERS) {
+        /* every chunk waits for the bus, LOBS runs on and the gap shows up as lost */
+        return;
+    }
+    if (!stream_fill_open) {
+        chunk->count = 0;
+        chunk->lost = 0;
+        stream_fill_open = true;
+    }
+    lost = chunk->lost;
+    if (decoder_num != 0) {
+        stream_decode();
+        return;
+    }
+    if ((stream_gap == 0) || (chunk->count == 0)) {
+        count = stream_take(&chunk->samples[chunk->count], SAMPLING_STREAM_CHUNK - chunk->count, &chunk->lost);
+        chunk->count += count;
+        stream_time += count + (chunk->lost - lost);
+        if (chunk->count < SAMPLING_STREAM_CHUNK) {
+            return;
+        }
+    }
+    /* full, or cut short so a rearm gap goes in front of the next chunk */
+    chunk->magic = SAMPLING_STREAM_MAGIC;
+    len = offsetof(sampling_stream_chunk_t, samples) + chunk->count * sizeof(uint32_t);
+    if ((len != sizeof(stream_chunks[0])) && ((len % 64) == 0)) {
+        /* a short packet ends the host transfer, one spare sample keeps chunks from merging */
+        len += sizeof(uint32_t);
+    }
+    stream_queue(len);
+}
+
+/* one signal compare state per armed stage, matched moves on to the next state */
+static uint8_t config_trigger_state(uint8_t state, const trigger_stage_t *stage)
+{
+    lobs_state_config_t state_config = { 0 };
+    uint8_t sig = 0;
+
+    state_config.sig_group_num = SAMPLING_TRIG_SIG_GROUP;
+    state_config.cmp_mode = lobs_sig_cmp_mode;
+    state_config.state_chg_condition = lobs_sig_matched;
+    state_config.next_state = lobs_next_states[state + 1];
+    for (uint8_t ch = 0; ch < 32; ch++) {
+        if ((stage->mask & (1UL << ch)) == 0) {
+            continue;
+        }
+        if (sig == SAMPLING_TRIG_STAGE_BITS) {
+            printf("trigger stage %d: only %d probes compared\n", state, SAMPLING_TRIG_STAGE_BITS);
+            break;
+        }
+        state_config.cmp_sig_en[sig] = true;
+        state_config.cmp_sig_bit[sig] = SAMPLING_TRIG_SIG_BIT(ch);
+        state_config.cmp_golden_value[sig] = (stage->value >> ch) & 0x1;
+        sig++;
+    }
+    lobs_state_config(HPM_LOBS, state, &state_config);
+    return state + 1;
+}
+
+/*
+ * With pre-trigger enabled the trace memory is a ring until the final state is reached,
+ * the trigger stages only move the state machine along. The last state counts the
+ * records after the trigger, so the ring then holds capture_samples around the event.
+ */
+static uint8_t config_trigger_states(uint32_t *post_samples)
+{
+    uint8_t state = lobs_state_0;
+
+    *post_samples = capture_delay * convert_config.decimation;
+    for (uint8_t i = 0; i < SAMPLING_TRIG_STAGES; i++) {
+        if (trigger_stages[i].mask == 0) {
+            continue;
+        }
+        state = config_trigger_state(state, &trigger_stages[i]);
+        if (trigger_stages[i].config & SAMPLING_TRIG_CFG_START) {
+            *post_samples += (trigger_stages[i].config & SAMPLING_TRIG_CFG_DELAY_MASK) * convert_config.decimation;
+            break;
+        }
+    }
+    if (*post_samples == 0) {
+        *post_samples = 1;
+    }
+    return state;
 }
 
 void init_lobs_one_group_config(void)
 {
     lobs_ctrl_config_t ctrl_config;
     lobs_state_config_t state_config = { 0 };
+    uint32_t post_samples;
+    uint8_t state = lobs_state_0;
 
     lobs_unlock(HPM_LOBS);
 
     lobs_deinit(HPM_LOBS);
 
     ctrl_config.group_mode = lobs_one_group_128_bits;
-    ctrl_config.sample_rate = lobs_sample_1_per_7;
-    ctrl_config.start_addr = (uint32_t)&lobs_buffer[0];
-    ctrl_config.end_addr = (uint32_t)&lobs_buffer[0] + sizeof(lobs_buffer);
+    ctrl_config.sample_rate = lobs_rate;
+    /* decimated captures keep decimation records per sample in the trace memory */
+    capture_samples = TRACE_CNT / convert_config.decimation;
+    if (read_samples < capture_samples) {
+        capture_samples = read_samples;
+    }
+    capture_delay = (delay_samples < capture_samples) ? delay_samples : capture_samples;
+    if (!stream_mode && ((capture_samples * convert_config.decimation) <= (TRACE_CNT / 2))) {
+        trace_records = TRACE_CNT / 2;
+        trace_first = trace_half * trace_records;
+    } else {
+        trace_records = TRACE_CNT;
+        trace_first = 0;
+        trace_half = 0;
+    }
+
+    ctrl_config.start_addr = (uint32_t)&lobs_buffer[trace_first * 4];
+    ctrl_config.end_addr = ctrl_config.start_addr + trace_records * sizeof(lobs_type_t);
     lobs_ctrl_config(HPM_LOBS, &ctrl_config);
 
-    state_config.sig_group_num = 5;
+    if (stream_mode) {
+        /* longest count the state allows, lobs_loop() rearms when it runs out */
+        post_samples = UINT32_MAX;
+        decoders_init();
+        stream_reset();
+    } else {
+        state = config_trigger_states(&post_samples);
+    }
+
+    state_config.sig_group_num = SAMPLING_TRIG_SIG_GROUP;
     state_config.cmp_mode = lobs_cnt_cmp_mode;
     state_config.state_chg_condition = lobs_cnt_matched;
     state_config.next_state = lobs_next_state_finish;
-    state_config.cmp_counter = (TRACE_CNT);
+    state_config.cmp_counter = post_samples;
     state_config.cmp_sig_en[0] = false;
     state_config.cmp_sig_en[1] = false;
     state_config.cmp_sig_en[2] = false;
     state_config.cmp_sig_en[3] = false;
-    lobs_state_config(HPM_LOBS, lobs_state_0, &state_config);
-
+    lobs_state_config(HPM_LOBS, state, &state_config);
+    lobs_state_num = state + 1;
 
     lobs_lock(HPM_LOBS);
 }
@@ -231,37 +754,158 @@ void lobs_open(void)
 {
     lobs_unlock(HPM_LOBS);
     lobs_set_pre_trig_enable(HPM_LOBS, true);
-    lobs_set_state_enable(HPM_LOBS, lobs_state_0, true);
+    for (uint8_t state = 0; state < lobs_state_num; state++) {
+        lobs_set_state_enable(HPM_LOBS, state, true);
+    }
     lobs_set_enable(HPM_LOBS, true);
     lobs_lock(HPM_LOBS);
+    stream_open_cycle = hpm_csr_get_core_cycle();
 }
 
 void lobs_close(void)
 {
     lobs_unlock(HPM_LOBS);
     lobs_set_pre_trig_enable(HPM_LOBS, false);
-    lobs_set_state_enable(HPM_LOBS, lobs_state_0, false);
+    for (uint8_t state = 0; state < lobs_state_num; state++) {
+        lobs_set_state_enable(HPM_LOBS, state, false);
+    }
     lobs_set_enable(HPM_LOBS, false);
     lobs_lock(HPM_LOBS);
 }
 
-void lobs_loop(void)
+/* start the oldest ready report if the IN endpoint is free, USB interrupt context or interrupts masked */
+static void report_kick(void)
 {
-    lobs_type_t *buffer = NULL;
-    if (lobs_is_trace_finish(HPM_LOBS) == true) {
-        lobs_close();
-        printf("trace memory base addr: %#x, trace data final addr: %#x\n\n", (uint32_t)lobs_buffer, lobs_get_final_address(HPM_LOBS));
-        for (size_t i = 0; i < TRACE_CNT; i++) {
-            buffer = (lobs_type_t *)&lobs_buffer[(i * 4)];
-            pins_convert_buffer(buffer->buffer.pins, &report_buffer[i]);
-        }
-        if (!get_usb_cdc_tx_busy()) {
-            set_usb_cdc_tx_busy(true);
-            usbd_ep_start_write(0, CDC_IN_EP, (uint8_t*)report_buffer, sizeof(report_buffer));
-            while (get_usb_cdc_tx_busy()) {
-            };
+    uint8_t send = report_send;
+
+    if ((report_state[send] != REPORT_READY) || get_usb_cdc_tx_busy()) {
+        return;
+    }
+    report_state[send] = REPORT_SENDING;
+    set_usb_cdc_tx_busy(true);
+    usbd_ep_start_write(0, CDC_IN_EP, (uint8_t*)report_buffer[send], report_len[send]);
+}
+
+void sampling_tx_done(void)
+{
+#if !VENDOR_BULK_ENABLE
+    if (stream_sending) {
+        sampling_stream_tx_done();
+        return;
+    }
+#endif
+    if (report_state[report_send] == REPORT_SENDING) {
+        report_state[report_send] = REPORT_FREE;
+        report_send ^= 1;
+    }
+    report_kick();
+}
+
+/* drop captures still queued for upload, before a new run */
+static void sampling_flush(void)
+{
+    uint32_t level = disable_global_irq(CSR_MSTATUS_MIE_MASK);
+    /* a report on the bus finishes and is freed by sampling_tx_done(), queued ones are dropped */
+    for (uint8_t i = 0; i < 2; i++) {
+        if (report_state[i] == REPORT_READY) {
+            report_state[i] = REPORT_FREE;
         }
+    }
+    if (report_state[report_send] == REPORT_SENDING) {
+        report_fill = report_send ^ 1;
+    } else {
+        report_send = report_fill;
+    }
+    restore_global_irq(level);
+}
+
+void sampling_request_reset(void)
+{
+    sampling_request = REQUEST_RESET;
+}
+
+void sampling_request_run(void)
+{
+    sampling_request = REQUEST_RUN;
+}
+
+/* the last posted request, the setup the host sent before it is taken over by a run */
+static void sampling_serve_request(void)
+{
+    uint32_t level = disable_global_irq(CSR_MSTATUS_MIE_MASK);
+    uint8_t request = sampling_request;
+
+    sampling_request = REQUEST_NONE;
+    restore_global_irq(level);
+    if (request == REQUEST_NONE) {
+        return;
+    }
+    lobs_close();
+    sampling_flush();
+    if (request == REQUEST_RUN) {
+        init_lobs_one_group_config();
         lobs_open();
     }
 }
 
+void lobs_loop(void)
+{
+    uint32_t final_index;
+    uint32_t index;
+    uint32_t first;
+    uint32_t records;
+    uint32_t upload;
+    uint8_t *out;
+    uint32_t level;
+
+    sampling_serve_request();
+    if (stream_mode) {
+        if (lobs_is_trace_finish(HPM_LOBS) == true) {
+            stream_rearm();
+        }
+        stream_poll();
+        return;
+    }
+    if ((lobs_is_trace_finish(HPM_LOBS) == false) || (report_state[report_fill] != REPORT_FREE)) {
+        /* a finished trace waits in the trace memory until a report is free */
+        return;
+    }
+    lobs_close();
+    printf("trace memory base addr: %#x, trace data final addr: %#x\n\n", (uint32_t)&lobs_buffer[trace_first * 4], lobs_get_final_address(HPM_LOBS));
+    /* the final address is past the last record, the capture is the capture_samples before it */
+    first = trace_first;
+    records = trace_records;
+    final_index = ((lobs_get_final_address(HPM_LOBS) - (uint32_t)&lobs_buffer[first * 4]) / sizeof(lobs_type_t)) % records;
+    index = (final_index + records - capture_samples * convert_config.decimation) % records;
+
+    /* rearm first, into the other half when the capture fits one */
+    if (records < TRACE_CNT) {
+        trace_half ^= 1;
+        init_lobs_one_group_config();
+        lobs_open();
+    }
+    out = (uint8_t *)report_buffer[report_fill];
+    if (rle_enable) {
+        report_len[report_fill] = lobs_convert_rle(&convert_config, &lobs_buffer[first * 4], records, index, capture_samples, out);
+    } else {
+        report_len[report_fill] = lobs_convert_raw(&convert_config, &lobs_buffer[first * 4], records, index, capture_samples, out);
+    }
+    /* the host waits for all the samples it asked for, the trace memory may have held fewer */
+    upload = read_samples;
+    if (upload > (READ_SAMPLES_MAX / convert_config.sample_bytes)) {
+        upload = READ_SAMPLES_MAX / convert_config.sample_bytes;
+    }
+    if (upload > capture_samples) {
+        report_len[report_fill] += lobs_convert_hold(&convert_config, rle_enable, out, report_len[report_fill],
+                                                     upload - capture_samples);
+    }
+    if (records == TRACE_CNT) {
+        lobs_open();
+    }
+
+    level = disable_global_irq(CSR_MSTATUS_MIE_MASK);
+    report_state[report_fill] = REPORT_READY;
+    report_fill ^= 1;
+    report_kick();
+    restore_global_irq(level);
+}
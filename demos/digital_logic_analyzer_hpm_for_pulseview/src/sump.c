@@ -13,7 +13,7 @@
 const char metaData[] = {
     SUMP_META_NAME, 'h', 'p', 'm', 'i', 'c', 'r', 'o', '-', 'l', 'o','b', 's', '-', 'l', 'o', 'g', 'i', 'c', 0,
     SUMP_META_SAMPLE_RATE, BYTE4(maxSampleRate), BYTE3(maxSampleRate), BYTE2(maxSampleRate), BYTE1(maxSampleRate),
-    SUMP_META_SAMPLE_RAM, 0, 0, BYTE2(maxSampleMemory), BYTE1(maxSampleMemory), //24*1024 b
+    SUMP_META_SAMPLE_RAM, BYTE4(maxSampleMemory), BYTE3(maxSampleMemory), BYTE2(maxSampleMemory), BYTE1(maxSampleMemory),
     SUMP_META_PROBES_B, 32,
     SUMP_META_PROTOCOL_B, 1,
     SUMP_META_END
@@ -21,27 +21,54 @@ const char metaData[] = {
 
 const uint8_t id[5] = "1ALS";
 
-static uint32_t divider = 1;
-
-uint32_t calc_local_divider(uint32_t divider, const uint32_t local_frequency, const uint32_t sump_frequency) 
-{
-    return local_frequency / (sump_frequency / (divider + 1)) - 1;
-}
-
 int sump_process_request(uint8_t *buffer, uint16_t len)
 {
     int result = 0;
     printf(".....\r\n");
+    if (((buffer[0] & SUMP_CMD_TRIGGER_MASK) == SUMP_CMD_SET_BT0_MASK) && (len == 5))
+    {
+        uint8_t stage = SUMP_CMD_TRIGGER_STAGE(buffer[0]);
+        uint32_t arg = *((uint32_t*)(buffer+1));
+        switch (buffer[0] & SUMP_CMD_TRIGGER_OP)
+        {
+            case SUMP_CMD_SET_BT0_MASK & SUMP_CMD_TRIGGER_OP:
+                printf("set bt%d mask\r\n", stage);
+                sampling_set_trigger_mask(stage, arg);
+                return 1;
+            case SUMP_CMD_SET_BT0_VALUE & SUMP_CMD_TRIGGER_OP:
+                printf("set bt%d value\r\n", stage);
+                sampling_set_trigger_value(stage, arg);
+                return 1;
+            case SUMP_CMD_SET_BT0_CONFIG & SUMP_CMD_TRIGGER_OP:
+                printf("set bt%d config\r\n", stage);
+                sampling_set_trigger_config(stage, arg);
+                return 1;
+            default:
+                return 0;
+        }
+    }
+    if (((buffer[0] & SUMP_CMD_DECODER_MASK) == SUMP_CMD_SET_DECODER) && (len == 5))
+    {
+        printf("set decoder%d\r\n", SUMP_CMD_DECODER_SLOT(buffer[0]));
+        sampling_set_decoder(SUMP_CMD_DECODER_SLOT(buffer[0]), *((uint32_t*)(buffer+1)));
+        return 1;
+    }
+    if (((buffer[0] & SUMP_CMD_DECODER_MASK) == SUMP_CMD_SET_DECODER_PARAM) && (len == 5))
+    {
+        printf("set decoder%d param\r\n", SUMP_CMD_DECODER_SLOT(buffer[0]));
+        sampling_set_decoder_param(SUMP_CMD_DECODER_SLOT(buffer[0]), *((uint32_t*)(buffer+1)));
+        return 1;
+    }
     switch(buffer[0])
     {
         case SUMP_CMD_RESET://reset
-            lobs_close();
+            sampling_request_reset();
             printf("reset\r\n");
             result = 1;
             break;
         case SUMP_CMD_RUN://run
             printf("run\r\n");
-            lobs_open();
+            sampling_request_run();
             result = 1;
             break;
         case SUMP_CMD_ID://ID
@@ -63,20 +90,11 @@ int sump_process_request(uint8_t *buffer, uint16_t len)
             case SUMP_CMD_SET_SAMPLE_RATE:
             if(len == 5)
             {
-                //div120 = 120MHz / (100MHz / (div100 + 1)) - 1;
                 printf("set sample rate\r\n");
-                divider = *((uint32_t*)(buffer+1));
-                //if maximum samplerate is 20MHz => 100/20 = 5, 5 - 1 = 4
-                if(divider != 0)
-                {
-                    uint32_t clocks = 168000000; // сделать ф-ю для вычисления clocks
-                    divider = calc_local_divider(divider, clocks, SUMP_ORIGINAL_FREQ);
-                }
-                if(divider == 0)
-                {
-                    divider = 1;
-                }
-                // SetSamplingPeriod(divider);
+                //the divider counts periods of the original 100MHz clock
+                uint32_t divider = *((uint32_t*)(buffer+1)) & 0x00FFFFFF;
+                sampling_set_rate(SUMP_ORIGINAL_FREQ / (divider + 1));
+                printf("sample rate %u Hz\r\n", sampling_get_rate());
                 result = 1;
             }
             break;
@@ -86,24 +104,15 @@ int sump_process_request(uint8_t *buffer, uint16_t len)
                 printf("set counts\r\n");
                 uint16_t readCount  = 1 + *((uint16_t*)(buffer+1));
                 uint16_t delayCount = *((uint16_t*)(buffer+3));
-                // SetBufferSize(4 * readCount);
-                // SetDelayCount(4 * delayCount);
-                result = 1;
-            }
-            break;
-        case SUMP_CMD_SET_BT0_MASK:
-            if(len == 5)
-            {
-                printf("set bt0 mask\r\n");
-                // SetTriggerMask(*(uint32_t*)(buffer+1));
+                sampling_set_counts(4 * readCount, 4 * delayCount);
                 result = 1;
             }
             break;
-        case SUMP_CMD_SET_BT0_VALUE:
+        case SUMP_CMD_SET_STREAM:
             if(len == 5)
             {
-                printf("set bt0 value\r\n");
-                // SetTriggerValue(*(uint32_t*)(buffer+1));
+                printf("set stream\r\n");
+                sampling_set_stream(*((uint32_t*)(buffer+1)) != 0);
                 result = 1;
             }
             break;
@@ -111,7 +120,9 @@ int sump_process_request(uint8_t *buffer, uint16_t len)
             if(len == 5)
             {
                 printf("set flags\r\n");
-                // SetFlags(*(uint16_t*)(buffer+1));
+                uint16_t flags = *(uint16_t*)(buffer+1);
+                sampling_set_groups((~flags & SUMP_FLAG1_GROUPS) >> 2);
+                sampling_set_rle((flags & SUMP_FLAG1_ENABLE_RLE) != 0);
                 result = 1;
                 
             }
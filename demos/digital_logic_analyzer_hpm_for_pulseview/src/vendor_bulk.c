@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "usbd_core.h"
+#include "vendor_bulk.h"
+
+static uint8_t vendor_busid;
+static void (*vendor_tx_done)(void);
+static volatile bool vendor_configured;
+static volatile bool vendor_busy;
+
+static void vendor_bulk_in(uint8_t busid, uint8_t ep, uint32_t nbytes)
+{
+    if ((nbytes % usbd_get_ep_mps(busid, ep)) == 0 && nbytes) {
+        /* send zlp */
+        usbd_ep_start_write(busid, ep, NULL, 0);
+        return;
+    }
+    vendor_busy = false;
+    if (vendor_tx_done != NULL) {
+        vendor_tx_done();
+    }
+}
+
+static struct usbd_endpoint vendor_in_ep = {
+    .ep_addr = VENDOR_IN_EP,
+    .ep_cb = vendor_bulk_in
+};
+
+static struct usbd_interface vendor_intf;
+
+void vendor_bulk_init(uint8_t busid, void (*tx_done)(void))
+{
+    vendor_busid = busid;
+    vendor_tx_done = tx_done;
+    usbd_add_interface(busid, &vendor_intf);
+    usbd_add_endpoint(busid, &vendor_in_ep);
+}
+
+void vendor_bulk_set_configured(bool configured)
+{
+    bool aborted = vendor_busy;
+
+    vendor_configured = configured;
+    vendor_busy = false;
+    if ((aborted || configured) && (vendor_tx_done != NULL)) {
+        /*
+         * a bus reset ends the transfer without completion, hand the buffer back. Once configured
+         * the endpoint is free, chunks queued while it was not start going out.
+         */
+        vendor_tx_done();
+    }
+}
+
+bool vendor_bulk_is_busy(void)
+{
+    return vendor_busy || !vendor_configured;
+}
+
+bool vendor_bulk_write(const uint8_t *data, uint32_t len)
+{
+    if (vendor_bulk_is_busy()) {
+        return false;
+    }
+    vendor_busy = true;
+    usbd_ep_start_write(vendor_busid, VENDOR_IN_EP, data, len);
+    return true;
+}
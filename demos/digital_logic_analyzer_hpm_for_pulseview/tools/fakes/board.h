@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_BOARD_H
+#define _FAKE_BOARD_H
+
+#include "hpm_common.h"
+
+#define BOARD_RUNNING_CORE (0U)
+
+#endif /* _FAKE_BOARD_H */
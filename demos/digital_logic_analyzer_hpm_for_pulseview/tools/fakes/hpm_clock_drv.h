@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_HPM_CLOCK_DRV_H
+#define _FAKE_HPM_CLOCK_DRV_H
+
+#include "hpm_common.h"
+
+typedef uint32_t clock_name_t;
+
+uint32_t clock_get_frequency(clock_name_t clock_name);
+
+#endif /* _FAKE_HPM_CLOCK_DRV_H */
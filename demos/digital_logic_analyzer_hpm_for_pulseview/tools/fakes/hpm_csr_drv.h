@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_HPM_CSR_DRV_H
+#define _FAKE_HPM_CSR_DRV_H
+
+#include "hpm_common.h"
+
+/* core cycle counter, runs at hpm_core_clock, supplied by the host program */
+uint64_t hpm_csr_get_core_cycle(void);
+
+#endif /* _FAKE_HPM_CSR_DRV_H */
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_HPM_LOBS_DRV_H
+#define _FAKE_HPM_LOBS_DRV_H
+
+/*
+ * Host stand-in for the LOBS driver, only what sampling.c uses. The registers
+ * are a plain struct the replay (sump_replay/fake_lobs.c) runs as a model of
+ * one group 128 bit tracing: records from a dump are written into the trace
+ * memory ring while the state machine looks at the di bits of the probes.
+ */
+
+#include "hpm_common.h"
+
+#define LOBS_FAKE_STATES (5U)
+
+typedef enum {
+    lobs_one_group_128_bits = 0,
+    lobs_two_group_8_bits,
+} lobs_group_mode_t;
+
+/* one sample every value + 1 clocks */
+typedef enum {
+    lobs_sample_1_per_5 = 4,
+    lobs_sample_1_per_6 = 5,
+    lobs_sample_1_per_7 = 6,
+} lobs_sample_rate_t;
+
+typedef enum {
+    lobs_state_0 = 0,
+    lobs_state_1,
+    lobs_state_2,
+    lobs_state_3,
+    lobs_state_4,
+} lobs_state_index_t;
+
+typedef enum {
+    lobs_sig_cmp_mode = 0,
+    lobs_cnt_cmp_mode,
+} lobs_cmp_mode_t;
+
+typedef enum {
+    lobs_cnt_matched = 0,
+    lobs_sig_matched,
+    lobs_cnt_or_sig_matched,
+    lobs_cnt_and_sig_matched,
+} lobs_state_chg_condition_t;
+
+typedef enum {
+    lobs_next_state_finish = 0,
+    lobs_next_state_0 = 1,
+    lobs_next_state_1 = 2,
+    lobs_next_state_2 = 4,
+    lobs_next_state_3 = 8,
+    lobs_next_state_4 = 16,
+} lobs_next_state_t;
+
+typedef struct {
+    lobs_group_mode_t group_mode;
+    lobs_sample_rate_t sample_rate;
+    uint32_t start_addr;
+    uint32_t end_addr;
+} lobs_ctrl_config_t;
+
+typedef struct {
+    uint8_t sig_group_num;
+    lobs_cmp_mode_t cmp_mode;
+    lobs_state_chg_condition_t state_chg_condition;
+    lobs_next_state_t next_state;
+    uint32_t cmp_counter;
+    bool cmp_sig_en[4];
+    uint8_t cmp_sig_bit[4];
+    bool cmp_golden_value[4];
+} lobs_state_config_t;
+
+typedef struct {
+    bool locked;
+    bool enable;
+    bool pre_trig;
+    bool finish;
+    lobs_ctrl_config_t ctrl;
+    lobs_state_config_t state[LOBS_FAKE_STATES];
+    bool state_enable[LOBS_FAKE_STATES];
+    uint8_t current;        /* state the next record is compared in */
+    uint32_t counter;       /* records counted in it */
+    uint32_t header_count;  /* of the next record */
+    uint32_t write_addr;
+    uint32_t final_addr;
+} LOBS_Type;
+
+extern LOBS_Type g_fake_lobs;
+#define HPM_LOBS (&g_fake_lobs)
+
+void lobs_unlock(LOBS_Type *lobs);
+void lobs_lock(LOBS_Type *lobs);
+void lobs_deinit(LOBS_Type *lobs);
+void lobs_ctrl_config(LOBS_Type *lobs, lobs_ctrl_config_t *config);
+void lobs_state_config(LOBS_Type *lobs, lobs_state_index_t state, lobs_state_config_t *config);
+void lobs_set_pre_trig_enable(LOBS_Type *lobs, bool enable);
+void lobs_set_state_enable(LOBS_Type *lobs, lobs_state_index_t state, bool enable);
+void lobs_set_enable(LOBS_Type *lobs, bool enable);
+bool lobs_is_trace_finish(LOBS_Type *lobs);
+uint32_t lobs_get_final_address(LOBS_Type *lobs);
+
+#endif /* _FAKE_HPM_LOBS_DRV_H */
@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _FAKE_USBD_CDC_ACM_H
+#define _FAKE_USBD_CDC_ACM_H
+
+#include "usbd_core.h"
+
+struct usbd_interface *usbd_cdc_acm_init_intf(uint8_t busid, struct usbd_interface *intf);
+
+#endif /* _FAKE_USBD_CDC_ACM_H */
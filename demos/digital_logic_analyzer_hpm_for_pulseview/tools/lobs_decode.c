@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host side decoder for LOBS trace memory dumps, built from the same
+ * src/lobs_convert.c the firmware uses. Turns raw records (four little endian
+ * words each, see lobs_convert.h) into the SUMP sample stream the analyzer
+ * uploads, checks the conversion against a bit by bit reference and times it.
+ *
+ * A dump comes from the debugger once a capture has finished, for example
+ *     dump binary memory trace.bin &lobs_buffer[0] &lobs_buffer[81920]
+ *
+ * build: cc -O2 -I../inc -o lobs_decode lobs_decode.c ../src/lobs_convert.c
+ * usage: lobs_decode [-g groups] [-d decimation] [-r] [-c] [-b rounds] <dump> [output]
+ *   -g  enabled probe groups as a bit mask, as SUMP_CMD_SET_FLAGS selects them (default 0xf)
+ *   -d  keep every n-th record
+ *   -r  run length encode
+ *   -c  compare every sample with the bit by bit reference, exit 1 on a mismatch
+ *   -b  convert the dump this many times and print the throughput
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "lobs_convert.h"
+
+/* the di bit of pin n, one bit at a time as the pins_type_t bitfields lay it out */
+static uint32_t reference_pins(const uint32_t *data)
+{
+    uint32_t value = 0;
+
+    for (uint32_t pin = 0; pin < 32; pin++) {
+        uint32_t bit = pin * 3 + 2;
+        value |= ((data[bit / 32] >> (bit % 32)) & 1U) << pin;
+    }
+    return value;
+}
+
+static int check_records(const uint32_t *records, uint32_t record_num)
+{
+    for (uint32_t i = 0; i < record_num; i++) {
+        const uint32_t *data = &records[i * LOBS_RECORD_WORDS + 1];
+        if (lobs_convert_pins(data) != reference_pins(data)) {
+            fprintf(stderr, "record %u: %08x, reference %08x\n", i, lobs_convert_pins(data), reference_pins(data));
+            return 1;
+        }
+    }
+    fprintf(stderr, "%u records match the reference\n", record_num);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    lobs_convert_config_t config = LOBS_CONVERT_CONFIG_DEFAULT;
+    uint32_t *records;
+    uint8_t *out;
+    uint32_t record_num;
+    uint32_t count;
+    uint32_t len = 0;
+    long size;
+    int rounds = 0;
+    int rle = 0;
+    int check = 0;
+    int opt;
+    FILE *file;
+
+    while ((opt = getopt(argc, argv, "g:d:rcb:")) != -1) {
+        switch (opt) {
+        case 'g':
+            lobs_convert_set_groups(&config, (uint8_t)strtoul(optarg, NULL, 0));
+            break;
+        case 'd':
+            config.decimation = strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            rle = 1;
+            break;
+        case 'c':
+            check = 1;
+            break;
+        case 'b':
+            rounds = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-g groups] [-d decimation] [-r] [-c] [-b rounds] <dump> [output]\n", argv[0]);
+            return 2;
+        }
+    }
+    if ((optind >= argc) || (config.decimation == 0)) {
+        fprintf(stderr, "usage: %s [-g groups] [-d decimation] [-r] [-c] [-b rounds] <dump> [output]\n", argv[0]);
+        return 2;
+    }
+
+    file = fopen(argv[optind], "rb");
+    if (file == NULL) {
+        perror(argv[optind]);
+        return 2;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    record_num = (uint32_t)(size / (LOBS_RECORD_WORDS * 4));
+    records = malloc(record_num * LOBS_RECORD_WORDS * 4);
+    out = malloc(record_num * 4 + 4);
+    if ((record_num == 0) || (records == NULL) || (out == NULL) ||
+        (fread(records, LOBS_RECORD_WORDS * 4, record_num, file) != record_num)) {
+        fprintf(stderr, "%s: no complete records\n", argv[optind]);
+        return 2;
+    }
+    fclose(file);
+
+    if (check && check_records(records, record_num)) {
+        return 1;
+    }
+
+    count = record_num / config.decimation;
+    for (int i = 0; i < ((rounds > 0) ? rounds : 1); i++) {
+        clock_t start = clock();
+        if (rle) {
+            len = lobs_convert_rle(&config, records, record_num, 0, count, out);
+        } else {
+            len = lobs_convert_raw(&config, records, record_num, 0, count, out);
+        }
+        if ((rounds > 0) && (i == rounds - 1)) {
+            double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+            fprintf(stderr, "%u samples in %.3f ms, %.1f Msamples/s\n", count, seconds * 1000.0,
+                    (seconds > 0) ? (count / seconds / 1e6) : 0.0);
+        }
+    }
+    fprintf(stderr, "%u samples, %u bytes uploaded (%u bytes per sample%s)\n", count, len,
+            config.sample_bytes, rle ? ", rle" : "");
+
+    if (optind + 1 < argc) {
+        file = fopen(argv[optind + 1], "wb");
+        if ((file == NULL) || (fwrite(out, 1, len, file) != len)) {
+            perror(argv[optind + 1]);
+            return 2;
+        }
+        fclose(file);
+    }
+    free(records);
+    free(out);
+    return 0;
+}
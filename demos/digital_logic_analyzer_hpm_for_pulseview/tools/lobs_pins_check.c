@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host check of lobs_convert_pins() against the pins_type_t bitfield
+ * conversion sampling.c used before, kept here as it was. Runs every record
+ * with a single bit set, all zeros and all ones, then random records.
+ *
+ * build: cc -O2 -I../inc -o lobs_pins_check lobs_pins_check.c
+ * usage: lobs_pins_check [records] [seed]
+ *   records  random records to compare (default 4000000)
+ *   seed     start of the xorshift sequence (default 1)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "lobs_convert.h"
+
+typedef struct pins_type
+{
+    uint32_t p0_d0 : 1;
+    uint32_t p0_oe : 1;
+    uint32_t p0_di : 1;
+
+    uint32_t p1_d0 : 1;
+    uint32_t p1_oe : 1;
+    uint32_t p1_di : 1;
+
+    uint32_t p2_d0 : 1;
+    uint32_t p2_oe : 1;
+    uint32_t p2_di : 1;
+
+    uint32_t p3_d0 : 1;
+    uint32_t p3_oe : 1;
+    uint32_t p3_di : 1;
+
+    uint32_t p4_d0 : 1;
+    uint32_t p4_oe : 1;
+    uint32_t p4_di : 1;
+
+    uint32_t p5_d0 : 1;
+    uint32_t p5_oe : 1;
+    uint32_t p5_di : 1;
+
+    uint32_t p6_d0 : 1;
+    uint32_t p6_oe : 1;
+    uint32_t p6_di : 1;
+
+    uint32_t p7_d0 : 1;
+    uint32_t p7_oe : 1;
+    uint32_t p7_di : 1;
+
+    uint32_t p8_d0 : 1;
+    uint32_t p8_oe : 1;
+    uint32_t p8_di : 1;
+
+    uint32_t p9_d0 : 1;
+    uint32_t p9_oe : 1;
+    uint32_t p9_di : 1;
+
+    uint32_t p10_d0 : 1;
+    uint32_t p10_oe : 1;
+    uint32_t p10_di : 1;
+
+    uint32_t p11_d0 : 1;
+    uint32_t p11_oe : 1;
+    uint32_t p11_di : 1;
+
+    uint32_t p12_d0 : 1;
+    uint32_t p12_oe : 1;
+    uint32_t p12_di : 1;
+
+    uint32_t p13_d0 : 1;
+    uint32_t p13_oe : 1;
+    uint32_t p13_di : 1;
+
+    uint32_t p14_d0 : 1;
+    uint32_t p14_oe : 1;
+    uint32_t p14_di : 1;
+
+    uint32_t p15_d0 : 1;
+    uint32_t p15_oe : 1;
+    uint32_t p15_di : 1;
+
+    uint32_t p16_d0 : 1;
+    uint32_t p16_oe : 1;
+    uint32_t p16_di : 1;
+
+    uint32_t p17_d0 : 1;
+    uint32_t p17_oe : 1;
+    uint32_t p17_di : 1;
+
+    uint32_t p18_d0 : 1;
+    uint32_t p18_oe : 1;
+    uint32_t p18_di : 1;
+
+    uint32_t p19_d0 : 1;
+    uint32_t p19_oe : 1;
+    uint32_t p19_di : 1;
+
+    uint32_t p20_d0 : 1;
+    uint32_t p20_oe : 1;
+    uint32_t p20_di : 1;
+
+    uint32_t p21_d0 : 1;
+    uint32_t p21_oe : 1;
+    uint32_t p21_di : 1;
+
+    uint32_t p22_d0 : 1;
+    uint32_t p22_oe : 1;
+    uint32_t p22_di : 1;
+
+    uint32_t p23_d0 : 1;
+    uint32_t p23_oe : 1;
+    uint32_t p23_di : 1;
+
+    uint32_t p24_d0 : 1;
+    uint32_t p24_oe : 1;
+    uint32_t p24_di : 1;
+
+    uint32_t p25_d0 : 1;
+    uint32_t p25_oe : 1;
+    uint32_t p25_di : 1;
+
+    uint32_t p26_d0 : 1;
+    uint32_t p26_oe : 1;
+    uint32_t p26_di : 1;
+
+    uint32_t p27_d0 : 1;
+    uint32_t p27_oe : 1;
+    uint32_t p27_di : 1;
+
+    uint32_t p28_d0 : 1;
+    uint32_t p28_oe : 1;
+    uint32_t p28_di : 1;
+
+    uint32_t p29_d0 : 1;
+    uint32_t p29_oe : 1;
+    uint32_t p29_di : 1;
+
+    uint32_t p30_d0 : 1;
+    uint32_t p30_oe : 1;
+    uint32_t p30_di : 1;
+
+    uint32_t p31_d0 : 1;
+    uint32_t p31_oe : 1;
+    uint32_t p31_di : 1;
+
+} pins_type_t;
+
+static void pins_convert_buffer(pins_type_t pins, uint32_t *buffer)
+{
+    (*buffer) = pins.p31_di << 31;
+    (*buffer) |= pins.p30_di << 30;
+    (*buffer) |= pins.p29_di << 29;
+    (*buffer) |= pins.p28_di << 28;
+    (*buffer) |= pins.p27_di << 27;
+    (*buffer) |= pins.p26_di << 26;
+    (*buffer) |= pins.p25_di << 25;
+    (*buffer) |= pins.p24_di << 24;
+    (*buffer) |= pins.p23_di << 23;
+    (*buffer) |= pins.p22_di << 22;
+    (*buffer) |= pins.p21_di << 21;
+    (*buffer) |= pins.p20_di << 20;
+    (*buffer) |= pins.p19_di << 19;
+    (*buffer) |= pins.p18_di << 18;
+    (*buffer) |= pins.p17_di << 17;
+    (*buffer) |= pins.p16_di << 16;
+    (*buffer) |= pins.p15_di << 15;
+    (*buffer) |= pins.p14_di << 14;
+    (*buffer) |= pins.p13_di << 13;
+    (*buffer) |= pins.p12_di << 12;
+    (*buffer) |= pins.p11_di << 11;
+    (*buffer) |= pins.p10_di << 10;
+    (*buffer) |= pins.p9_di << 9;
+    (*buffer) |= pins.p8_di << 8;
+    (*buffer) |= pins.p7_di << 7;
+    (*buffer) |= pins.p6_di << 6;
+    (*buffer) |= pins.p5_di << 5;
+    (*buffer) |= pins.p4_di << 4;
+    (*buffer) |= pins.p3_di << 3;
+    (*buffer) |= pins.p2_di << 2;
+    (*buffer) |= pins.p1_di << 1;
+    (*buffer) |= pins.p0_di << 0;
+}
+
+static uint32_t xorshift_state;
+
+static uint32_t xorshift32(void)
+{
+    uint32_t x = xorshift_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    xorshift_state = x;
+    return x;
+}
+
+static int check_record(const uint32_t *data)
+{
+    pins_type_t pins;
+    uint32_t expect;
+    uint32_t value;
+
+    memcpy(&pins, data, sizeof(pins));
+    pins_convert_buffer(pins, &expect);
+    value = lobs_convert_pins(data);
+    if (value != expect) {
+        fprintf(stderr, "record %08x %08x %08x: %08x, bitfields %08x\n", data[0], data[1], data[2], value, expect);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t data[3];
+    uint32_t records = 4000000;
+    uint32_t checked = 0;
+
+    if (argc > 1) {
+        records = strtoul(argv[1], NULL, 0);
+    }
+    xorshift_state = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1;
+    if ((sizeof(pins_type_t) != sizeof(data)) || (xorshift_state == 0)) {
+        fprintf(stderr, "usage: %s [records] [seed], seed not 0\n", argv[0]);
+        return 2;
+    }
+
+    for (uint32_t bit = 0; bit < 96; bit++) {
+        memset(data, 0, sizeof(data));
+        data[bit / 32] = 1UL << (bit % 32);
+        if (check_record(data)) {
+            return 1;
+        }
+        checked++;
+    }
+    memset(data, 0, sizeof(data));
+    checked += 2;
+    if (check_record(data)) {
+        return 1;
+    }
+    memset(data, 0xFF, sizeof(data));
+    if (check_record(data)) {
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < records; i++) {
+        data[0] = xorshift32();
+        data[1] = xorshift32();
+        data[2] = xorshift32();
+        if (check_record(data)) {
+            return 1;
+        }
+        checked++;
+    }
+    fprintf(stderr, "%u records match the bitfield conversion\n", checked);
+    return 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host round trip check of lobs_convert_rle(). Builds random traces out of runs
+ * of short and long length (past the largest count a 1 byte sample holds),
+ * converts them with every probe group selection, so 1, 2, 3 and 4 byte packing
+ * with the groups low and spread, at random decimations and start records that
+ * wrap, then expands the result the way a SUMP client does and compares it with
+ * lobs_convert_raw() less the rle flag probe. The rle stream must not be longer.
+ * Both then get the last sample held for a random count with lobs_convert_hold(),
+ * which has to expand the same way.
+ *
+ * build: cc -O2 -I../inc -o lobs_rle_check lobs_rle_check.c ../src/lobs_convert.c
+ * usage: lobs_rle_check [traces] [seed]
+ *   traces  random traces per group selection (default 200)
+ *   seed    start of the xorshift sequence (default 1)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "lobs_convert.h"
+
+#define CHECK_RECORDS (8192)
+/* held samples, past the longest run of a 1 byte sample */
+#define CHECK_HOLD_MAX (300)
+
+static uint32_t records[CHECK_RECORDS * LOBS_RECORD_WORDS];
+static uint8_t raw[(CHECK_RECORDS + CHECK_HOLD_MAX) * 4];
+static uint8_t rle[(CHECK_RECORDS + CHECK_HOLD_MAX) * 4];
+static uint8_t expanded[(CHECK_RECORDS + CHECK_HOLD_MAX) * 4];
+
+static uint32_t xorshift_state;
+
+static uint32_t xorshift32(void)
+{
+    uint32_t x = xorshift_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    xorshift_state = x;
+    return x;
+}
+
+/* a record whose di bits read as pins, d0 and oe bits random */
+static void put_record(uint32_t *record, uint32_t pins)
+{
+    record[0] = xorshift32();
+    /* the di bits of the three data words are every third bit from bit 2, 0 and 1 */
+    record[1] = xorshift32() & ~0x24924924UL;
+    record[2] = xorshift32() & ~0x49249249UL;
+    record[3] = xorshift32() & ~0x92492492UL;
+    for (uint32_t pin = 0; pin < 32; pin++) {
+        uint32_t bit = pin * 3 + 2;
+        record[1 + bit / 32] |= ((pins >> pin) & 1U) << (bit % 32);
+    }
+}
+
+/* runs of one value, mostly short, sometimes longer than the rle count of the narrowest sample */
+static void make_trace(void)
+{
+    uint32_t value = xorshift32();
+    uint32_t run = 0;
+
+    for (uint32_t i = 0; i < CHECK_RECORDS; i++) {
+        if (run == 0) {
+            switch (xorshift32() % 4) {
+            case 0:
+                run = 1;
+                break;
+            case 1:
+                run = 1 + xorshift32() % 8;
+                break;
+            case 2:
+                run = 100 + xorshift32() % 400;
+                break;
+            default:
+                run = 1 + xorshift32() % 40;
+                break;
+            }
+            /* flip a few probes, or all of them */
+            value ^= (xorshift32() % 8 == 0) ? xorshift32() : (1UL << (xorshift32() % 32));
+        }
+        put_record(&records[i * LOBS_RECORD_WORDS], value);
+        run--;
+    }
+}
+
+static uint32_t get_sample(const uint8_t *in, uint8_t bytes)
+{
+    uint32_t value = 0;
+
+    for (uint8_t i = 0; i < bytes; i++) {
+        value |= (uint32_t)in[i] << (i * 8);
+    }
+    return value;
+}
+
+/* SUMP rle: a flagged sample repeats the value sample after it count + 1 times, -1 on a malformed stream */
+static int32_t rle_expand(const uint8_t *in, uint32_t len, uint8_t bytes, uint8_t *out, uint32_t max)
+{
+    uint32_t rle_flag = 1UL << (bytes * 8 - 1);
+    uint32_t pos = 0;
+    uint32_t samples = 0;
+    uint32_t repeat;
+    uint32_t value;
+
+    while (pos < len) {
+        value = get_sample(&in[pos], bytes);
+        pos += bytes;
+        repeat = 1;
+        if (value & rle_flag) {
+            if (pos >= len) {
+                return -1;
+            }
+            repeat = (value & ~rle_flag) + 1;
+            value = get_sample(&in[pos], bytes);
+            pos += bytes;
+            if ((value & rle_flag) || (repeat < 2)) {
+                return -1;
+            }
+        }
+        if (samples + repeat > max) {
+            return -1;
+        }
+        while (repeat--) {
+            memcpy(&out[samples * bytes], &value, bytes);
+            samples++;
+        }
+    }
+    return (int32_t)samples;
+}
+
+static int check_trace(const lobs_convert_config_t *config, uint32_t index, uint32_t count, uint32_t hold)
+{
+    uint8_t bytes = config->sample_bytes;
+    uint32_t rle_flag = 1UL << (bytes * 8 - 1);
+    uint32_t raw_len;
+    uint32_t rle_len;
+    int32_t samples;
+
+    raw_len = lobs_convert_raw(config, records, CHECK_RECORDS, index, count, raw);
+    rle_len = lobs_convert_rle(config, records, CHECK_RECORDS, index, count, rle);
+    raw_len += lobs_convert_hold(config, false, raw, raw_len, hold);
+    rle_len += lobs_convert_hold(config, true, rle, rle_len, hold);
+    count += hold;
+    samples = rle_expand(rle, rle_len, bytes, expanded, count);
+    if (rle_len > raw_len) {
+        fprintf(stderr, "groups %x: rle %u bytes, raw %u\n", config->group_enable, rle_len, raw_len);
+        return 1;
+    }
+    if (samples != (int32_t)count) {
+        fprintf(stderr, "groups %x decimation %u index %u: %d samples expanded, %u converted\n",
+                config->group_enable, config->decimation, index, samples, count);
+        return 1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t expect = get_sample(&raw[i * bytes], bytes) & ~rle_flag;
+        uint32_t value = get_sample(&expanded[i * bytes], bytes);
+        if (value != expect) {
+            fprintf(stderr, "groups %x decimation %u index %u sample %u: %x, raw %x\n",
+                    config->group_enable, config->decimation, index, i, value, expect);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    lobs_convert_config_t config = LOBS_CONVERT_CONFIG_DEFAULT;
+    uint32_t traces = 200;
+    uint32_t checked = 0;
+    uint32_t index;
+    uint32_t count;
+
+    if (argc > 1) {
+        traces = strtoul(argv[1], NULL, 0);
+    }
+    xorshift_state = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1;
+    if (xorshift_state == 0) {
+        fprintf(stderr, "usage: %s [traces] [seed], seed not 0\n", argv[0]);
+        return 2;
+    }
+
+    for (uint32_t t = 0; t < traces; t++) {
+        make_trace();
+        for (uint8_t groups = 1; groups <= 0x0F; groups++) {
+            lobs_convert_set_groups(&config, groups);
+            config.decimation = (xorshift32() % 2) ? 1 : 1 + xorshift32() % 7;
+            index = xorshift32() % CHECK_RECORDS;
+            count = 1 + xorshift32() % (CHECK_RECORDS / config.decimation);
+            if (check_trace(&config, index, count, (xorshift32() % 2) ? 0 : xorshift32() % CHECK_HOLD_MAX)) {
+                return 1;
+            }
+            checked++;
+        }
+    }
+    fprintf(stderr, "%u conversions expand to the raw samples\n", checked);
+    return 0;
+}
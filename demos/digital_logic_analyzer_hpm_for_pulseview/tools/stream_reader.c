@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host side reader for the vendor bulk streaming endpoint (VENDOR_BULK_ENABLE).
+ * Keeps several bulk IN transfers queued so the endpoint never waits for the
+ * host, checks the chunk headers and writes the samples as little endian
+ * 32 bit words, ready for
+ *
+ *     sigrok-cli -I binary:numchannels=32:samplerate=<rate> -i <file> ...
+ *
+ * Samples lost to a trace memory overrun are filled with the last sample, so
+ * the time base stays right, and reported on stderr.
+ *
+ * With on-device decoders set (SUMP_CMD_SET_DECODER) the chunks carry events
+ * and the output is one text line per event instead:
+ *
+ *     <sample index> <slot> <type> <data hex> <flags hex>
+ *
+ * The sample index is the full 64 bit one, rebuilt from the low 32 bits an
+ * event carries and the time of its chunk.
+ *
+ * Streaming is started on the CDC port as usual: SUMP_CMD_SET_STREAM with 1,
+ * then SUMP_CMD_RUN.
+ *
+ * build: cc -O2 -o stream_reader stream_reader.c $(pkg-config --cflags --libs libusb-1.0)
+ * usage: stream_reader <output file> [seconds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <libusb.h>
+
+#define READER_VID          0x34B7
+#define READER_PID          0xFFFF
+#define READER_INTF         0x02
+#define READER_IN_EP        0x82
+
+#define READER_TRANSFERS    8
+#define READER_BUFFER_SIZE  (64 * 1024)
+#define READER_TIMEOUT_MS   1000
+
+#define STREAM_MAGIC        0x4D525453UL
+#define EVENT_MAGIC         0x544E5645UL
+#define STREAM_HEADER_SIZE  24
+#define EVENT_SIZE          8
+
+static FILE *reader_out;
+static volatile int reader_stop;
+static int reader_pending;
+static int reader_started;
+static uint32_t reader_sequence;
+static uint32_t reader_last_sample;
+static uint64_t reader_samples;
+static uint64_t reader_lost;
+static uint64_t reader_bad;
+static uint64_t reader_events;
+
+static const char *const event_names[] = {
+    "uart", "spi", "i2c-start", "i2c-stop", "i2c-addr", "i2c-data",
+};
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get_le64(const uint8_t *p)
+{
+    return (uint64_t)get_le32(p) | ((uint64_t)get_le32(p + 4) << 32);
+}
+
+static void put_repeated(uint32_t sample, uint32_t count)
+{
+    uint8_t le[4] = { (uint8_t)sample, (uint8_t)(sample >> 8), (uint8_t)(sample >> 16), (uint8_t)(sample >> 24) };
+
+    while (count--) {
+        fwrite(le, sizeof(le), 1, reader_out);
+    }
+}
+
+static void reader_chunk(const uint8_t *data, int len)
+{
+    uint32_t sequence;
+    uint32_t count;
+    uint32_t lost;
+    uint32_t magic;
+    uint64_t time;
+
+    magic = (len < STREAM_HEADER_SIZE) ? 0 : get_le32(data);
+    if ((magic != STREAM_MAGIC) && (magic != EVENT_MAGIC)) {
+        reader_bad++;
+        return;
+    }
+    sequence = get_le32(data + 4);
+    count = get_le32(data + 8);
+    lost = get_le32(data + 12);
+    time = get_le64(data + 16);
+    if ((uint32_t)len < STREAM_HEADER_SIZE + count * ((magic == EVENT_MAGIC) ? EVENT_SIZE : 4U)) {
+        reader_bad++;
+        return;
+    }
+    if (reader_started && (sequence != reader_sequence)) {
+        fprintf(stderr, "chunk %u missing before %u\n", reader_sequence, sequence);
+    }
+    reader_started = 1;
+    reader_sequence = sequence + 1;
+    if (magic == EVENT_MAGIC) {
+        if (lost != 0) {
+            fprintf(stderr, "chunk %u: %u samples lost on the device\n", sequence, lost);
+            reader_lost += lost;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            const uint8_t *event = data + STREAM_HEADER_SIZE + i * EVENT_SIZE;
+            uint8_t type = event[6] & 0x0F;
+            /* a symbol can start before the chunk, the difference is signed */
+            uint64_t timestamp = time + (int64_t)(int32_t)(get_le32(event) - (uint32_t)time);
+
+            fprintf(reader_out, "%llu %u %s %04x %02x\n", (unsigned long long)timestamp, event[6] >> 4,
+                    (type < sizeof(event_names) / sizeof(event_names[0])) ? event_names[type] : "?",
+                    (unsigned int)(event[4] | (event[5] << 8)), event[7]);
+        }
+        reader_events += count;
+        return;
+    }
+    if (lost != 0) {
+        fprintf(stderr, "chunk %u: %u samples lost on the device\n", sequence, lost);
+        put_repeated(reader_last_sample, lost);
+        reader_lost += lost;
+    }
+    fwrite(data + STREAM_HEADER_SIZE, 4, count, reader_out);
+    if (count != 0) {
+        reader_last_sample = get_le32(data + STREAM_HEADER_SIZE + (count - 1) * 4U);
+    }
+    reader_samples += count;
+}
+
+static void LIBUSB_CALL reader_callback(struct libusb_transfer *transfer)
+{
+    if (transfer->status == LIBUSB_TRANSFER_COMPLETED) {
+        reader_chunk(transfer->buffer, transfer->actual_length);
+    } else if (transfer->status != LIBUSB_TRANSFER_TIMED_OUT) {
+        fprintf(stderr, "transfer failed: %s\n", libusb_error_name(transfer->status));
+        reader_stop = 1;
+    }
+    /* resubmit at once, the other queued transfers keep the endpoint busy meanwhile */
+    if (!reader_stop && (libusb_submit_transfer(transfer) == 0)) {
+        return;
+    }
+    reader_pending--;
+}
+
+static void reader_signal(int sig)
+{
+    (void)sig;
+    reader_stop = 1;
+}
+
+int main(int argc, char **argv)
+{
+    struct libusb_transfer *transfers[READER_TRANSFERS] = { NULL };
+    libusb_device_handle *handle;
+    time_t end = 0;
+    int result = 1;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <output file> [seconds]\n", argv[0]);
+        return 1;
+    }
+    reader_out = fopen(argv[1], "wb");
+    if (reader_out == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    if (argc > 2) {
+        end = time(NULL) + atoi(argv[2]);
+    }
+    if (libusb_init(NULL) != 0) {
+        fprintf(stderr, "libusb_init failed\n");
+        return 1;
+    }
+    handle = libusb_open_device_with_vid_pid(NULL, READER_VID, READER_PID);
+    if (handle == NULL) {
+        fprintf(stderr, "device %04x:%04x not found\n", READER_VID, READER_PID);
+        goto exit;
+    }
+    if (libusb_claim_interface(handle, READER_INTF) != 0) {
+        fprintf(stderr, "interface %d busy or missing, is VENDOR_BULK_ENABLE set?\n", READER_INTF);
+        goto close;
+    }
+    signal(SIGINT, reader_signal);
+
+    for (int i = 0; i < READER_TRANSFERS; i++) {
+        transfers[i] = libusb_alloc_transfer(0);
+        libusb_fill_bulk_transfer(transfers[i], handle, READER_IN_EP, malloc(READER_BUFFER_SIZE),
+                                  READER_BUFFER_SIZE, reader_callback, NULL, READER_TIMEOUT_MS);
+        if (libusb_submit_transfer(transfers[i]) == 0) {
+            reader_pending++;
+        }
+    }
+    while (reader_pending > 0) {
+        if ((end != 0) && (time(NULL) >= end)) {
+            reader_stop = 1;
+        }
+        libusb_handle_events(NULL);
+    }
+    fprintf(stderr, "%llu samples, %llu events, %llu lost, %llu bad chunks\n", (unsigned long long)reader_samples,
+            (unsigned long long)reader_events, (unsigned long long)reader_lost, (unsigned long long)reader_bad);
+    result = 0;
+
+    for (int i = 0; i < READER_TRANSFERS; i++) {
+        if (transfers[i] != NULL) {
+            free(transfers[i]->buffer);
+            libusb_free_transfer(transfers[i]);
+        }
+    }
+    libusb_release_interface(handle, READER_INTF);
+close:
+    libusb_close(handle);
+exit:
+    libusb_exit(NULL);
+    fclose(reader_out);
+    return result;
+}
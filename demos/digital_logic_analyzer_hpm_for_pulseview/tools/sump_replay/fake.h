@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _SUMP_REPLAY_FAKE_H
+#define _SUMP_REPLAY_FAKE_H
+
+/*
+ * Control side of the in-memory fakes the analyzer firmware is linked
+ * against on the host. The firmware sees the SDK and CherryUSB APIs from
+ * tools/fakes/, the replay drives the other end through these calls.
+ *
+ * Nothing runs on its own: between two passes of the main loop the replay
+ * lets LOBS record for a while and the host take IN transfers, so the
+ * output only depends on the script.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* hpm_csr_get_core_cycle() rate, three core cycles per LOBS clock */
+#define FAKE_CORE_CLOCK (600000000UL)
+
+/* fake_lobs.c */
+void fake_lobs_source(const uint32_t *records, uint32_t record_num);
+void fake_lobs_run(uint32_t periods);
+uint64_t fake_core_cycle(void);
+
+/* fake_usbd.c */
+typedef void (*fake_usbd_sink_t)(uint8_t ep, const uint8_t *data, uint32_t len);
+void fake_usbd_set_sink(fake_usbd_sink_t sink);
+void fake_usbd_event(uint8_t event);
+bool fake_usbd_out(uint8_t ep, const uint8_t *data, uint32_t len);
+void fake_usbd_run(uint32_t budget);
+
+#endif /* _SUMP_REPLAY_FAKE_H */
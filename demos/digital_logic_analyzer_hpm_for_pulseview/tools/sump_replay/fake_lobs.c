@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * LOBS model, one group 128 bit mode. While enabled and not finished every
+ * sample period writes the next record of the source dump into the trace
+ * memory ring with a header count going up by one from 0. The state machine
+ * sees each record after it was written: a signal compare state matches when
+ * the di bits of its enabled probes equal the golden values, a counter compare
+ * state once it has seen cmp_counter records. Moving on to
+ * lobs_next_state_finish stops the trace, the final address is then past the
+ * last record written. This is how sampling.c reads the reference manual,
+ * the golden files pin that reading, not the silicon.
+ *
+ * Writing the configuration while the registers are locked is a firmware bug
+ * the real block would silently ignore, the model stops the replay instead.
+ */
+
+#include <stdlib.h>
+#include "fake.h"
+#include "hpm_lobs_drv.h"
+#include "hpm_csr_drv.h"
+#include "lobs_convert.h"
+#include "sampling.h"
+
+LOBS_Type g_fake_lobs;
+uint32_t hpm_core_clock = FAKE_CORE_CLOCK;
+
+static const uint32_t *fake_records;
+static uint32_t fake_record_num;
+static uint32_t fake_record_next;
+static uint64_t fake_cycle;
+
+static void fake_lobs_check_unlocked(LOBS_Type *lobs, const char *what)
+{
+    if (lobs->locked) {
+        fprintf(stderr, "fake lobs: %s while locked\n", what);
+        exit(2);
+    }
+}
+
+static uint32_t *fake_lobs_memory(uint32_t addr)
+{
+    return (uint32_t *)(uintptr_t)addr;
+}
+
+void lobs_unlock(LOBS_Type *lobs)
+{
+    lobs->locked = false;
+}
+
+void lobs_lock(LOBS_Type *lobs)
+{
+    lobs->locked = true;
+}
+
+void lobs_deinit(LOBS_Type *lobs)
+{
+    fake_lobs_check_unlocked(lobs, "deinit");
+    memset(lobs, 0, sizeof(*lobs));
+}
+
+void lobs_ctrl_config(LOBS_Type *lobs, lobs_ctrl_config_t *config)
+{
+    fake_lobs_check_unlocked(lobs, "ctrl config");
+    if ((config->group_mode != lobs_one_group_128_bits) || (config->end_addr <= config->start_addr) ||
+        (((config->end_addr - config->start_addr) % (LOBS_RECORD_WORDS * 4)) != 0)) {
+        fprintf(stderr, "fake lobs: unsupported trace region %#x .. %#x\n", config->start_addr, config->end_addr);
+        exit(2);
+    }
+    lobs->ctrl = *config;
+}
+
+void lobs_state_config(LOBS_Type *lobs, lobs_state_index_t state, lobs_state_config_t *config)
+{
+    fake_lobs_check_unlocked(lobs, "state config");
+    lobs->state[state] = *config;
+}
+
+void lobs_set_pre_trig_enable(LOBS_Type *lobs, bool enable)
+{
+    fake_lobs_check_unlocked(lobs, "pre trigger enable");
+    lobs->pre_trig = enable;
+}
+
+void lobs_set_state_enable(LOBS_Type *lobs, lobs_state_index_t state, bool enable)
+{
+    fake_lobs_check_unlocked(lobs, "state enable");
+    lobs->state_enable[state] = enable;
+}
+
+void lobs_set_enable(LOBS_Type *lobs, bool enable)
+{
+    fake_lobs_check_unlocked(lobs, "enable");
+    if (enable && !lobs->enable) {
+        lobs->finish = false;
+        lobs->current = 0;
+        lobs->counter = 0;
+        lobs->header_count = 0;
+        lobs->write_addr = lobs->ctrl.start_addr;
+        lobs->final_addr = 0;
+    }
+    lobs->enable = enable;
+}
+
+bool lobs_is_trace_finish(LOBS_Type *lobs)
+{
+    return lobs->finish;
+}
+
+uint32_t lobs_get_final_address(LOBS_Type *lobs)
+{
+    return lobs->final_addr;
+}
+
+uint64_t hpm_csr_get_core_cycle(void)
+{
+    return fake_cycle;
+}
+
+uint64_t fake_core_cycle(void)
+{
+    return fake_cycle;
+}
+
+void fake_lobs_source(const uint32_t *records, uint32_t record_num)
+{
+    fake_records = records;
+    fake_record_num = record_num;
+    fake_record_next = 0;
+}
+
+static bool fake_lobs_matched(LOBS_Type *lobs, const lobs_state_config_t *state, uint32_t pins)
+{
+    bool sig = true;
+    bool cnt;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        if (state->cmp_sig_en[i] && (((pins >> state->cmp_sig_bit[i]) & 1U) != state->cmp_golden_value[i])) {
+            sig = false;
+        }
+    }
+    cnt = (++lobs->counter >= state->cmp_counter);
+    switch (state->state_chg_condition) {
+    case lobs_cnt_matched:
+        return cnt;
+    case lobs_sig_matched:
+        return sig;
+    case lobs_cnt_or_sig_matched:
+        return cnt || sig;
+    default:
+        return cnt && sig;
+    }
+}
+
+static void fake_lobs_record(LOBS_Type *lobs)
+{
+    uint32_t *record = fake_lobs_memory(lobs->write_addr);
+    const uint32_t *source = &fake_records[fake_record_next * LOBS_RECORD_WORDS];
+    const lobs_state_config_t *state = &lobs->state[lobs->current];
+    uint32_t pins;
+
+    record[0] = lobs->header_count++;
+    record[1] = source[1];
+    record[2] = source[2];
+    record[3] = source[3];
+    pins = lobs_convert_pins(&record[1]);
+    if (++fake_record_next == fake_record_num) {
+        fake_record_next = 0;
+    }
+    lobs->write_addr += LOBS_RECORD_WORDS * 4;
+    if (lobs->write_addr == lobs->ctrl.end_addr) {
+        lobs->write_addr = lobs->ctrl.start_addr;
+        if (!lobs->pre_trig) {
+            /* without pre-trigger the region is filled once */
+            lobs->finish = true;
+            lobs->final_addr = lobs->ctrl.end_addr;
+            return;
+        }
+    }
+    if (!lobs->state_enable[lobs->current] || !fake_lobs_matched(lobs, state, pins)) {
+        return;
+    }
+    lobs->counter = 0;
+    if (state->next_state == lobs_next_state_finish) {
+        lobs->finish = true;
+        lobs->final_addr = (lobs->write_addr == lobs->ctrl.start_addr) ? lobs->ctrl.end_addr : lobs->write_addr;
+        return;
+    }
+    lobs->current = (uint8_t)__builtin_ctz(state->next_state);
+}
+
+/* let periods LOBS sample periods pass, recording while the trace runs */
+void fake_lobs_run(uint32_t periods)
+{
+    LOBS_Type *lobs = &g_fake_lobs;
+    uint32_t div = (uint32_t)lobs->ctrl.sample_rate + 1;
+
+    fake_cycle += (uint64_t)periods * div * hpm_core_clock / SAMPLING_LOBS_FREQ;
+    for (uint32_t i = 0; i < periods; i++) {
+        if (!lobs->enable || lobs->finish || (fake_record_num == 0)) {
+            break;
+        }
+        fake_lobs_record(lobs);
+    }
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * In-memory CherryUSB device: the host takes at most a budget of IN bytes
+ * per pass of the main loop and completes transfers in the order they were
+ * started, bulk OUT data is handed to the endpoint the firmware armed with
+ * usbd_ep_start_read(). The IN data is read when the transfer completes, as
+ * the controller would, so a buffer reused too early shows up in the output.
+ */
+
+#include <stdlib.h>
+#include "fake.h"
+#include "usbd_core.h"
+#include "usbd_cdc_acm.h"
+
+#define FAKE_USBD_EP_NUM (16U)
+
+typedef struct {
+    usbd_endpoint_callback cb;
+    const uint8_t *data;   /* IN: transfer on the bus, OUT: armed buffer */
+    uint32_t len;
+    uint32_t sent;
+    uint32_t order;        /* IN: start order, the oldest completes first */
+    bool busy;
+} fake_usbd_ep_t;
+
+static fake_usbd_ep_t g_fake_in[FAKE_USBD_EP_NUM];
+static fake_usbd_ep_t g_fake_out[FAKE_USBD_EP_NUM];
+static usbd_event_handler_t g_fake_event_handler;
+static fake_usbd_sink_t g_fake_sink;
+static uint32_t g_fake_order;
+
+void usbd_desc_register(uint8_t busid, const struct usb_descriptor *desc)
+{
+    (void)busid;
+    (void)desc;
+}
+
+void usbd_add_interface(uint8_t busid, struct usbd_interface *intf)
+{
+    (void)busid;
+    (void)intf;
+}
+
+struct usbd_interface *usbd_cdc_acm_init_intf(uint8_t busid, struct usbd_interface *intf)
+{
+    (void)busid;
+    return intf;
+}
+
+void usbd_add_endpoint(uint8_t busid, struct usbd_endpoint *ep)
+{
+    (void)busid;
+    if (ep->ep_addr & 0x80) {
+        g_fake_in[ep->ep_addr & 0x0F].cb = ep->ep_cb;
+    } else {
+        g_fake_out[ep->ep_addr & 0x0F].cb = ep->ep_cb;
+    }
+}
+
+int usbd_initialize(uint8_t busid, uint32_t reg_base, usbd_event_handler_t event_handler)
+{
+    (void)busid;
+    (void)reg_base;
+    g_fake_event_handler = event_handler;
+    return 0;
+}
+
+uint16_t usbd_get_ep_mps(uint8_t busid, uint8_t ep)
+{
+    (void)busid;
+    (void)ep;
+    return USB_BULK_EP_MPS_HS;
+}
+
+int usbd_ep_start_write(uint8_t busid, uint8_t ep, const uint8_t *data, uint32_t data_len)
+{
+    fake_usbd_ep_t *in = &g_fake_in[ep & 0x0F];
+
+    (void)busid;
+    if (in->busy) {
+        fprintf(stderr, "fake usbd: write on ep %02x while a transfer is on the bus\n", ep);
+        exit(2);
+    }
+    in->data = data;
+    in->len = data_len;
+    in->sent = 0;
+    in->order = g_fake_order++;
+    in->busy = true;
+    return 0;
+}
+
+int usbd_ep_start_read(uint8_t busid, uint8_t ep, uint8_t *data, uint32_t data_len)
+{
+    fake_usbd_ep_t *out = &g_fake_out[ep & 0x0F];
+
+    (void)busid;
+    out->data = data;
+    out->len = data_len;
+    out->busy = true;
+    return 0;
+}
+
+void fake_usbd_set_sink(fake_usbd_sink_t sink)
+{
+    g_fake_sink = sink;
+}
+
+void fake_usbd_event(uint8_t event)
+{
+    if (g_fake_event_handler != NULL) {
+        g_fake_event_handler(0, event);
+    }
+}
+
+/* one OUT transfer, false if the firmware has not armed the endpoint or the data does not fit */
+bool fake_usbd_out(uint8_t ep, const uint8_t *data, uint32_t len)
+{
+    fake_usbd_ep_t *out = &g_fake_out[ep & 0x0F];
+
+    if (!out->busy || (len > out->len) || (out->cb == NULL)) {
+        return false;
+    }
+    out->busy = false;
+    memcpy((uint8_t *)out->data, data, len);
+    out->cb(0, ep, len);
+    return true;
+}
+
+static fake_usbd_ep_t *fake_usbd_oldest(void)
+{
+    fake_usbd_ep_t *oldest = NULL;
+
+    for (uint8_t i = 0; i < FAKE_USBD_EP_NUM; i++) {
+        if (g_fake_in[i].busy && ((oldest == NULL) || ((int32_t)(g_fake_in[i].order - oldest->order) < 0))) {
+            oldest = &g_fake_in[i];
+        }
+    }
+    return oldest;
+}
+
+/* the host takes up to budget IN bytes, 0 for no limit, completions may start the next transfer */
+void fake_usbd_run(uint32_t budget)
+{
+    bool limited = (budget != 0);
+    fake_usbd_ep_t *in;
+    uint32_t take;
+    uint8_t ep;
+
+    while ((in = fake_usbd_oldest()) != NULL) {
+        take = in->len - in->sent;
+        if (limited && (take > budget)) {
+            in->sent += budget;
+            return;
+        }
+        if (limited) {
+            budget -= take;
+        }
+        ep = (uint8_t)(0x80 | (in - g_fake_in));
+        in->busy = false;
+        if ((g_fake_sink != NULL) && (in->len != 0)) {
+            g_fake_sink(ep, in->data, in->len);
+        }
+        if (in->cb != NULL) {
+            in->cb(0, ep, in->len);
+        }
+    }
+}
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host replay of a SUMP session through the unchanged sump.c, sampling.c,
+ * lobs_convert.c and cdc_acm.c. LOBS records a trace dump (see lobs_decode.c
+ * for the format) over and over, the bytes the firmware uploads on its IN
+ * endpoints are compared with a golden file next to the script.
+ *
+ * usage: sump_replay [-u] [-v] <case.sump>
+ *   -u  write the golden file instead of comparing with it
+ *   -v  keep the firmware console output
+ *
+ * A script is one command per line, # starts a comment:
+ *   trace <dump>    records LOBS writes, path relative to the script
+ *   records <n>     LOBS sample periods per main loop pass (default 1024)
+ *   usb <bytes>     IN bytes the host takes per pass, 0 for no limit (default 0)
+ *   send <hex> ..   one OUT transfer on the CDC port, e.g. send 81 ff 00 ff 00, then a
+ *                   lobs_loop() pass serves what it requested before LOBS records again
+ *   poll <n>        n main loop passes: LOBS records, lobs_loop(), the host takes IN data
+ * The golden file is the script name with .out for .sump.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "fake.h"
+#include "usbd_core.h"
+#include "cdc_acm.h"
+#include "sampling.h"
+#include "lobs_convert.h"
+
+extern uint32_t lobs_buffer[];
+extern void cdc_acm_init(uint8_t busid, uint32_t reg_base);
+
+#define REPLAY_LINE_MAX (512)
+
+static uint8_t *replay_output;
+static uint32_t replay_output_len;
+static uint32_t replay_output_size;
+static uint32_t *replay_records;
+
+static void replay_sink(uint8_t ep, const uint8_t *data, uint32_t len)
+{
+    (void)ep;
+    if (replay_output_len + len > replay_output_size) {
+        replay_output_size = (replay_output_len + len) * 2;
+        replay_output = realloc(replay_output, replay_output_size);
+        if (replay_output == NULL) {
+            perror("output");
+            exit(2);
+        }
+    }
+    memcpy(&replay_output[replay_output_len], data, len);
+    replay_output_len += len;
+}
+
+static uint8_t *read_file(const char *path, uint32_t *len)
+{
+    uint8_t *data;
+    long size;
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data = malloc((size > 0) ? (size_t)size : 1);
+    if ((data == NULL) || (fread(data, 1, (size_t)size, file) != (size_t)size)) {
+        fclose(file);
+        free(data);
+        return NULL;
+    }
+    fclose(file);
+    *len = (uint32_t)size;
+    return data;
+}
+
+static int replay_trace(const char *dir, const char *name)
+{
+    char path[REPLAY_LINE_MAX * 2];
+    uint32_t len;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    free(replay_records);
+    replay_records = (uint32_t *)read_file(path, &len);
+    if ((replay_records == NULL) || (len < LOBS_RECORD_WORDS * 4)) {
+        fprintf(stderr, "%s: no complete records\n", path);
+        return 1;
+    }
+    fake_lobs_source(replay_records, len / (LOBS_RECORD_WORDS * 4));
+    return 0;
+}
+
+static int replay_send(char *args)
+{
+    uint8_t data[64];
+    uint32_t len = 0;
+    char *end;
+
+    for (char *hex = strtok(args, " \t"); hex != NULL; hex = strtok(NULL, " \t")) {
+        unsigned long value = strtoul(hex, &end, 16);
+        if ((*end != '\0') || (value > 0xFF) || (len == sizeof(data))) {
+            return 1;
+        }
+        data[len++] = (uint8_t)value;
+    }
+    if ((len == 0) || !fake_usbd_out(CDC_OUT_EP, data, len)) {
+        return 1;
+    }
+    lobs_loop();
+    return 0;
+}
+
+static int replay_script(const char *script)
+{
+    char dir[REPLAY_LINE_MAX];
+    char line[REPLAY_LINE_MAX];
+    uint32_t records = 1024;
+    uint32_t budget = 0;
+    uint32_t number = 0;
+    char *slash;
+    char *command;
+    char *args;
+    FILE *file = fopen(script, "r");
+
+    if (file == NULL) {
+        perror(script);
+        return 1;
+    }
+    snprintf(dir, sizeof(dir), "%s", script);
+    slash = strrchr(dir, '/');
+    if (slash != NULL) {
+        *slash = '\0';
+    } else {
+        snprintf(dir, sizeof(dir), ".");
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        int error = 0;
+
+        number++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        command = strtok(line, " \t");
+        if (command == NULL) {
+            continue;
+        }
+        args = strtok(NULL, "");
+        if (strcmp(command, "trace") == 0) {
+            error = (args == NULL) || replay_trace(dir, strtok(args, " \t"));
+        } else if (strcmp(command, "records") == 0) {
+            records = (args != NULL) ? strtoul(args, NULL, 0) : 0;
+            error = (records == 0);
+        } else if (strcmp(command, "usb") == 0) {
+            error = (args == NULL);
+            budget = error ? 0 : strtoul(args, NULL, 0);
+        } else if (strcmp(command, "send") == 0) {
+            error = (args == NULL) || replay_send(args);
+        } else if (strcmp(command, "poll") == 0) {
+            uint32_t passes = (args != NULL) ? strtoul(args, NULL, 0) : 0;
+            for (uint32_t i = 0; i < passes; i++) {
+                fake_lobs_run(records);
+                lobs_loop();
+                fake_usbd_run(budget);
+            }
+            error = (passes == 0);
+        } else {
+            error = 1;
+        }
+        if (error) {
+            fprintf(stderr, "%s:%u: bad line\n", script, number);
+            fclose(file);
+            return 1;
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+static int replay_golden(const char *script, int update)
+{
+    char path[REPLAY_LINE_MAX];
+    const char *dot = strrchr(script, '.');
+    uint8_t *golden;
+    uint32_t len = 0;
+    FILE *file;
+
+    snprintf(path, sizeof(path), "%.*s.out", (int)((dot != NULL) ? (dot - script) : (long)strlen(script)), script);
+    if (update) {
+        file = fopen(path, "wb");
+        if ((file == NULL) || (fwrite(replay_output, 1, replay_output_len, file) != replay_output_len)) {
+            perror(path);
+            return 1;
+        }
+        fclose(file);
+        fprintf(stderr, "%s: %u bytes written\n", path, replay_output_len);
+        return 0;
+    }
+    golden = read_file(path, &len);
+    if (golden == NULL) {
+        perror(path);
+        return 1;
+    }
+    for (uint32_t i = 0; (i < len) && (i < replay_output_len); i++) {
+        if (golden[i] != replay_output[i]) {
+            fprintf(stderr, "%s: byte %u is %02x, golden %02x\n", script, i, replay_output[i], golden[i]);
+            free(golden);
+            return 1;
+        }
+    }
+    free(golden);
+    if (len != replay_output_len) {
+        fprintf(stderr, "%s: %u bytes uploaded, golden %u\n", script, replay_output_len, len);
+        return 1;
+    }
+    fprintf(stderr, "%s: %u bytes match\n", script, len);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int update = 0;
+    int verbose = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "uv")) != -1) {
+        switch (opt) {
+        case 'u':
+            update = 1;
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if (optind + 1 != argc) {
+        fprintf(stderr, "usage: %s [-u] [-v] <case.sump>\n", argv[0]);
+        return 2;
+    }
+    /* sampling.c hands LOBS 32 bit addresses of the trace memory */
+    if ((uintptr_t)&lobs_buffer[TRACE_CNT * 4] > UINT32_MAX) {
+        fprintf(stderr, "trace memory above 4 GiB, build without pie\n");
+        return 2;
+    }
+    if (!verbose && (freopen("/dev/null", "w", stdout) == NULL)) {
+        return 2;
+    }
+
+    fake_usbd_set_sink(replay_sink);
+    cdc_acm_init(0, 0);
+    fake_usbd_event(USBD_EVENT_CONFIGURED);
+    init_lobs_one_group_config();
+
+    if (replay_script(argv[optind])) {
+        return 2;
+    }
+    return replay_golden(argv[optind], update);
+}
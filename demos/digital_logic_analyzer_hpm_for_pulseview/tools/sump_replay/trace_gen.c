@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2024 RCSN
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Writes the trace dumps in traces/, LOBS records as lobs_decode.c reads
+ * them. The d0 and oe bits are filled with noise so a conversion that picks
+ * up the wrong bits shows in the golden files.
+ *   counter.bin  each probe group counts at its own step, every sample differs
+ *   pwm.bin      probe 0 toggles every 4 records, probe 1 every 50, probe 2 is
+ *                high for records 300 .. 339, probes 8 .. 15 count every 128
+ *                records, 16 .. 23 stay 0xa5, 24 toggles every 200 and 31 is high
+ *   prime.bin    counter.bin over 1021 records, so decimations that are a multiple
+ *                of the 1024 record traces still see the samples change
+ *
+ * build: cc -O2 -I../../inc -o trace_gen trace_gen.c
+ * usage: trace_gen <directory>
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "lobs_convert.h"
+
+#define TRACE_GEN_RECORDS (1024)
+
+static uint32_t xorshift_state = 1;
+
+static uint32_t xorshift32(void)
+{
+    uint32_t x = xorshift_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    xorshift_state = x;
+    return x;
+}
+
+static void put_record(uint32_t *record, uint32_t index, uint32_t pins)
+{
+    record[0] = index;
+    /* the di bits of the three data words are every third bit from bit 2, 0 and 1 */
+    record[1] = xorshift32() & ~0x24924924UL;
+    record[2] = xorshift32() & ~0x49249249UL;
+    record[3] = xorshift32() & ~0x92492492UL;
+    for (uint32_t pin = 0; pin < 32; pin++) {
+        uint32_t bit = pin * 3 + 2;
+        record[1 + bit / 32] |= ((pins >> pin) & 1U) << (bit % 32);
+    }
+}
+
+static uint32_t counter_pins(uint32_t i)
+{
+    return (i & 0xFF) | (((i * 3) & 0xFF) << 8) | (((i * 5) & 0xFF) << 16) | (((i * 7) & 0xFF) << 24);
+}
+
+static uint32_t pwm_pins(uint32_t i)
+{
+    uint32_t pins = 0;
+
+    pins |= ((i / 4) & 1U) << 0;
+    pins |= ((i / 50) & 1U) << 1;
+    pins |= ((i >= 300) && (i < 340)) ? (1UL << 2) : 0;
+    pins |= ((i / 128) & 0xFF) << 8;
+    pins |= 0xA5UL << 16;
+    pins |= ((i / 200) & 1U) << 24;
+    pins |= 1UL << 31;
+    return pins;
+}
+
+static int write_trace(const char *dir, const char *name, uint32_t (*pins)(uint32_t), uint32_t num)
+{
+    static uint32_t records[TRACE_GEN_RECORDS * LOBS_RECORD_WORDS];
+    char path[512];
+    FILE *file;
+
+    for (uint32_t i = 0; i < num; i++) {
+        put_record(&records[i * LOBS_RECORD_WORDS], i, pins(i));
+    }
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    file = fopen(path, "wb");
+    if ((file == NULL) || (fwrite(records, num * LOBS_RECORD_WORDS * sizeof(uint32_t), 1, file) != 1)) {
+        perror(path);
+        return 1;
+    }
+    fclose(file);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <directory>\n", argv[0]);
+        return 2;
+    }
+    if (write_trace(argv[1], "counter.bin", counter_pins, TRACE_GEN_RECORDS) ||
+        write_trace(argv[1], "pwm.bin", pwm_pins, TRACE_GEN_RECORDS) ||
+        write_trace(argv[1], "prime.bin", counter_pins, 1021)) {
+        return 1;
+    }
+    return 0;
+}